@@ -17,17 +17,259 @@
 #pragma once
 
 #include <amp.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <ppl.h>
 #include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanLookBack.h"
 #include "ScanTiled.h"
 
+//===============================================================================
+//  Stream compaction: copy_if, remove_if and partition.
+//
+//  Each element's predicate gives a flag of 0 or 1. The exclusive scan of the 
+//  flags is each selected element's position in the output, so the elements are
+//  scattered there. 
+//
+//  On the CPU each worker flags a block of elements, counts them and uses the 
+//  decoupled look-back in ScanLookBack.h to find how many elements were selected
+//  by all the earlier blocks. It then scatters its block while the input is still
+//  in cache. The order of the elements is kept. The unstable variant reserves 
+//  each block's output with an atomic counter instead, so blocks don't wait for
+//  each other, but the blocks' outputs may be in any order.
+//
+//  On an accelerator the flags are scanned with ExclusiveScanTiled and the 
+//  selected elements scattered by a second kernel.
+//===============================================================================
+
 namespace Extras
 {
+    //===============================================================================
+    //  Copy the elements for which pred is true to outFirst, keeping their order.
+    //  Returns the end of the output.
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename OutIt, typename Pred>
+    inline OutIt CopyIf(InIt first, InIt last, OutIt outFirst, Pred pred)
+    {
+        return outFirst + details::Compact<BlockSize>(first, last, outFirst, pred);
+    }
+
+    //  As CopyIf but the elements from different blocks may be in any order.
+
+    template <int BlockSize, typename InIt, typename OutIt, typename Pred>
+    inline OutIt UnstableCopyIf(InIt first, InIt last, OutIt outFirst, Pred pred)
+    {
+        return outFirst + details::UnstableCompact<BlockSize>(first, last, outFirst, pred);
+    }
+
+    //===============================================================================
+    //  Copy the elements for which pred is false, keeping their order.
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename OutIt, typename Pred>
+    inline OutIt RemoveCopyIf(InIt first, InIt last, OutIt outFirst, Pred pred)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        return CopyIf<BlockSize>(first, last, outFirst, [&pred](const T& value) { return !pred(value); });
+    }
+
+    //  Remove the elements for which pred is true, keeping the order of the others.
+    //  Returns the new end of the range. Compacts into a temporary copy.
+
+    template <int BlockSize, typename FwdIt, typename Pred>
+    inline FwdIt RemoveIf(FwdIt first, FwdIt last, Pred pred)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        if (first == last)
+            return last;
+        std::vector<T> kept(std::distance(first, last));
+        const auto keptEnd = RemoveCopyIf<BlockSize>(first, last, kept.begin(), pred);
+        return std::copy(kept.begin(), keptEnd, first);
+    }
+
+    //===============================================================================
+    //  Copy the elements for which pred is true to outTrue and the others to 
+    //  outFalse, keeping their order. Returns the ends of both outputs.
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename OutIt1, typename OutIt2, typename Pred>
+    inline std::pair<OutIt1, OutIt2> PartitionCopy(InIt first, InIt last, OutIt1 outTrue, OutIt2 outFalse, Pred pred)
+    {
+        const int trueCount = details::Compact<BlockSize>(first, last, outTrue, outFalse, pred);
+        return std::make_pair(outTrue + trueCount, outFalse + (int(std::distance(first, last)) - trueCount));
+    }
+
+    //  Move the elements for which pred is true before the others, keeping the order
+    //  within both groups. Returns the start of the second group. Partitions into a 
+    //  temporary copy, filling it from the front with the first group and from the
+    //  back with the second.
+
+    template <int BlockSize, typename FwdIt, typename Pred>
+    inline FwdIt StablePartition(FwdIt first, FwdIt last, Pred pred)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        if (first == last)
+            return last;
+        std::vector<T> partitioned(std::distance(first, last));
+        const auto ends = PartitionCopy<BlockSize>(first, last, partitioned.begin(), partitioned.rbegin(), pred);
+        const FwdIt middle = std::copy(partitioned.begin(), ends.first, first);
+        std::copy(partitioned.rbegin(), ends.second, middle);
+        return middle;
+    }
+
+    //===============================================================================
+    //  Copy the elements of input for which pred, which must be restrict(amp), is 
+    //  true to the start of output, keeping their order. Returns the number copied.
+    //===============================================================================
+
+    template <int TileSize, typename T, typename Pred>
+    inline int CopyIfTiled(concurrency::array_view<const T, 1> input, concurrency::array_view<T, 1> output, Pred pred)
+    {
+        return details::Compact<TileSize>(input, output, pred);
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
     namespace details
     {
-        template <typename T>
-        void Compact(concurrency::array_view<T, 1> data)
+        //  Flags a block and returns the number of elements selected.
+
+        template <typename InIt, typename Pred>
+        int FlagBlock(InIt first, int count, unsigned char* flags, Pred& pred)
+        {
+            int selected = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                flags[i] = pred(first[i]) ? 1 : 0;
+                selected += flags[i];
+            }
+            return selected;
+        }
+
+        //  Scatter a flagged block, selected elements to outTrue and the others to outFalse.
+
+        template <typename InIt, typename OutIt1, typename OutIt2>
+        void ScatterBlock(InIt first, int count, const unsigned char* flags, OutIt1 outTrue, OutIt2 outFalse)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                if (flags[i])
+                    *outTrue++ = first[i];
+                else
+                    *outFalse++ = first[i];
+            }
+        }
+
+        //  Discards the unselected elements.
+
+        struct NullOutputIterator
+        {
+            NullOutputIterator& operator*() { return *this; }
+            NullOutputIterator& operator++() { return *this; }
+            NullOutputIterator operator++(int) { return *this; }
+            template <typename T>
+            NullOutputIterator& operator=(const T&) { return *this; }
+            NullOutputIterator operator+(int) const { return *this; }
+        };
+
+        //  Returns the number of elements for which pred is true. The others are written
+        //  to outFalse, which may be a NullOutputIterator.
+
+        template <int BlockSize, typename InIt, typename OutIt1, typename OutIt2, typename Pred>
+        int Compact(InIt first, InIt last, OutIt1 outTrue, OutIt2 outFalse, Pred pred)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int elementCount = int(std::distance(first, last));
+            if (elementCount == 0)
+                return 0;
+
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            std::atomic<int> trueCount(0);
+            LookBackBlocks<int>(blockCount, SumOp<int>(), [&](int b, const LookBackPublisher<int, SumOp<int>>& publish)
+            {
+                const int blockStart = b * BlockSize;
+                const int count = (std::min)(BlockSize, elementCount - blockStart);
+
+                unsigned char flags[BlockSize];
+                Pred blockPred(pred);
+                const int selected = FlagBlock(first + blockStart, count, flags, blockPred);
+                const int truePrefix = publish(selected);
+                ScatterBlock(first + blockStart, count, flags, outTrue + truePrefix, outFalse + (blockStart - truePrefix));
+                if (b == (blockCount - 1))
+                    trueCount = truePrefix + selected;
+            });
+            return trueCount;
+        }
+
+        template <int BlockSize, typename InIt, typename OutIt, typename Pred>
+        int Compact(InIt first, InIt last, OutIt outFirst, Pred pred)
         {
-            assert(data.extent[0] > 0);
+            return Compact<BlockSize>(first, last, outFirst, NullOutputIterator(), pred);
+        }
+
+        template <int BlockSize, typename InIt, typename OutIt, typename Pred>
+        int UnstableCompact(InIt first, InIt last, OutIt outFirst, Pred pred)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int elementCount = int(std::distance(first, last));
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            std::atomic<int> nextOutput(0);
+            concurrency::parallel_for(0, blockCount, [&](int b)
+            {
+                const int blockStart = b * BlockSize;
+                const int count = (std::min)(BlockSize, elementCount - blockStart);
+
+                unsigned char flags[BlockSize];
+                Pred blockPred(pred);
+                const int selected = FlagBlock(first + blockStart, count, flags, blockPred);
+                const int outputStart = nextOutput.fetch_add(selected);
+                ScatterBlock(first + blockStart, count, flags, outFirst + outputStart, NullOutputIterator());
+            });
+            return nextOutput;
+        }
+
+        //  The flags are padded with zeros to a whole number of tiles for ExclusiveScanTiled.
+
+        template <int TileSize, typename T, typename Pred>
+        int Compact(concurrency::array_view<const T, 1> input, concurrency::array_view<T, 1> output, Pred pred)
+        {
+            const int elementCount = input.extent[0];
+            assert(elementCount > 0);
+            assert(output.extent[0] >= elementCount);
+
+            const int paddedCount = ((elementCount + TileSize - 1) / TileSize) * TileSize;
+            concurrency::array<int, 1> flags(paddedCount);
+            concurrency::array<int, 1> positions(paddedCount);
+            concurrency::array_view<int, 1> flagsView(flags);
+            concurrency::array_view<int, 1> positionsView(positions);
+
+            flagsView.discard_data();
+            concurrency::parallel_for_each(flagsView.extent, [=](concurrency::index<1> idx) restrict(amp)
+            {
+                flagsView[idx] = ((idx[0] < elementCount) && pred(input[idx])) ? 1 : 0;
+            });
+            ExclusiveScanTiled<TileSize>(flagsView, positionsView);
+
+            concurrency::parallel_for_each(input.extent, [=](concurrency::index<1> idx) restrict(amp)
+            {
+                if (flagsView[idx] != 0)
+                    output[positionsView[idx]] = input[idx];
+            });
+            const int last = elementCount - 1;
+            return positionsView[last] + flagsView[last];
         }
     }
-}
\ No newline at end of file
+}
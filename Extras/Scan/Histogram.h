@@ -0,0 +1,111 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+#include <ppl.h>
+#include <assert.h>
+
+//===============================================================================
+//  Histogram running on CPU threads.
+//
+//  Each worker thread claims blocks of BlockSize elements and counts them into 
+//  its own private bins, so workers never write to the same counters. The 
+//  workers' bins are then merged by summing them, one range of bins per thread.
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    //  Count the elements falling into each of binCount bins. binOf(element) returns
+    //  the bin of an element, which must be in [0, binCount). The counts are written 
+    //  to countsFirst.
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename BinFunc, typename OutIt>
+    inline void Histogram(InIt first, InIt last, int binCount, BinFunc binOf, OutIt countsFirst)
+    {
+        details::Histogram<BlockSize>(first, last, binCount, binOf, countsFirst);
+    }
+
+    //  Elements are their own bin, for example 8-bit pixels into 256 bins.
+
+    template <int BlockSize, typename InIt, typename OutIt>
+    inline void Histogram(InIt first, InIt last, int binCount, OutIt countsFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        details::Histogram<BlockSize>(first, last, binCount, [](const T& value) { return int(value); }, countsFirst);
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        template <int BlockSize, typename InIt, typename BinFunc, typename OutIt>
+        void Histogram(InIt first, InIt last, int binCount, BinFunc binOf, OutIt countsFirst)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+            assert(binCount > 0);
+
+            const int elementCount = int(std::distance(first, last));
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            const int workerCount = (std::max)(1, (std::min)(blockCount, int(concurrency::GetProcessorCount())));
+
+            std::vector<std::vector<int>> workerBins(workerCount);
+            std::atomic<int> nextBlock(0);
+            concurrency::parallel_for(0, workerCount, [&](int w)
+            {
+                std::vector<int>& bins = workerBins[w];
+                bins.assign(binCount, 0);
+                BinFunc workerBinOf(binOf);
+                for (int b = nextBlock++; b < blockCount; b = nextBlock++)
+                {
+                    const int blockStart = b * BlockSize;
+                    const int blockEnd = (std::min)(blockStart + BlockSize, elementCount);
+                    for (InIt it = first + blockStart; it != first + blockEnd; ++it)
+                    {
+                        const int bin = workerBinOf(*it);
+                        assert((bin >= 0) && (bin < binCount));
+                        ++bins[bin];
+                    }
+                }
+            });
+
+            //  Merge the workers' bins, each thread summing a range of bins.
+
+            const int rangeCount = (std::min)(binCount, workerCount);
+            concurrency::parallel_for(0, rangeCount, [&](int r)
+            {
+                const int binStart = int((long long)(binCount) * r / rangeCount);
+                const int binEnd = int((long long)(binCount) * (r + 1) / rangeCount);
+                for (int bin = binStart; bin < binEnd; ++bin)
+                {
+                    int count = 0;
+                    for (int w = 0; w < workerCount; ++w)
+                        count += workerBins[w][bin];
+                    countsFirst[bin] = count;
+                }
+            });
+        }
+    }
+}
@@ -0,0 +1,253 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include <ppl.h>
+#include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanLookBack.h"
+
+//===============================================================================
+//  Least significant digit radix sort running on CPU threads.
+//
+//  Keys are sorted eight bits at a time, starting with the lowest digit. Each pass
+//  splits the input into blocks of BlockSize elements and counts the digits in 
+//  every block in parallel. The counts are stored digit-major, all the blocks' 
+//  counts for digit 0 followed by those for digit 1 and so on, so an exclusive 
+//  scan of them gives the first output position of each digit in each block. The
+//  blocks then scatter their elements to those positions, in order, which keeps
+//  each pass stable. Passes where every key has the same digit are skipped.
+//
+//  Signed integers and floating point keys are mapped to unsigned integers that
+//  sort in the same order. Floating point keys must not be NaN and -0.0 sorts
+//  before 0.0.
+//
+//  The range must be contiguous, the sort alternates between it and a temporary
+//  buffer of the same size.
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    //  Sort 32 or 64-bit keys in ascending order.
+    //===============================================================================
+
+    template <int BlockSize, typename RandIt>
+    inline void RadixSort(RandIt first, RandIt last)
+    {
+        if (first == last)
+            return;
+        details::RadixSort<BlockSize>(&*first, static_cast<details::NoRadixValue*>(nullptr), int(last - first));
+    }
+
+    //===============================================================================
+    //  Sort keys in ascending order, moving the values with them. Keys which are equal
+    //  keep the order of their values.
+    //===============================================================================
+
+    template <int BlockSize, typename KeyIt, typename ValueIt>
+    inline void RadixSortByKey(KeyIt keysFirst, KeyIt keysLast, ValueIt valuesFirst)
+    {
+        if (keysFirst == keysLast)
+            return;
+        details::RadixSort<BlockSize>(&*keysFirst, &*valuesFirst, int(keysLast - keysFirst));
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        //  Maps each key type to an unsigned integer type with the same ordering.
+
+        template <typename K>
+        struct RadixKey
+        {
+        };
+
+        template <>
+        struct RadixKey<unsigned int>
+        {
+            typedef unsigned int Bits;
+            static inline Bits ToBits(unsigned int key) { return key; }
+        };
+
+        template <>
+        struct RadixKey<int>
+        {
+            typedef unsigned int Bits;
+            static inline Bits ToBits(int key) { return static_cast<unsigned int>(key) ^ 0x80000000u; }
+        };
+
+        //  Negative floats are ordered by their inverted bits, positive ones by setting
+        //  the sign bit.
+
+        template <>
+        struct RadixKey<float>
+        {
+            typedef unsigned int Bits;
+            static inline Bits ToBits(float key)
+            {
+                Bits bits;
+                memcpy(&bits, &key, sizeof(bits));
+                return bits ^ ((bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u);
+            }
+        };
+
+        template <>
+        struct RadixKey<unsigned long long>
+        {
+            typedef unsigned long long Bits;
+            static inline Bits ToBits(unsigned long long key) { return key; }
+        };
+
+        template <>
+        struct RadixKey<long long>
+        {
+            typedef unsigned long long Bits;
+            static inline Bits ToBits(long long key) { return static_cast<unsigned long long>(key) ^ 0x8000000000000000ull; }
+        };
+
+        template <>
+        struct RadixKey<double>
+        {
+            typedef unsigned long long Bits;
+            static inline Bits ToBits(double key)
+            {
+                Bits bits;
+                memcpy(&bits, &key, sizeof(bits));
+                return bits ^ ((bits & 0x8000000000000000ull) ? 0xFFFFFFFFFFFFFFFFull : 0x8000000000000000ull);
+            }
+        };
+
+        enum 
+        { 
+            kRadixBits = 8, 
+            kRadixDigits = 1 << kRadixBits 
+        };
+
+        template <typename K>
+        inline int RadixDigit(const K& key, int shift)
+        {
+            return int((RadixKey<K>::ToBits(key) >> shift) & (kRadixDigits - 1));
+        }
+
+        //  Stands in for the values when only keys are sorted, moving one does nothing.
+
+        struct NoRadixValue
+        {
+        };
+
+        template <typename V>
+        inline void MoveRadixValue(const V* source, V* destination, int from, int to)
+        {
+            destination[to] = source[from];
+        }
+
+        inline void MoveRadixValue(const NoRadixValue*, NoRadixValue*, int, int)
+        {
+        }
+
+        template <typename V>
+        struct RadixValueBuffer
+        {
+            std::vector<V> m_values;
+            explicit RadixValueBuffer(int count) : m_values(count) { }
+            V* Data() { return m_values.data(); }
+        };
+
+        template <>
+        struct RadixValueBuffer<NoRadixValue>
+        {
+            explicit RadixValueBuffer(int) { }
+            NoRadixValue* Data() { return nullptr; }
+        };
+
+        template <int BlockSize, typename K, typename V>
+        void RadixSort(K* keys, V* values, int count)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+            assert(count > 0);
+
+            const int blockCount = (count + BlockSize - 1) / BlockSize;
+            std::vector<int> digitCounts(kRadixDigits * blockCount);
+            std::vector<int> digitOffsets(digitCounts.size());
+            std::vector<K> keysBuffer(count);
+            RadixValueBuffer<V> valuesBuffer(count);
+
+            K* sourceKeys = keys;
+            K* destinationKeys = keysBuffer.data();
+            V* sourceValues = values;
+            V* destinationValues = valuesBuffer.Data();
+
+            for (int shift = 0; shift < int(8 * sizeof(K)); shift += kRadixBits)
+            {
+                concurrency::parallel_for(0, blockCount, [=, &digitCounts](int b)
+                {
+                    const int blockStart = b * BlockSize;
+                    const int blockEnd = (std::min)(blockStart + BlockSize, count);
+                    int counts[kRadixDigits] = { 0 };
+                    for (int i = blockStart; i < blockEnd; ++i)
+                        ++counts[RadixDigit(sourceKeys[i], shift)];
+                    for (int d = 0; d < kRadixDigits; ++d)
+                        digitCounts[d * blockCount + b] = counts[d];
+                });
+
+                //  If every key has the same digit as the first then the order is unchanged.
+
+                const int firstDigit = RadixDigit(sourceKeys[0], shift);
+                const auto firstDigitCounts = digitCounts.cbegin() + firstDigit * blockCount;
+                if (std::accumulate(firstDigitCounts, firstDigitCounts + blockCount, 0) == count)
+                    continue;
+
+                ExclusiveScanLookBack<16 * 1024>(digitCounts.cbegin(), digitCounts.cend(), digitOffsets.begin());
+
+                concurrency::parallel_for(0, blockCount, [=, &digitOffsets](int b)
+                {
+                    const int blockStart = b * BlockSize;
+                    const int blockEnd = (std::min)(blockStart + BlockSize, count);
+                    int offsets[kRadixDigits];
+                    for (int d = 0; d < kRadixDigits; ++d)
+                        offsets[d] = digitOffsets[d * blockCount + b];
+                    for (int i = blockStart; i < blockEnd; ++i)
+                    {
+                        const int to = offsets[RadixDigit(sourceKeys[i], shift)]++;
+                        destinationKeys[to] = sourceKeys[i];
+                        MoveRadixValue(sourceValues, destinationValues, i, to);
+                    }
+                });
+                std::swap(sourceKeys, destinationKeys);
+                std::swap(sourceValues, destinationValues);
+            }
+
+            //  After an odd number of passes the sorted data is in the buffers.
+
+            if (sourceKeys != keys)
+            {
+                std::copy(sourceKeys, sourceKeys + count, keys);
+                if (values != nullptr)
+                    std::copy(sourceValues, sourceValues + count, values);
+            }
+        }
+    }
+}
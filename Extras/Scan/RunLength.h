@@ -0,0 +1,170 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+#include <ppl.h>
+#include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanLookBack.h"
+
+//===============================================================================
+//  Run-length encoding and decoding running on CPU threads.
+//
+//  Encoding flags the first element of each run, one that differs from the 
+//  element before it. The exclusive scan of the flags is each run's index, so the
+//  run's value and start are scattered there. Like CopyIf in Compact.h the flags
+//  are counted, scanned with the decoupled look-back and scattered in a single 
+//  pass. The lengths are then the differences between consecutive starts.
+//
+//  Decoding scans the lengths to find where each run starts in the output. The 
+//  output is then split into blocks and each block finds its first run with a 
+//  binary search and fills itself, so one long run is still filled in parallel.
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    //  Encode the input as runs of equal elements, writing each run's value to 
+    //  valuesFirst and its length to lengthsFirst. Returns the number of runs.
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename ValueIt, typename LengthIt>
+    inline int RunLengthEncode(InIt first, InIt last, ValueIt valuesFirst, LengthIt lengthsFirst)
+    {
+        return details::RunLengthEncode<BlockSize>(first, last, valuesFirst, lengthsFirst);
+    }
+
+    //===============================================================================
+    //  Decode runs, writing lengths[i] copies of values[i] for each run. Returns the
+    //  end of the output.
+    //===============================================================================
+
+    template <int BlockSize, typename ValueIt, typename LengthIt, typename OutIt>
+    inline OutIt RunLengthDecode(ValueIt valuesFirst, ValueIt valuesLast, LengthIt lengthsFirst, OutIt outFirst)
+    {
+        return outFirst + details::RunLengthDecode<BlockSize>(valuesFirst, valuesLast, lengthsFirst, outFirst);
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        template <int BlockSize, typename InIt, typename ValueIt, typename LengthIt>
+        int RunLengthEncode(InIt first, InIt last, ValueIt valuesFirst, LengthIt lengthsFirst)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int elementCount = int(std::distance(first, last));
+            if (elementCount == 0)
+                return 0;
+
+            //  Scatter each run's value and start, the start goes where its length will be.
+
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            std::atomic<int> runCount(0);
+            LookBackBlocks<int>(blockCount, SumOp<int>(), [&](int b, const LookBackPublisher<int, SumOp<int>>& publish)
+            {
+                const int blockStart = b * BlockSize;
+                const int count = (std::min)(BlockSize, elementCount - blockStart);
+                const InIt blockFirst = first + blockStart;
+
+                unsigned char heads[BlockSize];
+                int headCount = 0;
+                for (int i = 0; i < count; ++i)
+                {
+                    heads[i] = (((blockStart + i) == 0) || !(blockFirst[i] == blockFirst[i - 1])) ? 1 : 0;
+                    headCount += heads[i];
+                }
+
+                int run = publish(headCount);
+                for (int i = 0; i < count; ++i)
+                {
+                    if (heads[i])
+                    {
+                        valuesFirst[run] = blockFirst[i];
+                        lengthsFirst[run] = blockStart + i;
+                        ++run;
+                    }
+                }
+                if (b == (blockCount - 1))
+                    runCount = run;
+            });
+
+            //  Each run's length is the next run's start minus its own. The start following 
+            //  each block of runs is read first as another thread may be replacing it.
+
+            const int runs = runCount;
+            const int runBlockCount = (runs + BlockSize - 1) / BlockSize;
+            std::vector<int> nextBlockStarts(runBlockCount);
+            for (int b = 0; b < runBlockCount; ++b)
+            {
+                const int runEnd = (std::min)((b + 1) * BlockSize, runs);
+                nextBlockStarts[b] = (runEnd < runs) ? int(lengthsFirst[runEnd]) : elementCount;
+            }
+            concurrency::parallel_for(0, runBlockCount, [&](int b)
+            {
+                const int runStart = b * BlockSize;
+                const int runEnd = (std::min)(runStart + BlockSize, runs);
+                for (int r = runStart; r < runEnd; ++r)
+                {
+                    const int nextStart = ((r + 1) < runEnd) ? int(lengthsFirst[r + 1]) : nextBlockStarts[b];
+                    lengthsFirst[r] = nextStart - lengthsFirst[r];
+                }
+            });
+            return runs;
+        }
+
+        template <int BlockSize, typename ValueIt, typename LengthIt, typename OutIt>
+        int RunLengthDecode(ValueIt valuesFirst, ValueIt valuesLast, LengthIt lengthsFirst, OutIt outFirst)
+        {
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int runCount = int(std::distance(valuesFirst, valuesLast));
+            if (runCount == 0)
+                return 0;
+
+            //  The inclusive scan gives each run's end, the first run ending after a block's
+            //  start is the run the block starts in.
+
+            std::vector<int> runEnds(runCount);
+            InclusiveScanLookBack<16 * 1024>(lengthsFirst, lengthsFirst + runCount, runEnds.begin());
+            const int elementCount = runEnds.back();
+
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            concurrency::parallel_for(0, blockCount, [&](int b)
+            {
+                const int blockStart = b * BlockSize;
+                const int blockEnd = (std::min)(blockStart + BlockSize, elementCount);
+                int run = int(std::upper_bound(runEnds.cbegin(), runEnds.cend(), blockStart) - runEnds.cbegin());
+                for (int i = blockStart; i < blockEnd; ++run)
+                {
+                    const int runEnd = (std::min)(runEnds[run], blockEnd);
+                    std::fill(outFirst + i, outFirst + runEnd, valuesFirst[run]);
+                    i = runEnd;
+                }
+            });
+            return elementCount;
+        }
+    }
+}
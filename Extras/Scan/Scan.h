@@ -0,0 +1,140 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <iterator>
+#include <amp.h>
+#include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanSimd.h"
+#include "ScanTiledOptimized.h"
+
+//===============================================================================
+//  Scans of host data of any length.
+//
+//  Inputs shorter than kScanHostCutoff elements are scanned on the host with the
+//  SIMD kernels in ScanSimd.h, below this the copies to and from the accelerator
+//  and the kernel launches take longer than the whole scan on the host. Longer 
+//  inputs are copied to a single array on the default accelerator and scanned in
+//  place with ScanOptimized. Neither needs the input padded to a multiple of the 
+//  tile size. ScanPerf reports both at sizes either side of the cut-off so it can
+//  be tuned.
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
+    //===============================================================================
+
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void ExclusiveScan(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        details::Scan<TileSize, details::kExclusive>(first, last, outFirst, op);
+    }
+
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void ExclusiveScan(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        details::Scan<TileSize, details::kExclusive>(first, last, outFirst, SumOp<T>());
+    }
+
+    //  In-place exclusive scan, the range is overwritten with the result.
+
+    template <int TileSize, typename FwdIt, typename Op>
+    inline void ExclusiveScanInPlace(FwdIt first, FwdIt last, const Op& op)
+    {
+        details::Scan<TileSize, details::kExclusive>(first, last, first, op);
+    }
+
+    template <int TileSize, typename FwdIt>
+    inline void ExclusiveScanInPlace(FwdIt first, FwdIt last)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        details::Scan<TileSize, details::kExclusive>(first, last, first, SumOp<T>());
+    }
+
+    //===============================================================================
+    // Inclusive scan, output element at i contains the sum of elements [0]...[i].
+    //===============================================================================
+
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void InclusiveScan(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        details::Scan<TileSize, details::kInclusive>(first, last, outFirst, op);
+    }
+
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void InclusiveScan(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        details::Scan<TileSize, details::kInclusive>(first, last, outFirst, SumOp<T>());
+    }
+
+    //  In-place inclusive scan, the range is overwritten with the result.
+
+    template <int TileSize, typename FwdIt, typename Op>
+    inline void InclusiveScanInPlace(FwdIt first, FwdIt last, const Op& op)
+    {
+        details::Scan<TileSize, details::kInclusive>(first, last, first, op);
+    }
+
+    template <int TileSize, typename FwdIt>
+    inline void InclusiveScanInPlace(FwdIt first, FwdIt last)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        details::Scan<TileSize, details::kInclusive>(first, last, first, SumOp<T>());
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        enum 
+        { 
+            kScanHostCutoff = 32 * 1024 
+        };
+
+        template <int TileSize, int Mode, typename InIt, typename OutIt, typename Op>
+        void Scan(InIt first, InIt last, OutIt outFirst, const Op& op)
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            typedef std::integral_constant<bool, UseSimdScan<InIt, OutIt, Op>::value> UseSimd;
+
+            const int size = int(std::distance(first, last));
+            if (size == 0)
+                return;
+            if (size < kScanHostCutoff)
+            {
+                ScanBlock<Mode>(first, outFirst, size, op.Identity(), op, UseSimd());
+                return;
+            }
+
+            concurrency::array<T, 1> data(size, first, last);
+            ScanOptimizedInPlace<TileSize, Mode>(concurrency::array_view<T, 1>(data), op);
+            concurrency::copy(data, outFirst);
+        }
+    }
+}
@@ -0,0 +1,251 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <ppl.h>
+#include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanSimd.h"
+
+//===============================================================================
+//  Single pass scan running on CPU threads using decoupled look-back.
+//
+//  The input is split into blocks of BlockSize elements which worker threads 
+//  claim in order. Each worker sums its block and publishes the block aggregate, 
+//  then looks back over its predecessors, adding their aggregates until it finds 
+//  one that has published its inclusive prefix. It then publishes its own 
+//  inclusive prefix and scans the block, which is still in cache, into the 
+//  output. Unlike the tiled scans, which scan tiles, scan the tile sums and then
+//  add them back, each element is read from memory once and written once.
+//
+//  Blocks are claimed in increasing order so a worker only ever waits for blocks
+//  that are already being processed by another worker, whatever the number of 
+//  threads actually running.
+//
+//  Blocks are reduced and scanned with the SIMD kernels in ScanSimd.h where the
+//  operator and iterators allow it.
+//
+//  http://research.nvidia.com/publication/single-pass-parallel-prefix-scan-decoupled-look-back
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename OutIt, typename Op>
+    inline void ExclusiveScanLookBack(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        details::ScanLookBack<BlockSize, details::kExclusive>(first, last, outFirst, op);
+    }
+
+    template <int BlockSize, typename InIt, typename OutIt>
+    inline void ExclusiveScanLookBack(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        details::ScanLookBack<BlockSize, details::kExclusive>(first, last, outFirst, SumOp<T>());
+    }
+
+    //  In-place exclusive scan directly over the caller's memory, no copies are made.
+
+    template <int BlockSize, typename FwdIt, typename Op>
+    inline void ExclusiveScanLookBackInPlace(FwdIt first, FwdIt last, const Op& op)
+    {
+        details::ScanLookBack<BlockSize, details::kExclusive>(first, last, first, op);
+    }
+
+    template <int BlockSize, typename FwdIt>
+    inline void ExclusiveScanLookBackInPlace(FwdIt first, FwdIt last)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        details::ScanLookBack<BlockSize, details::kExclusive>(first, last, first, SumOp<T>());
+    }
+
+    //===============================================================================
+    // Inclusive scan, output element at i contains the sum of elements [0]...[i].
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename OutIt, typename Op>
+    inline void InclusiveScanLookBack(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        details::ScanLookBack<BlockSize, details::kInclusive>(first, last, outFirst, op);
+    }
+
+    template <int BlockSize, typename InIt, typename OutIt>
+    inline void InclusiveScanLookBack(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        details::ScanLookBack<BlockSize, details::kInclusive>(first, last, outFirst, SumOp<T>());
+    }
+
+    //  In-place inclusive scan directly over the caller's memory, no copies are made.
+
+    template <int BlockSize, typename FwdIt, typename Op>
+    inline void InclusiveScanLookBackInPlace(FwdIt first, FwdIt last, const Op& op)
+    {
+        details::ScanLookBack<BlockSize, details::kInclusive>(first, last, first, op);
+    }
+
+    template <int BlockSize, typename FwdIt>
+    inline void InclusiveScanLookBackInPlace(FwdIt first, FwdIt last)
+    {
+        typedef typename std::iterator_traits<FwdIt>::value_type T;
+
+        details::ScanLookBack<BlockSize, details::kInclusive>(first, last, first, SumOp<T>());
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        enum LookBackStatus
+        {
+            kBlockNotReady = 0,
+            kAggregateReady = 1,
+            kPrefixReady = 2
+        };
+
+        //  Status of one block. The values are written before the status is released
+        //  and only read after it has been acquired. Padded so that neighbouring blocks
+        //  don't share a cache line.
+
+        template <typename T>
+        struct LookBackBlock
+        {
+            std::atomic<int> Status;
+            T Aggregate;
+            T InclusivePrefix;
+            char Padding[64];
+        };
+
+        //  Combine all the blocks before block by looking back until a block with an 
+        //  inclusive prefix is found.
+
+        template <typename T, typename Op>
+        T LookBack(const LookBackBlock<T>* blocks, int block, const Op& op)
+        {
+            T exclusivePrefix = op.Identity();
+            for (int i = block - 1; i >= 0; --i)
+            {
+                int status;
+                while ((status = blocks[i].Status.load(std::memory_order_acquire)) == kBlockNotReady)
+                    std::this_thread::yield();
+
+                if (status == kPrefixReady)
+                    return op(blocks[i].InclusivePrefix, exclusivePrefix);
+                exclusivePrefix = op(blocks[i].Aggregate, exclusivePrefix);
+            }
+            return exclusivePrefix;
+        }
+
+        //  Publishes the aggregate of one block and returns the combination of all the 
+        //  blocks before it.
+
+        template <typename T, typename Op>
+        class LookBackPublisher
+        {
+        private:
+            LookBackBlock<T>* m_blocks;
+            int m_block;
+            const Op& m_op;
+
+        public:
+            LookBackPublisher(LookBackBlock<T>* blocks, int block, const Op& op) : 
+                m_blocks(blocks), 
+                m_block(block), 
+                m_op(op) 
+            { 
+            }
+
+            T operator()(const T& aggregate) const
+            {
+                LookBackBlock<T>& current = m_blocks[m_block];
+                if (m_block == 0)
+                {
+                    current.InclusivePrefix = aggregate;
+                    current.Status.store(kPrefixReady, std::memory_order_release);
+                    return m_op.Identity();
+                }
+
+                current.Aggregate = aggregate;
+                current.Status.store(kAggregateReady, std::memory_order_release);
+                const T prefix = LookBack(m_blocks, m_block, m_op);
+                current.InclusivePrefix = m_op(prefix, aggregate);
+                current.Status.store(kPrefixReady, std::memory_order_release);
+                return prefix;
+            }
+        };
+
+        //  Call blockFunc(b, publish) for every block b on the worker threads. blockFunc
+        //  must call publish exactly once, with the aggregate of block b, as later blocks 
+        //  wait for it. publish returns the combined aggregates of all the earlier blocks.
+
+        template <typename T, typename Op, typename Func>
+        void LookBackBlocks(int blockCount, const Op& op, Func blockFunc)
+        {
+            std::unique_ptr<LookBackBlock<T>[]> blocks(new LookBackBlock<T>[blockCount]);
+            for (int b = 0; b < blockCount; ++b)
+                blocks[b].Status.store(kBlockNotReady, std::memory_order_relaxed);
+            std::atomic<int> nextBlock(0);
+
+            const int workerCount = (std::min)(blockCount, int(concurrency::GetProcessorCount()));
+            concurrency::parallel_for(0, workerCount, [&](int)
+            {
+                for (int b = nextBlock++; b < blockCount; b = nextBlock++)
+                {
+                    const LookBackPublisher<T, Op> publish(blocks.get(), b, op);
+                    blockFunc(b, publish);
+                }
+            });
+        }
+
+        template <int BlockSize, int Mode, typename InIt, typename OutIt, typename Op>
+        void ScanLookBack(InIt first, InIt last, OutIt outFirst, const Op& op)
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            typedef std::integral_constant<bool, UseSimdScan<InIt, OutIt, Op>::value> UseSimd;
+
+            static_assert((Mode == details::kExclusive || Mode == details::kInclusive), "Mode must be either inclusive or exclusive.");
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int elementCount = int(std::distance(first, last));
+            assert(elementCount > 0);
+
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            LookBackBlocks<T>(blockCount, op, [&](int b, const LookBackPublisher<T, Op>& publish)
+            {
+                const int blockStart = b * BlockSize;
+                const int blockEnd = (std::min)(blockStart + BlockSize, elementCount);
+
+                const T prefix = publish(ReduceBlock(first + blockStart, first + blockEnd, op, UseSimd()));
+                ScanBlock<Mode>(first + blockStart, outFirst + blockStart, blockEnd - blockStart, prefix, op, UseSimd());
+            });
+        }
+    }
+}
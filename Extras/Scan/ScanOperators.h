@@ -0,0 +1,126 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <amp.h>
+#include <limits>
+
+//===============================================================================
+//  Associative operators for the scans.
+//
+//  An operator provides T Identity() and T operator()(const T& a, const T& b), 
+//  where a comes before b in the sequence, both restrict(amp, cpu). Operators
+//  need only be associative, the scans never reorder their operands. Identities
+//  that need std::numeric_limits are computed on construction, on the CPU, so 
+//  that the operator can be captured by value in a kernel.
+//===============================================================================
+
+namespace Extras
+{
+    template <typename T>
+    struct SumOp
+    {
+        T Identity() const restrict(amp, cpu) { return T(0); }
+        T operator()(const T& a, const T& b) const restrict(amp, cpu) { return a + b; }
+    };
+
+    template <typename T>
+    struct ProductOp
+    {
+        T Identity() const restrict(amp, cpu) { return T(1); }
+        T operator()(const T& a, const T& b) const restrict(amp, cpu) { return a * b; }
+    };
+
+    template <typename T>
+    struct MaxOp
+    {
+        T m_identity;
+
+        MaxOp() : m_identity(std::numeric_limits<T>::has_infinity ?
+            -std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::min)()) { }
+
+        T Identity() const restrict(amp, cpu) { return m_identity; }
+        T operator()(const T& a, const T& b) const restrict(amp, cpu) { return (a > b) ? a : b; }
+    };
+
+    template <typename T>
+    struct MinOp
+    {
+        T m_identity;
+
+        MinOp() : m_identity(std::numeric_limits<T>::has_infinity ?
+            std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::max)()) { }
+
+        T Identity() const restrict(amp, cpu) { return m_identity; }
+        T operator()(const T& a, const T& b) const restrict(amp, cpu) { return (a < b) ? a : b; }
+    };
+
+    //===============================================================================
+    //  The affine transform x -> A * x + B. Scanning a sequence of transforms with
+    //  AffineComposeOp gives the composition of each prefix, so the linear 
+    //  recurrence y[i] = a[i] * y[i - 1] + b[i] is y[i] = prefix[i].Apply(y[-1]).
+    //  No constructors so that it can be used in tile_static memory.
+    //===============================================================================
+
+    template <typename T>
+    struct AffineTransform
+    {
+        T A;
+        T B;
+
+        T Apply(const T& x) const restrict(amp, cpu) { return A * x + B; }
+
+        bool operator==(const AffineTransform& other) const restrict(amp, cpu) { return (A == other.A) && (B == other.B); }
+    };
+
+    template <typename T>
+    inline AffineTransform<T> MakeAffineTransform(T a, T b) restrict(amp, cpu)
+    {
+        AffineTransform<T> transform;
+        transform.A = a;
+        transform.B = b;
+        return transform;
+    }
+
+    //  Composition is not commutative, applying a then b.
+
+    template <typename T>
+    struct AffineComposeOp
+    {
+        AffineTransform<T> Identity() const restrict(amp, cpu) { return MakeAffineTransform(T(1), T(0)); }
+
+        AffineTransform<T> operator()(const AffineTransform<T>& a, const AffineTransform<T>& b) const restrict(amp, cpu)
+        {
+            return MakeAffineTransform(b.A * a.A, b.A * a.B + b.B);
+        }
+    };
+
+    //===============================================================================
+    //  Whether a scan includes each element in its own result. Shared by the 
+    //  accelerator and CPU scans, so the CPU only headers need not include an AMP 
+    //  tiled scan first.
+    //===============================================================================
+
+    namespace details
+    {
+        enum ScanMode
+        {
+            kExclusive = 0,
+            kInclusive = 1
+        };
+    }
+}
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "ScanOperators.h"
+
 //===============================================================================
 //  Sequential scan implementation running on CPU. Used for testing.
 //===============================================================================
@@ -26,27 +28,39 @@ namespace ScanTests
     // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
     //===============================================================================
 
+    template <typename InIt, typename OutIt, typename Op>
+    void ExclusiveScan(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        *outFirst = op.Identity();
+        for (int i = 1; i < std::distance(first, last); ++i)
+            outFirst[i] = op(outFirst[i - 1], first[i - 1]);
+    }
+
     template <typename InIt, typename OutIt>
     void ExclusiveScan(InIt first, InIt last, OutIt outFirst)
     {
         typedef OutIt::value_type T;
 
-        *outFirst = T(0);
-        for (int i = 1; i < std::distance(first, last); ++i)
-            outFirst[i] = first[i - 1] + outFirst[i - 1];
+        ExclusiveScan(first, last, outFirst, Extras::SumOp<T>());
     }
 
     //===============================================================================
     // Inclusive scan, output element at i contains the sum of elements [0]...[i].
     //===============================================================================
 
+    template <typename InIt, typename OutIt, typename Op>
+    void InclusiveScan(InIt first, InIt last, OutIt outFirst, const Op& op)
+    {
+        *outFirst = *first;
+        for (int i = 1; i < std::distance(first, last); ++i)
+            outFirst[i] = op(outFirst[i - 1], first[i]);
+    }
+
     template <typename InIt, typename OutIt>
     void InclusiveScan(InIt first, InIt last, OutIt outFirst)
     {
         typedef OutIt::value_type T;
 
-        *outFirst = T(*first);
-        for (int i = 1; i < std::distance(first, last); ++i)
-            outFirst[i] = first[i] + outFirst[i - 1];
+        InclusiveScan(first, last, outFirst, Extras::SumOp<T>());
     }
 }
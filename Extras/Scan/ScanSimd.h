@@ -0,0 +1,270 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+#include <emmintrin.h>
+
+#include "ScanOperators.h"
+
+//===============================================================================
+//  SSE2 kernels used by the CPU scans to reduce and scan one block.
+//
+//  Each group of four elements is scanned in register by two shift and combine
+//  steps, then combined with the carry from the previous group. Supported for 
+//  int and float with SumOp, MaxOp and MinOp, and float with ProductOp. These
+//  operators are commutative, which the reduction relies on. Other operators, 
+//  types and non-contiguous iterators use the scalar loops. Float sums and 
+//  products are combined in a different order to a sequential scan so may 
+//  differ from it in the last bits.
+//===============================================================================
+
+namespace Extras
+{
+    namespace details
+    {
+        template <typename It>
+        struct IsContiguousIterator
+        {
+            typedef typename std::iterator_traits<It>::value_type T;
+            enum 
+            { 
+                value = std::is_pointer<It>::value || 
+                    std::is_same<It, typename std::vector<T>::iterator>::value || 
+                    std::is_same<It, typename std::vector<T>::const_iterator>::value 
+            };
+        };
+
+        //  Shift the lanes up by one or two, filling the lowest lanes from fill.
+
+        inline __m128i ShiftLanesUp1(__m128i v, __m128i fill)
+        {
+            return _mm_or_si128(_mm_slli_si128(v, 4), _mm_and_si128(fill, _mm_setr_epi32(-1, 0, 0, 0)));
+        }
+
+        inline __m128i ShiftLanesUp2(__m128i v, __m128i fill)
+        {
+            return _mm_or_si128(_mm_slli_si128(v, 8), _mm_and_si128(fill, _mm_setr_epi32(-1, -1, 0, 0)));
+        }
+
+        inline __m128 ShiftLanesUp1(__m128 v, __m128 fill)
+        {
+            return _mm_castsi128_ps(ShiftLanesUp1(_mm_castps_si128(v), _mm_castps_si128(fill)));
+        }
+
+        inline __m128 ShiftLanesUp2(__m128 v, __m128 fill)
+        {
+            return _mm_castsi128_ps(ShiftLanesUp2(_mm_castps_si128(v), _mm_castps_si128(fill)));
+        }
+
+        template <typename T>
+        struct SimdScanVector
+        {
+        };
+
+        template <>
+        struct SimdScanVector<int>
+        {
+            typedef __m128i Type;
+
+            static inline Type Load(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+            static inline void Store(int* p, Type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+            static inline Type Splat(int v) { return _mm_set1_epi32(v); }
+            static inline Type SplatLast(Type v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)); }
+            static inline int Last(Type v) { return _mm_cvtsi128_si32(SplatLast(v)); }
+        };
+
+        template <>
+        struct SimdScanVector<float>
+        {
+            typedef __m128 Type;
+
+            static inline Type Load(const float* p) { return _mm_loadu_ps(p); }
+            static inline void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+            static inline Type Splat(float v) { return _mm_set1_ps(v); }
+            static inline Type SplatLast(Type v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+            static inline float Last(Type v) { return _mm_cvtss_f32(SplatLast(v)); }
+        };
+
+        //  Register wide equivalent of each operator.
+
+        template <typename T, typename Op>
+        struct SimdScanCombine
+        {
+            enum { IsSupported = false };
+        };
+
+        template <>
+        struct SimdScanCombine<int, SumOp<int>>
+        {
+            enum { IsSupported = true };
+            __m128i operator()(__m128i a, __m128i b) const { return _mm_add_epi32(a, b); }
+        };
+
+        //  SSE2 has no 32-bit integer min/max so select using a comparison mask.
+
+        template <>
+        struct SimdScanCombine<int, MaxOp<int>>
+        {
+            enum { IsSupported = true };
+            __m128i operator()(__m128i a, __m128i b) const
+            {
+                const __m128i mask = _mm_cmpgt_epi32(a, b);
+                return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+            }
+        };
+
+        template <>
+        struct SimdScanCombine<int, MinOp<int>>
+        {
+            enum { IsSupported = true };
+            __m128i operator()(__m128i a, __m128i b) const
+            {
+                const __m128i mask = _mm_cmplt_epi32(a, b);
+                return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+            }
+        };
+
+        template <>
+        struct SimdScanCombine<float, SumOp<float>>
+        {
+            enum { IsSupported = true };
+            __m128 operator()(__m128 a, __m128 b) const { return _mm_add_ps(a, b); }
+        };
+
+        template <>
+        struct SimdScanCombine<float, ProductOp<float>>
+        {
+            enum { IsSupported = true };
+            __m128 operator()(__m128 a, __m128 b) const { return _mm_mul_ps(a, b); }
+        };
+
+        template <>
+        struct SimdScanCombine<float, MaxOp<float>>
+        {
+            enum { IsSupported = true };
+            __m128 operator()(__m128 a, __m128 b) const { return _mm_max_ps(a, b); }
+        };
+
+        template <>
+        struct SimdScanCombine<float, MinOp<float>>
+        {
+            enum { IsSupported = true };
+            __m128 operator()(__m128 a, __m128 b) const { return _mm_min_ps(a, b); }
+        };
+
+        //  Use the SIMD kernels for supported operators over contiguous memory. The kernels
+        //  store whole vectors of T, so the output must hold T too. Mixed types, such as an
+        //  int input scanned into a long long output, use the scalar loop.
+
+        template <typename InIt, typename OutIt, typename Op>
+        struct UseSimdScan
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            enum 
+            { 
+                value = SimdScanCombine<T, Op>::IsSupported && 
+                    IsContiguousIterator<InIt>::value && IsContiguousIterator<OutIt>::value && 
+                    std::is_same<T, typename std::iterator_traits<OutIt>::value_type>::value
+            };
+        };
+
+        //===============================================================================
+        //  Reduce [first, last), which must not be empty.
+        //===============================================================================
+
+        template <typename InIt, typename Op>
+        typename std::iterator_traits<InIt>::value_type ReduceBlock(InIt first, InIt last, const Op& op, std::false_type)
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            return std::accumulate(first + 1, last, T(*first), op);
+        }
+
+        template <typename InIt, typename Op>
+        typename std::iterator_traits<InIt>::value_type ReduceBlock(InIt first, InIt last, const Op& op, std::true_type)
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            typedef SimdScanVector<T> Vec;
+            SimdScanCombine<T, Op> combine;
+
+            const T* p = &*first;
+            const T* end = p + std::distance(first, last);
+            const typename Vec::Type identity = Vec::Splat(op.Identity());
+            typename Vec::Type acc0 = identity;
+            typename Vec::Type acc1 = identity;
+            for (; (end - p) >= 8; p += 8)
+            {
+                acc0 = combine(acc0, Vec::Load(p));
+                acc1 = combine(acc1, Vec::Load(p + 4));
+            }
+            typename Vec::Type v = combine(acc0, acc1);
+            v = combine(ShiftLanesUp1(v, identity), v);
+            v = combine(ShiftLanesUp2(v, identity), v);
+            T result = Vec::Last(v);
+            for (; p < end; ++p)
+                result = op(result, *p);
+            return result;
+        }
+
+        //===============================================================================
+        //  Scan count elements from in to out, starting from prefix. Returns the 
+        //  inclusive prefix of the last element. Each group of elements is read
+        //  before it is written so in and out may be the same.
+        //===============================================================================
+
+        template <int Mode, typename InIt, typename OutIt, typename T, typename Op>
+        T ScanBlock(InIt in, OutIt out, int count, T prefix, const Op& op, std::false_type)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const T value = in[i];
+                if (Mode == details::kInclusive)
+                    prefix = op(prefix, value);
+                out[i] = prefix;
+                if (Mode == details::kExclusive)
+                    prefix = op(prefix, value);
+            }
+            return prefix;
+        }
+
+        template <int Mode, typename InIt, typename OutIt, typename T, typename Op>
+        T ScanBlock(InIt in, OutIt out, int count, T prefix, const Op& op, std::true_type)
+        {
+            typedef SimdScanVector<T> Vec;
+            SimdScanCombine<T, Op> combine;
+
+            const T* pIn = &*in;
+            T* pOut = &*out;
+            const typename Vec::Type identity = Vec::Splat(op.Identity());
+            typename Vec::Type carry = Vec::Splat(prefix);
+            int i = 0;
+            for (; (i + 4) <= count; i += 4)
+            {
+                typename Vec::Type v = Vec::Load(pIn + i);
+                v = combine(ShiftLanesUp1(v, identity), v);
+                v = combine(ShiftLanesUp2(v, identity), v);
+                const typename Vec::Type inclusive = combine(carry, v);
+                Vec::Store(pOut + i, (Mode == details::kInclusive) ? inclusive : ShiftLanesUp1(inclusive, carry));
+                carry = Vec::SplatLast(inclusive);
+            }
+            return ScanBlock<Mode>(pIn + i, pOut + i, count - i, Vec::Last(carry), op, std::false_type());
+        }
+    }
+}
@@ -19,14 +19,16 @@
 #include <amp.h>
 #include <assert.h>
 
+#include "ScanOperators.h"
+
 namespace Extras
 {
     //===============================================================================
     // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
     //===============================================================================
 
-    template <typename InIt, typename OutIt>
-    inline void ExclusiveScanSimple(InIt first, InIt last, OutIt outFirst)
+    template <typename InIt, typename OutIt, typename Op>
+    inline void ExclusiveScanSimple(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -34,22 +36,36 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);
-        details::ScanSimple<details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanSimple<details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(in, outFirst);
     }
 
+    template <typename InIt, typename OutIt>
+    inline void ExclusiveScanSimple(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        ExclusiveScanSimple(first, last, outFirst, SumOp<T>());
+    }
+
+    template <typename T, typename Op>
+    void ExclusiveScanSimple(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanSimple<details::kExclusive>(input, output, op);
+    }
+
     template <typename T>
     void ExclusiveScanSimple(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanSimple<details::kExclusive>(input, output);
+        details::ScanSimple<details::kExclusive>(input, output, SumOp<T>());
     }
 
     //===============================================================================
     // Inclusive scan, output element at i contains the sum of elements [0]...[i].
     //===============================================================================
 
-    template <typename InIt, typename OutIt>
-    inline void InclusiveScanSimple(InIt first, InIt last, OutIt outFirst)
+    template <typename InIt, typename OutIt, typename Op>
+    inline void InclusiveScanSimple(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -57,14 +73,28 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);
-        details::ScanSimple<details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanSimple<details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(out, outFirst);
     }
 
+    template <typename InIt, typename OutIt>
+    inline void InclusiveScanSimple(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        InclusiveScanSimple(first, last, outFirst, SumOp<T>());
+    }
+
+    template <typename T, typename Op>
+    void InclusiveScanSimple(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanSimple<details::kInclusive>(input, output, op);
+    }
+
     template <typename T>
     void InclusiveScanSimple(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanSimple<details::kInclusive>(input, output);
+        details::ScanSimple<details::kInclusive>(input, output, SumOp<T>());
     }
 
     //===============================================================================
@@ -73,8 +103,8 @@ namespace Extras
 
     namespace details
     {
-        template <int Mode, typename T>
-        void ScanSimple(concurrency::array_view<T, 1>& input, concurrency::array_view<T, 1>& output)
+        template <int Mode, typename T, typename Op>
+        void ScanSimple(concurrency::array_view<T, 1>& input, concurrency::array_view<T, 1>& output, const Op& op)
         {
             assert(input.extent[0] == output.extent[0]);
             int offset;
@@ -85,7 +115,7 @@ namespace Extras
                 parallel_for_each(input.extent, [=](concurrency::index<1> idx) restrict (amp)
                 {
                     if (idx[0] >= offset)
-                        output[idx] = input[idx] + input[idx - offset];
+                        output[idx] = op(input[idx - offset], input[idx]);
                     else
                         output[idx] = input[idx];
                 });
@@ -101,11 +131,11 @@ namespace Extras
             parallel_for_each(compute_domain, [=](concurrency::index<1> idx) restrict(amp)
             {
                 if (idx[0] >= offset)
-                    output[idx + shift] = input[idx] + input[idx - offset];
+                    output[idx + shift] = op(input[idx - offset], input[idx]);
                 else
                     output[idx + shift] = input[idx];
                 if (Mode == kExclusive)
-                    output[0] = T(0);
+                    output[0] = op.Identity();
             });
             std::swap(input, output);
         }
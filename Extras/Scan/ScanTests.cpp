@@ -22,6 +22,14 @@
 #include "ScanSimple.h"
 #include "ScanTiled.h"
 #include "ScanTiledOptimized.h"
+#include "Scan.h"
+#include "ScanLookBack.h"
+#include "ScanOperators.h"
+#include "Compact.h"
+#include "RadixSort.h"
+#include "SegmentedScan.h"
+#include "Histogram.h"
+#include "RunLength.h"
 #include "Utilities.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -29,7 +37,8 @@ using namespace Extras;
 
 namespace ScanTests
 {
-    std::wstring Msg(std::vector<int>& expected, std::vector<int>& actual, size_t width = 8)
+    template <typename T>
+    std::wstring Msg(std::vector<T>& expected, std::vector<T>& actual, size_t width = 8)
     {
         std::wostringstream msg;
         msg << ContainerWidth(width) << L"[" << expected << L"] != [" << actual << L"]" << std::endl;
@@ -150,6 +159,18 @@ namespace ScanTests
             
             Assert::IsTrue(expected == result, Msg(expected, result).c_str());
         }
+
+        TEST_METHOD(InclusiveScanSimpleTests_Min)
+        {
+            std::array<int, 8> input =    { 5, 7, 3, 4, 9, 1, 2, 8 };
+            std::vector<int> result(input.size());
+            std::array<int, 8> expected = { 5, 5, 3, 3, 3, 1, 1, 1 };
+
+            InclusiveScanSimple(begin(input), end(input), result.begin(), MinOp<int>());
+            
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result).c_str());
+        }
     };
 
     TEST_CLASS(ScanTiledTests)
@@ -264,6 +285,44 @@ namespace ScanTests
             
             Assert::IsTrue(expected == result, Msg(expected, result).c_str());
         }
+
+        TEST_METHOD(InclusiveScanTiledTests_Max_Two_Tiles)
+        {
+            std::array<int, 8> input =    { 1, 3, 6, 2, 7, 9, 0, 5 };
+            std::vector<int> result(input.size());
+            std::array<int, 8> expected = { 1, 3, 6, 6, 7, 9, 9, 9 };
+
+            InclusiveScanTiled<4>(begin(input), end(input), result.begin(), MaxOp<int>());
+            
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result).c_str());
+        }
+
+        TEST_METHOD(ExclusiveScanTiledInPlaceTests_Partial_Last_Tile)
+        {
+            std::vector<int> input(13);
+            std::iota(begin(input), end(input), 1);
+            std::vector<int> expected(input.size());
+            ExclusiveScan(begin(input), end(input), expected.begin());
+
+            ExclusiveScanTiledInPlace<4>(begin(input), end(input));
+            
+            Assert::IsTrue(expected == input, Msg(expected, input, 16).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanTiledInPlaceTests_Large_Array_View)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<int> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin());
+
+            concurrency::array_view<int, 1> data(int(input.size()), input);
+            InclusiveScanTiledInPlace<64>(data);
+            data.synchronize();
+            
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
     };
 
     TEST_CLASS(ScanOptimizedTests)
@@ -411,5 +470,640 @@ namespace ScanTests
             
             Assert::IsTrue(expected == result, Msg(expected, result, 16).c_str());
         }
+
+        TEST_METHOD(ExclusiveScanOptimizedTests_Product_Two_Tiles)
+        {
+            std::array<int, 16> input =    { 1, 2, 1, 3, 1, 1, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1 };
+            std::vector<int> result(input.size());
+            std::array<int, 16> expected = { 1, 1, 2, 2, 6, 6, 6, 12, 12, 12, 12, 12, 24, 24, 24, 24 };
+
+            ExclusiveScanOptimized<4>(begin(input), end(input), result.begin(), ProductOp<int>());
+            
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result, 16).c_str());
+        }
+
+        TEST_METHOD(ExclusiveScanOptimizedInPlaceTests_Large_Array_View)
+        {
+            std::vector<int> input(100001);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<int> expected(input.size());
+            ExclusiveScan(begin(input), end(input), expected.begin());
+
+            concurrency::array_view<int, 1> data(int(input.size()), input);
+            ExclusiveScanOptimizedInPlace<64>(data);
+            data.synchronize();
+            
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanOptimizedInPlaceTests_Max_Two_Tiles)
+        {
+            std::array<int, 16> input =    { 1, 3, 6, 2, 7, 9, 0, 5, 8, 1, 11, 2, 3, 4, 12, 0 };
+            std::vector<int> result(begin(input), end(input));
+            std::array<int, 16> expected = { 1, 3, 6, 6, 7, 9, 9, 9, 9, 9, 11, 11, 11, 11, 12, 12 };
+
+            InclusiveScanOptimizedInPlace<4>(begin(result), end(result), MaxOp<int>());
+            
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result, 16).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanOptimizedTests_Odd_Partial_Tile)
+        {
+            std::vector<int> input(13);
+            std::iota(begin(input), end(input), 1);
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin());
+
+            InclusiveScanOptimized<4>(begin(input), end(input), result.begin());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result, 16).c_str());
+        }
+
+        TEST_METHOD(ScanOptimizedTests_Random_Sizes)
+        {
+            for (unsigned int trial = 0; trial < 64; ++trial)
+            {
+                // Tiny inputs first, then sizes up to several levels of tiles.
+                const int size = (trial < 8) ? int(trial + 1) : 1 + int(((trial * 2654435761u) >> 8) % 20000);
+                std::vector<int> input(size);
+                int i = 0;
+                std::generate(begin(input), end(input), [&i, trial]() { return int(((i++ + trial) * 2654435761u) >> 26) - 32; });
+                std::vector<int> result(input.size());
+                std::vector<int> expected(input.size());
+
+                InclusiveScan(begin(input), end(input), expected.begin());
+                InclusiveScanOptimized<16>(begin(input), end(input), result.begin());
+                Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+
+                ExclusiveScan(begin(input), end(input), expected.begin());
+                ExclusiveScanOptimized<16>(begin(input), end(input), result.begin());
+                Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+            }
+        }
+    };
+
+    TEST_CLASS(ScanLookBackTests)
+    {
+    public:
+        TEST_METHOD(ExclusiveScanLookBackTests_Simple_Four_Blocks)
+        {
+            std::vector<int> input(8, 1);
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            std::iota(begin(expected), end(expected), 0);
+
+            ExclusiveScanLookBack<2>(begin(input), end(input), result.begin());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanLookBackTests_Complex_Four_Blocks)
+        {
+            std::array<int, 8> input =    { 1, 3,  6,  2,  7,  9,  0,  5 };
+            std::vector<int> result(input.size());
+            std::array<int, 8> expected = { 1, 4, 10, 12, 19, 28, 28, 33 };
+
+            InclusiveScanLookBack<2>(begin(input), end(input), result.begin());
+            
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanLookBackTests_Partial_Last_Block)
+        {
+            std::vector<int> input(10, 1);
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            std::iota(begin(expected), end(expected), 1);
+
+            InclusiveScanLookBack<4>(begin(input), end(input), result.begin());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result, 16).c_str());
+        }
+
+        TEST_METHOD(ExclusiveScanLookBackTests_Large)
+        {
+            std::vector<int> input(100000, 1);
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            std::iota(begin(expected), end(expected), 0);
+
+            ExclusiveScanLookBack<64>(begin(input), end(input), result.begin());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanLookBackTests_Large_In_Place)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<int> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin());
+
+            InclusiveScanLookBack<256>(begin(input), end(input), input.begin());
+            
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
+
+        TEST_METHOD(ExclusiveScanLookBackInPlaceTests_Large)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<int> expected(input.size());
+            ExclusiveScan(begin(input), end(input), expected.begin());
+
+            ExclusiveScanLookBackInPlace<256>(begin(input), end(input));
+            
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanLookBackTests_Max_Large)
+        {
+            std::vector<int> input(100000);
+            int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return int((i++ * 2654435761u) >> 12); });
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin(), MaxOp<int>());
+
+            InclusiveScanLookBack<64>(begin(input), end(input), result.begin(), MaxOp<int>());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(ExclusiveScanLookBackTests_Min_Float)
+        {
+            std::array<float, 8> input =    { 5.0f, 7.0f, 3.0f, 4.0f, -9.0f, 1.0f, 2.0f, 8.0f };
+            std::vector<float> result(input.size());
+            std::vector<float> expected(input.size());
+            ExclusiveScan(begin(input), end(input), expected.begin(), MinOp<float>());
+
+            ExclusiveScanLookBack<2>(begin(input), end(input), result.begin(), MinOp<float>());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanLookBackTests_Linear_Recurrence)
+        {
+            // y[i] = a[i] * y[i - 1] + i, starting from y[-1] = 3. Coefficients of +/-1 keep 
+            // every value an exact integer whatever the order the transforms are composed in.
+            std::vector<AffineTransform<double>> transforms(1000);
+            for (size_t i = 0; i < transforms.size(); ++i)
+                transforms[i] = MakeAffineTransform(((i % 3) == 0) ? -1.0 : 1.0, double(i));
+            std::vector<AffineTransform<double>> prefixes(transforms.size());
+            std::vector<double> expected(transforms.size());
+            double y = 3.0;
+            for (size_t i = 0; i < transforms.size(); ++i)
+                expected[i] = y = transforms[i].Apply(y);
+
+            InclusiveScanLookBack<16>(begin(transforms), end(transforms), prefixes.begin(), AffineComposeOp<double>());
+
+            std::vector<double> result(transforms.size());
+            std::transform(begin(prefixes), end(prefixes), begin(result), [](const AffineTransform<double>& t) { return t.Apply(3.0); });
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+
+        //  A long long output can't use the int SIMD kernel, which stores whole vectors of int.
+        TEST_METHOD(InclusiveScanLookBackTests_Wider_Output)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<long long> result(input.size());
+            std::vector<long long> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin());
+
+            Extras::InclusiveScanLookBack<64>(begin(input), end(input), result.begin());
+            
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+    };
+
+    TEST_CLASS(CompactTests)
+    {
+    public:
+        TEST_METHOD(CopyIfTests_Simple_Four_Blocks)
+        {
+            std::array<int, 8> input =    { 1, 3, 6, 2, 7, 9, 0, 5 };
+            std::vector<int> result(input.size(), -1);
+            std::array<int, 4> expected = { 1, 3, 7, 9 };
+
+            auto resultEnd = CopyIf<2>(begin(input), end(input), result.begin(), [](int x) { return (x % 2) == 1; });
+
+            result.erase(resultEnd, end(result));
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result).c_str());
+        }
+
+        TEST_METHOD(CopyIfTests_Large_Keeps_Order)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), 0);
+            std::vector<int> result(input.size());
+            std::vector<int> expected;
+            auto pred = [](int x) { return ((x * 2654435761u) >> 31) != 0; };
+            std::copy_if(begin(input), end(input), std::back_inserter(expected), pred);
+
+            auto resultEnd = CopyIf<64>(begin(input), end(input), result.begin(), pred);
+
+            result.erase(resultEnd, end(result));
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(CopyIfTests_None_Selected)
+        {
+            std::vector<int> input(1000, 1);
+            std::vector<int> result(input.size());
+
+            auto resultEnd = CopyIf<64>(begin(input), end(input), result.begin(), [](int x) { return x == 0; });
+
+            Assert::IsTrue(resultEnd == result.begin());
+        }
+
+        TEST_METHOD(UnstableCopyIfTests_Large)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), 0);
+            std::vector<int> result(input.size());
+            std::vector<int> expected;
+            auto pred = [](int x) { return (x % 3) == 0; };
+            std::copy_if(begin(input), end(input), std::back_inserter(expected), pred);
+
+            auto resultEnd = UnstableCopyIf<64>(begin(input), end(input), result.begin(), pred);
+
+            result.erase(resultEnd, end(result));
+            std::sort(begin(result), end(result));
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(RemoveIfTests_Partial_Last_Block)
+        {
+            std::vector<int> input(10);
+            std::iota(begin(input), end(input), 0);
+            std::vector<int> expected(input);
+            expected.erase(std::remove_if(begin(expected), end(expected), [](int x) { return (x % 4) == 0; }), end(expected));
+
+            input.erase(RemoveIf<4>(begin(input), end(input), [](int x) { return (x % 4) == 0; }), end(input));
+
+            Assert::IsTrue(expected == input, Msg(expected, input, 16).c_str());
+        }
+
+        TEST_METHOD(StablePartitionTests_Large)
+        {
+            std::vector<int> input(100000);
+            int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return int((i++ * 2654435761u) >> 12); });
+            std::vector<int> expected(input);
+            auto pred = [](int x) { return (x % 2) == 0; };
+            auto expectedMiddle = std::stable_partition(begin(expected), end(expected), pred);
+
+            auto middle = StablePartition<256>(begin(input), end(input), pred);
+
+            Assert::AreEqual(std::distance(begin(expected), expectedMiddle), std::distance(begin(input), middle));
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
+
+        TEST_METHOD(CopyIfTiledTests_Partial_Last_Tile)
+        {
+            std::vector<int> input(100);
+            std::iota(begin(input), end(input), 0);
+            std::vector<int> result(input.size(), -1);
+            std::vector<int> expected;
+            std::copy_if(begin(input), end(input), std::back_inserter(expected), [](int x) { return (x % 3) == 0; });
+
+            concurrency::array_view<const int, 1> in(int(input.size()), input);
+            concurrency::array_view<int, 1> out(int(result.size()), result);
+            const int count = CopyIfTiled<16>(in, out, [](int x) restrict(amp) { return (x % 3) == 0; });
+            out.synchronize();
+
+            result.resize(count);
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+    };
+
+    TEST_CLASS(RadixSortTests)
+    {
+    public:
+        TEST_METHOD(RadixSortTests_Signed_Partial_Last_Block)
+        {
+            std::array<int, 10> input =    { 5, -3, 7, 0, -2147483647 - 1, 9, -3, 2147483647, 1, -8 };
+            std::vector<int> result(begin(input), end(input));
+            std::vector<int> expected(result);
+            std::sort(begin(expected), end(expected));
+
+            RadixSort<4>(begin(result), end(result));
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 16).c_str());
+        }
+
+        TEST_METHOD(RadixSortTests_Float)
+        {
+            std::array<float, 8> input =    { 2.5f, -1.0f, 0.0f, -7.25f, 3.0f, 1e-3f, -1e30f, 1e30f };
+            std::vector<float> result(begin(input), end(input));
+            std::vector<float> expected(result);
+            std::sort(begin(expected), end(expected));
+
+            RadixSort<3>(begin(result), end(result));
+
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+
+        TEST_METHOD(RadixSortTests_Large)
+        {
+            std::vector<unsigned int> result(100000);
+            unsigned int i = 0;
+            std::generate(begin(result), end(result), [&i]() { return i++ * 2654435761u; });
+            std::vector<unsigned int> expected(result);
+            std::sort(begin(expected), end(expected));
+
+            RadixSort<1024>(begin(result), end(result));
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(RadixSortTests_Large_64_Bit)
+        {
+            std::vector<long long> result(100000);
+            unsigned long long i = 0;
+            std::generate(begin(result), end(result), [&i]() { return static_cast<long long>(i++ * 6364136223846793005ull) >> 3; });
+            std::vector<long long> expected(result);
+            std::sort(begin(expected), end(expected));
+
+            RadixSort<1024>(begin(result), end(result));
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(RadixSortByKeyTests_Large_Stable)
+        {
+            std::vector<unsigned int> keys(100000);
+            unsigned int i = 0;
+            std::generate(begin(keys), end(keys), [&i]() { return (i++ * 2654435761u) >> 24; });
+            std::vector<int> values(keys.size());
+            std::iota(begin(values), end(values), 0);
+            std::vector<int> expected(values);
+            std::stable_sort(begin(expected), end(expected), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+            RadixSortByKey<1024>(begin(keys), end(keys), begin(values));
+
+            Assert::IsTrue(std::is_sorted(begin(keys), end(keys)));
+            Assert::IsTrue(expected == values, Msg(expected, values, 24).c_str());
+        }
+    };
+
+    TEST_CLASS(SegmentedScanTests)
+    {
+    public:
+        TEST_METHOD(InclusiveSegmentedScanTests_Simple_Four_Blocks)
+        {
+            std::array<int, 8> input =    { 1, 3, 6, 2, 7, 9, 0, 5 };
+            std::array<int, 8> heads =    { 1, 0, 0, 1, 0, 0, 0, 1 };
+            std::vector<int> result(input.size());
+            std::array<int, 8> expected = { 1, 4, 10, 2, 9, 18, 18, 5 };
+
+            InclusiveSegmentedScan<2>(begin(input), end(input), begin(heads), result.begin());
+
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result).c_str());
+        }
+
+        TEST_METHOD(ExclusiveSegmentedScanTests_Segment_Spans_Blocks)
+        {
+            std::array<int, 10> input =    { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+            std::array<int, 10> heads =    { 0, 0, 1, 0, 0, 0, 0, 0, 0, 1 };
+            std::vector<int> result(input.size());
+            std::array<int, 10> expected = { 0, 1, 0, 1, 2, 3, 4, 5, 6, 0 };
+
+            ExclusiveSegmentedScan<3>(begin(input), end(input), begin(heads), result.begin());
+
+            std::vector<int> exp(begin(expected), end(expected));
+            Assert::IsTrue(exp == result, Msg(exp, result, 16).c_str());
+        }
+
+        TEST_METHOD(InclusiveSegmentedScanTests_Large_By_Offsets)
+        {
+            std::vector<int> input(100000);
+            std::iota(begin(input), end(input), -50000);
+            std::vector<int> offsets;
+            for (int i = 0; i < int(input.size()); i += 1 + (i % 997))
+                offsets.push_back(i);
+            offsets.push_back(int(input.size()));
+            std::vector<int> expected(input.size());
+            for (size_t s = 0; (s + 1) < offsets.size(); ++s)
+                InclusiveScan(begin(input) + offsets[s], begin(input) + offsets[s + 1], expected.begin() + offsets[s]);
+            std::vector<int> result(input.size());
+
+            InclusiveSegmentedScanByOffsets<256>(begin(input), end(input), begin(offsets), end(offsets) - 1, result.begin());
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(ExclusiveSegmentedScanTests_Max_Large_In_Place)
+        {
+            std::vector<int> input(100000);
+            int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return int((i++ * 2654435761u) >> 12); });
+            std::vector<int> heads(input.size());
+            for (size_t j = 0; j < heads.size(); j += 3000)
+                heads[j] = 1;
+            std::vector<int> expected(input.size());
+            for (size_t j = 0; j < input.size(); j += 3000)
+            {
+                const size_t segmentEnd = (std::min)(j + 3000, input.size());
+                ExclusiveScan(begin(input) + j, begin(input) + segmentEnd, expected.begin() + j, MaxOp<int>());
+            }
+
+            ExclusiveSegmentedScan<64>(begin(input), end(input), begin(heads), input.begin(), MaxOp<int>());
+
+            Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+        }
+    };
+
+    TEST_CLASS(ScanAnyLengthTests)
+    {
+    public:
+        TEST_METHOD(InclusiveScanAnyLengthTests_Either_Side_Of_Cutoff)
+        {
+            const std::array<int, 6> sizes = { 1, 3, 1000, details::kScanHostCutoff - 1, details::kScanHostCutoff, details::kScanHostCutoff + 1001 };
+            for (int size : sizes)
+            {
+                std::vector<int> input(size);
+                std::iota(begin(input), end(input), -size / 2);
+                std::vector<int> result(input.size());
+                std::vector<int> expected(input.size());
+                InclusiveScan(begin(input), end(input), expected.begin());
+
+                Extras::InclusiveScan<64>(begin(input), end(input), result.begin());
+
+                Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+            }
+        }
+
+        TEST_METHOD(ExclusiveScanAnyLengthTests_Max_Large)
+        {
+            std::vector<int> input(details::kScanHostCutoff * 3 + 17);
+            int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return int((i++ * 2654435761u) >> 12); });
+            std::vector<int> result(input.size());
+            std::vector<int> expected(input.size());
+            ExclusiveScan(begin(input), end(input), expected.begin(), MaxOp<int>());
+
+            Extras::ExclusiveScan<64>(begin(input), end(input), result.begin(), MaxOp<int>());
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(InclusiveScanAnyLengthInPlaceTests_Either_Side_Of_Cutoff)
+        {
+            const std::array<int, 2> sizes = { details::kScanHostCutoff / 2, details::kScanHostCutoff * 2 + 5 };
+            for (int size : sizes)
+            {
+                std::vector<int> input(size);
+                std::iota(begin(input), end(input), -size / 2);
+                std::vector<int> expected(input.size());
+                InclusiveScan(begin(input), end(input), expected.begin());
+
+                Extras::InclusiveScanInPlace<64>(begin(input), end(input));
+
+                Assert::IsTrue(expected == input, Msg(expected, input, 24).c_str());
+            }
+        }
+
+        //  Below the cutoff the scan runs on the host, where a long long output can't use 
+        //  the int SIMD kernel.
+        TEST_METHOD(InclusiveScanAnyLengthTests_Wider_Output)
+        {
+            std::vector<int> input(1000);
+            std::iota(begin(input), end(input), -500);
+            std::vector<long long> result(input.size());
+            std::vector<long long> expected(input.size());
+            InclusiveScan(begin(input), end(input), expected.begin());
+
+            Extras::InclusiveScan<64>(begin(input), end(input), result.begin());
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+    };
+
+    TEST_CLASS(HistogramTests)
+    {
+    public:
+        TEST_METHOD(HistogramTests_Bytes_Into_256_Bins)
+        {
+            std::vector<unsigned char> input(100000);
+            unsigned int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return static_cast<unsigned char>((++i * 2654435761u) >> 24); });
+            std::vector<int> expected(256, 0);
+            for (unsigned char x : input)
+                ++expected[x];
+            std::vector<int> result(256, -1);
+
+            Histogram<1000>(begin(input), end(input), 256, result.begin());
+
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(HistogramTests_Bin_Function_Fewer_Bins_Than_Threads)
+        {
+            std::vector<int> input(12345);
+            std::iota(begin(input), end(input), 0);
+            std::vector<int> expected(3, 12345 / 3);
+            std::vector<int> result(3);
+
+            Histogram<64>(begin(input), end(input), 3, [](int x) { return x % 3; }, result.begin());
+
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+
+        TEST_METHOD(HistogramTests_Empty)
+        {
+            std::vector<int> input;
+            std::vector<int> expected(4, 0);
+            std::vector<int> result(4, -1);
+
+            Histogram<64>(begin(input), end(input), 4, result.begin());
+
+            Assert::IsTrue(expected == result, Msg(expected, result).c_str());
+        }
+    };
+
+    TEST_CLASS(RunLengthTests)
+    {
+    public:
+        TEST_METHOD(RunLengthTests_Encode_Runs_Across_Blocks)
+        {
+            std::vector<int> input(10000);
+            int i = 0;
+            std::generate(begin(input), end(input), [&i]() { return (i++ / 37) % 5; });
+            std::vector<int> expectedValues;
+            std::vector<int> expectedLengths;
+            for (int j = 0; j < int(input.size()); ++j)
+            {
+                if ((j == 0) || (input[j] != input[j - 1]))
+                {
+                    expectedValues.push_back(input[j]);
+                    expectedLengths.push_back(0);
+                }
+                ++expectedLengths.back();
+            }
+            std::vector<int> values(input.size());
+            std::vector<int> lengths(input.size());
+
+            const int runCount = RunLengthEncode<64>(begin(input), end(input), values.begin(), lengths.begin());
+
+            Assert::AreEqual(int(expectedValues.size()), runCount);
+            values.resize(runCount);
+            lengths.resize(runCount);
+            Assert::IsTrue(expectedValues == values, Msg(expectedValues, values, 24).c_str());
+            Assert::IsTrue(expectedLengths == lengths, Msg(expectedLengths, lengths, 24).c_str());
+        }
+
+        TEST_METHOD(RunLengthTests_Encode_Single_Run)
+        {
+            const std::vector<int> input(1000, 7);
+            std::vector<int> values(input.size());
+            std::vector<int> lengths(input.size());
+
+            const int runCount = RunLengthEncode<64>(begin(input), end(input), values.begin(), lengths.begin());
+
+            Assert::AreEqual(1, runCount);
+            Assert::AreEqual(7, values[0]);
+            Assert::AreEqual(1000, lengths[0]);
+        }
+
+        TEST_METHOD(RunLengthTests_Decode_Long_And_Empty_Runs)
+        {
+            const std::array<int, 4> values = { 3, 4, 5, 6 };
+            const std::array<int, 4> lengths = { 0, 10000, 0, 2 };
+            std::vector<int> expected(10000, 4);
+            expected.push_back(6);
+            expected.push_back(6);
+            std::vector<int> result(expected.size() + 1, -1);
+
+            auto resultEnd = RunLengthDecode<64>(begin(values), end(values), begin(lengths), result.begin());
+
+            Assert::IsTrue(resultEnd == result.begin() + expected.size());
+            Assert::AreEqual(-1, result.back());
+            result.pop_back();
+            Assert::IsTrue(expected == result, Msg(expected, result, 24).c_str());
+        }
+
+        TEST_METHOD(RunLengthTests_Round_Trip)
+        {
+            std::vector<int> input(50000);
+            unsigned int i = 0;
+            int value = 0;
+            std::generate(begin(input), end(input), [&]() { if (((++i * 2654435761u) >> 8) % 20 == 0) ++value; return value; });
+            std::vector<int> values(input.size());
+            std::vector<int> lengths(input.size());
+            std::vector<int> result(input.size());
+
+            const int runCount = RunLengthEncode<256>(begin(input), end(input), values.begin(), lengths.begin());
+            RunLengthDecode<256>(values.begin(), values.begin() + runCount, lengths.begin(), result.begin());
+
+            Assert::IsTrue(input == result, Msg(input, result, 24).c_str());
+        }
     };
 }
@@ -19,14 +19,16 @@
 #include <amp.h>
 #include <assert.h>
 
+#include "ScanOperators.h"
+
 namespace Extras
 {
     //===============================================================================
     // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
     //===============================================================================
 
-    template <int TileSize, typename InIt, typename OutIt>
-    inline void ExclusiveScanTiled(InIt first, InIt last, OutIt outFirst)
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void ExclusiveScanTiled(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -34,22 +36,70 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);      
-        details::ScanTiled<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanTiled<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(out, outFirst);
     }
 
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void ExclusiveScanTiled(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        ExclusiveScanTiled<TileSize>(first, last, outFirst, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    void ExclusiveScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanTiled<TileSize, details::kExclusive>(input, output, op);
+    }
+
     template <int TileSize, typename T>
     void ExclusiveScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanTiled<TileSize, details::kExclusive>(input, output);
+        details::ScanTiled<TileSize, details::kExclusive>(input, output, SumOp<T>());
+    }
+
+    //  In-place exclusive scan, the input is overwritten with the result. Iterator ranges
+    //  are copied to a single accelerator array rather than separate input and output arrays.
+
+    template <int TileSize, typename InIt, typename Op>
+    inline void ExclusiveScanTiledInPlace(InIt first, InIt last, const Op& op)
+    {
+        typedef InIt::value_type T;
+
+        const int size = int(distance(first, last));
+        concurrency::array<T, 1> data(size, first, last);
+        details::ScanTiledInPlace<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(data), op);
+        copy(data, first);
+    }
+
+    template <int TileSize, typename InIt>
+    inline void ExclusiveScanTiledInPlace(InIt first, InIt last)
+    {
+        typedef InIt::value_type T;
+
+        ExclusiveScanTiledInPlace<TileSize>(first, last, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void ExclusiveScanTiledInPlace(concurrency::array_view<T, 1> data, const Op& op)
+    {
+        details::ScanTiledInPlace<TileSize, details::kExclusive>(data, op);
+    }
+
+    template <int TileSize, typename T>
+    inline void ExclusiveScanTiledInPlace(concurrency::array_view<T, 1> data)
+    {
+        details::ScanTiledInPlace<TileSize, details::kExclusive>(data, SumOp<T>());
     }
 
     //===============================================================================
     // Inclusive scan, output element at i contains the sum of elements [0]...[i].
     //===============================================================================
 
-    template <int TileSize, typename InIt, typename OutIt>
-    inline void InclusiveScanTiled(InIt first, InIt last, OutIt outFirst)
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void InclusiveScanTiled(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -57,14 +107,62 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);       
-        details::ScanTiled<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanTiled<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(out, outFirst);
     }
 
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void InclusiveScanTiled(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        InclusiveScanTiled<TileSize>(first, last, outFirst, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void InclusiveScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanTiled<TileSize, details::kInclusive>(input, output, op);
+    }
+
     template <int TileSize, typename T>
     inline void InclusiveScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanTiled<TileSize, details::kInclusive>(input, output);
+        details::ScanTiled<TileSize, details::kInclusive>(input, output, SumOp<T>());
+    }
+
+    //  In-place inclusive scan, the input is overwritten with the result. Iterator ranges
+    //  are copied to a single accelerator array rather than separate input and output arrays.
+
+    template <int TileSize, typename InIt, typename Op>
+    inline void InclusiveScanTiledInPlace(InIt first, InIt last, const Op& op)
+    {
+        typedef InIt::value_type T;
+
+        const int size = int(distance(first, last));
+        concurrency::array<T, 1> data(size, first, last);
+        details::ScanTiledInPlace<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(data), op);
+        copy(data, first);
+    }
+
+    template <int TileSize, typename InIt>
+    inline void InclusiveScanTiledInPlace(InIt first, InIt last)
+    {
+        typedef InIt::value_type T;
+
+        InclusiveScanTiledInPlace<TileSize>(first, last, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void InclusiveScanTiledInPlace(concurrency::array_view<T, 1> data, const Op& op)
+    {
+        details::ScanTiledInPlace<TileSize, details::kInclusive>(data, op);
+    }
+
+    template <int TileSize, typename T>
+    inline void InclusiveScanTiledInPlace(concurrency::array_view<T, 1> data)
+    {
+        details::ScanTiledInPlace<TileSize, details::kInclusive>(data, SumOp<T>());
     }
 
     //===============================================================================
@@ -73,12 +171,29 @@ namespace Extras
 
     namespace details
     {
-        template <int TileSize, int Mode, typename T>
-        void ScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
+        template <int TileSize, int Mode, typename T, typename Op>
+        void ScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+        {
+            assert(input.extent[0] == output.extent[0]);
+
+            output.discard_data();
+            ComputeScanTiled<TileSize, Mode>(input, output, op);
+        }
+
+        // Each element is only written by the thread that read it, after the whole tile 
+        // has been read, so input and output may be the same data.
+
+        template <int TileSize, int Mode, typename T, typename Op>
+        void ScanTiledInPlace(concurrency::array_view<T, 1> data, const Op& op)
+        {
+            ComputeScanTiled<TileSize, Mode>(data, data, op);
+        }
+
+        template <int TileSize, int Mode, typename T, typename Op>
+        void ComputeScanTiled(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
         {
             static_assert((Mode == details::kExclusive || Mode == details::kInclusive), "Mode must be either inclusive or exclusive.");
             static_assert(IsPowerOfTwoStatic<TileSize>::result, "TileSize must be a power of 2.");
-            assert(input.extent[0] == output.extent[0]);
             assert(input.extent[0] > 0);
 
             const int elementCount = input.extent[0];
@@ -86,32 +201,29 @@ namespace Extras
 
             // Compute tile-wise scans and reductions.
             concurrency::array<T> tileSums(tileCount);
-            details::ComputeTilewiseExclusiveScanTiled<TileSize, Mode>(concurrency::array_view<const T>(input), concurrency::array_view<T>(output), concurrency::array_view<T>(tileSums));
+            details::ComputeTilewiseExclusiveScanTiled<TileSize, Mode>(concurrency::array_view<const T>(input), concurrency::array_view<T>(output), concurrency::array_view<T>(tileSums), op);
 
             if (tileCount > 1)
             {
-                // Calculate the initial value of each tile based on the tileSums.
-                concurrency::array<T> tmp(tileSums.extent);
-                ScanTiled<TileSize, details::kExclusive>(concurrency::array_view<T>(tileSums), concurrency::array_view<T>(tmp));
-                output.discard_data();
-                parallel_for_each(concurrency::extent<1>(elementCount), [=, &tileSums, &tmp] (concurrency::index<1> idx) restrict (amp) 
+                // Calculate the initial value of each tile based on the tileSums, in place.
+                ScanTiledInPlace<TileSize, details::kExclusive>(concurrency::array_view<T>(tileSums), op);
+                parallel_for_each(concurrency::extent<1>(elementCount), [=, &tileSums] (concurrency::index<1> idx) restrict (amp) 
                 {
                     int tileIdx = idx[0] / TileSize;
-                    output[idx] += tmp[tileIdx];
+                    output[idx] = op(tileSums[tileIdx], output[idx]);
                 });
             }
         }
 
         // For each tile calculate the inclusive scan.
 
-        template <int TileSize, int Mode, typename T>
-        void ComputeTilewiseExclusiveScanTiled(concurrency::array_view<const T> input, concurrency::array_view<T> tilewiseOutput, concurrency::array_view<T> tileSums)
+        template <int TileSize, int Mode, typename T, typename Op>
+        void ComputeTilewiseExclusiveScanTiled(concurrency::array_view<const T> input, concurrency::array_view<T> tilewiseOutput, concurrency::array_view<T> tileSums, const Op& op)
         {
             const int elementCount = input.extent[0];
             const int tileCount = (elementCount + TileSize - 1) / TileSize;
             const int threadCount = tileCount * TileSize;
 
-            tilewiseOutput.discard_data();
             parallel_for_each(concurrency::extent<1>(threadCount).tile<TileSize>(), [=](concurrency::tiled_index<TileSize> tidx) restrict(amp) 
             {
                 const int tid = tidx.local[0];
@@ -126,7 +238,7 @@ namespace Extras
                 if (gid < elementCount)
                 {
                     if (tid >= 1)
-                        tileData[outIdx][tid] = input[gid - 1] + input[gid];
+                        tileData[outIdx][tid] = op(input[gid - 1], input[gid]);
                     else 
                         tileData[outIdx][tid] = input[gid];
                 }
@@ -139,7 +251,7 @@ namespace Extras
                     if (gid < elementCount) 
                     {
                         if (tid >= offset)
-                            tileData[outIdx][tid] = tileData[inIdx][tid - offset] + tileData[inIdx][tid];
+                            tileData[outIdx][tid] = op(tileData[inIdx][tid - offset], tileData[inIdx][tid]);
                         else 
                             tileData[outIdx][tid] = tileData[inIdx][tid];
                     }
@@ -155,13 +267,14 @@ namespace Extras
                         tilewiseOutput[gid] = tileData[outIdx][tid] ;
                     else
                         if (tid == 0)
-                            tilewiseOutput[gid] = T(0);
+                            tilewiseOutput[gid] = op.Identity();
                         else
                             tilewiseOutput[gid] = tileData[outIdx][tid - 1] ;
                 }
-                // Last thread in tile updates the tileSums.
-                if (tid == TileSize - 1)
-                    tileSums[tidx.tile[0]] = tileData[outIdx][tid - 1] + + input[gid];
+                // Last thread in tile updates the tileSums, the inclusive total. The sum of a 
+                // partial last tile is never used.
+                if ((tid == TileSize - 1) && (gid < elementCount))
+                    tileSums[tidx.tile[0]] = tileData[outIdx][tid];
             });
         }
 
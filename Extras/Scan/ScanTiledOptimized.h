@@ -19,6 +19,7 @@
 #include <amp.h>
 #include <assert.h>
 
+#include "ScanOperators.h"
 #include "Utilities.h"
 
 namespace Extras
@@ -27,8 +28,8 @@ namespace Extras
     // Exclusive scan, output element at i contains the sum of elements [0]...[i-1].
     //===============================================================================
 
-    template <int TileSize, typename InIt, typename OutIt>
-    inline void ExclusiveScanOptimized(InIt first, InIt last, OutIt outFirst)
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void ExclusiveScanOptimized(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -36,22 +37,70 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);
-        details::ScanOptimized<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanOptimized<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(out, outFirst);
     }
 
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void ExclusiveScanOptimized(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        ExclusiveScanOptimized<TileSize>(first, last, outFirst, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void ExclusiveScanOptimized(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanOptimized<TileSize, details::kExclusive, T>(input, output, op);
+    }
+
     template <int TileSize, typename T>  
     inline void ExclusiveScanOptimized(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanOptimized<TileSize, details::kExclusive, T>(input, output);
+        details::ScanOptimized<TileSize, details::kExclusive, T>(input, output, SumOp<T>());
+    }
+
+    //  In-place exclusive scan, the input is overwritten with the result. Iterator ranges
+    //  are copied to a single accelerator array rather than separate input and output arrays.
+
+    template <int TileSize, typename InIt, typename Op>
+    inline void ExclusiveScanOptimizedInPlace(InIt first, InIt last, const Op& op)
+    {
+        typedef InIt::value_type T;
+
+        const int size = int(distance(first, last));
+        concurrency::array<T, 1> data(size, first, last);
+        details::ScanOptimizedInPlace<TileSize, details::kExclusive>(concurrency::array_view<T, 1>(data), op);
+        copy(data, first);
+    }
+
+    template <int TileSize, typename InIt>
+    inline void ExclusiveScanOptimizedInPlace(InIt first, InIt last)
+    {
+        typedef InIt::value_type T;
+
+        ExclusiveScanOptimizedInPlace<TileSize>(first, last, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void ExclusiveScanOptimizedInPlace(concurrency::array_view<T, 1> data, const Op& op)
+    {
+        details::ScanOptimizedInPlace<TileSize, details::kExclusive>(data, op);
+    }
+
+    template <int TileSize, typename T>
+    inline void ExclusiveScanOptimizedInPlace(concurrency::array_view<T, 1> data)
+    {
+        details::ScanOptimizedInPlace<TileSize, details::kExclusive>(data, SumOp<T>());
     }
 
     //===============================================================================
     // Inclusive scan, output element at i contains the sum of elements [0]...[i].
     //===============================================================================
 
-    template <int TileSize, typename InIt, typename OutIt>
-    inline void InclusiveScanOptimized(InIt first, InIt last, OutIt outFirst)
+    template <int TileSize, typename InIt, typename OutIt, typename Op>
+    inline void InclusiveScanOptimized(InIt first, InIt last, OutIt outFirst, const Op& op)
     {
         typedef InIt::value_type T;
 
@@ -59,14 +108,62 @@ namespace Extras
         concurrency::array<T, 1> in(size);
         concurrency::array<T, 1> out(size);
         copy(first, last, in);      
-        details::ScanOptimized<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out));
+        details::ScanOptimized<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(in), concurrency::array_view<T, 1>(out), op);
         copy(out, outFirst);
     }
 
+    template <int TileSize, typename InIt, typename OutIt>
+    inline void InclusiveScanOptimized(InIt first, InIt last, OutIt outFirst)
+    {
+        typedef InIt::value_type T;
+
+        InclusiveScanOptimized<TileSize>(first, last, outFirst, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void InclusiveScanOptimized(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output, const Op& op)
+    {
+        details::ScanOptimized<TileSize, details::kInclusive, T>(input, output, op);
+    }
+
     template <int TileSize, typename T>  
     inline void InclusiveScanOptimized(concurrency::array_view<T, 1> input, concurrency::array_view<T, 1> output)
     {
-        details::ScanOptimized<TileSize, details::kInclusive, T>(input, output);
+        details::ScanOptimized<TileSize, details::kInclusive, T>(input, output, SumOp<T>());
+    }
+
+    //  In-place inclusive scan, the input is overwritten with the result. Iterator ranges
+    //  are copied to a single accelerator array rather than separate input and output arrays.
+
+    template <int TileSize, typename InIt, typename Op>
+    inline void InclusiveScanOptimizedInPlace(InIt first, InIt last, const Op& op)
+    {
+        typedef InIt::value_type T;
+
+        const int size = int(distance(first, last));
+        concurrency::array<T, 1> data(size, first, last);
+        details::ScanOptimizedInPlace<TileSize, details::kInclusive>(concurrency::array_view<T, 1>(data), op);
+        copy(data, first);
+    }
+
+    template <int TileSize, typename InIt>
+    inline void InclusiveScanOptimizedInPlace(InIt first, InIt last)
+    {
+        typedef InIt::value_type T;
+
+        InclusiveScanOptimizedInPlace<TileSize>(first, last, SumOp<T>());
+    }
+
+    template <int TileSize, typename T, typename Op>
+    inline void InclusiveScanOptimizedInPlace(concurrency::array_view<T, 1> data, const Op& op)
+    {
+        details::ScanOptimizedInPlace<TileSize, details::kInclusive>(data, op);
+    }
+
+    template <int TileSize, typename T>
+    inline void InclusiveScanOptimizedInPlace(concurrency::array_view<T, 1> data)
+    {
+        details::ScanOptimizedInPlace<TileSize, details::kInclusive>(data, SumOp<T>());
     }
 
     //===============================================================================
@@ -75,12 +172,6 @@ namespace Extras
 
     namespace details
     {
-        enum ScanMode
-        {
-            kExclusive = 0,
-            kInclusive = 1
-        };
-
         template <int BlockSize, int LogBlockSize>
         inline int ConflictFreeOffset(const int n) restrict(amp)
         {
@@ -91,8 +182,26 @@ namespace Extras
         //
         // http.developer.nvidia.com/GPUGems3/gpugems3_ch39.html
 
-        template <int TileSize, int Mode, typename T>  
-        void ScanOptimized(const concurrency::array_view<T, 1>& input, concurrency::array_view<T, 1>& output)
+        template <int TileSize, int Mode, typename T, typename Op>  
+        void ScanOptimized(const concurrency::array_view<T, 1>& input, concurrency::array_view<T, 1>& output, const Op& op)
+        {
+            assert(input.extent[0] == output.extent[0]);
+
+            output.discard_data();
+            ComputeScanOptimized<TileSize, Mode>(input, output, op);
+        }
+
+        // Each thread reads both its elements before the sweeps and only writes them back
+        // afterwards, so input and output may be the same data.
+
+        template <int TileSize, int Mode, typename T, typename Op>  
+        void ScanOptimizedInPlace(concurrency::array_view<T, 1> data, const Op& op)
+        {
+            ComputeScanOptimized<TileSize, Mode>(data, data, op);
+        }
+
+        template <int TileSize, int Mode, typename T, typename Op>  
+        void ComputeScanOptimized(const concurrency::array_view<T, 1>& input, concurrency::array_view<T, 1>& output, const Op& op)
         {
             const int domainSize = TileSize * 2;
             const int elementCount = input.extent[0];
@@ -101,39 +210,34 @@ namespace Extras
             static_assert((Mode == details::kExclusive || Mode == details::kInclusive), "Mode must be either inclusive or exclusive.");
             static_assert(IsPowerOfTwoStatic<TileSize>::result, "TileSize must be a power of 2.");
             assert(elementCount > 0);
-            assert(elementCount == output.extent[0]);
-            assert((elementCount / domainSize) >= 1);
 
             // Compute scan for each tile and store their total values in tileSums
             concurrency::array<T> tileSums(tileCount);
-            details::ComputeTilewiseExclusiveScanOptimized<TileSize, Mode>(concurrency::array_view<const T>(input), output, concurrency::array_view<T>(tileSums));
+            details::ComputeTilewiseExclusiveScanOptimized<TileSize, Mode>(concurrency::array_view<const T>(input), output, concurrency::array_view<T>(tileSums), op);
         
             if (tileCount > 1)
             {
-                // Calculate the initial value of each tile based on the tileSums.
-                concurrency::array<T> tileSumScan(tileSums.extent);
-                ScanTiled<TileSize, details::kExclusive>(concurrency::array_view<T>(tileSums), concurrency::array_view<T>(tileSumScan));
+                // Calculate the initial value of each tile based on the tileSums, in place.
+                ScanTiledInPlace<TileSize, details::kExclusive>(concurrency::array_view<T>(tileSums), op);
                 // Add the tileSums all the elements in each tile except the first tile.
-                output.discard_data();
-                parallel_for_each(concurrency::extent<1>(elementCount - domainSize), [=, &tileSumScan] (concurrency::index<1> idx) restrict (amp) 
+                parallel_for_each(concurrency::extent<1>(elementCount - domainSize), [=, &tileSums] (concurrency::index<1> idx) restrict (amp) 
                 {
                     const int tileIdx = (idx[0] + domainSize) / domainSize;
-                    output[idx + domainSize] += tileSumScan[tileIdx];
+                    output[idx + domainSize] = op(tileSums[tileIdx], output[idx + domainSize]);
                 });
             }
         }
 
-        template <int TileSize, int Mode, typename T>
+        template <int TileSize, int Mode, typename T, typename Op>
         void ComputeTilewiseExclusiveScanOptimized(const concurrency::array_view<const T, 1>& input, 
             concurrency::array_view<T>& tilewiseOutput, 
-            concurrency::array_view<T, 1>& tileSums)
+            concurrency::array_view<T, 1>& tileSums, const Op& op)
         {
             static const int domainSize = TileSize * 2;
             const int elementCount = input.extent[0];
-            const int tileCount = (elementCount + TileSize - 1) / TileSize;
+            const int tileCount = (elementCount + domainSize - 1) / domainSize;
             const int threadCount = tileCount * TileSize;
 
-            tilewiseOutput.discard_data();
             tileSums.discard_data();
             parallel_for_each(concurrency::extent<1>(threadCount).tile<TileSize>(), [=](concurrency::tiled_index<TileSize> tidx) restrict(amp) 
             {
@@ -142,13 +246,13 @@ namespace Extras
                 const int gidx2 = tidx.global[0] * 2;
                 tile_static T tileData[domainSize];
 
-                // Load data into tileData, load 2x elements per tile.
+                // Load data into tileData, load 2x elements per tile. Elements past the end 
+                // of the input are padded with the identity.
 
-                if (gidx2 + 1 < elementCount)
-                {
-                    tileData[tidx2] = input[gidx2];
-                    tileData[tidx2 + 1] = input[gidx2 + 1];
-                }
+                const T first = (gidx2 < elementCount) ? input[gidx2] : op.Identity();
+                const T second = (gidx2 + 1 < elementCount) ? input[gidx2 + 1] : op.Identity();
+                tileData[tidx2] = first;
+                tileData[tidx2 + 1] = second;
 
                 // Up sweep (reduce) phase.
 
@@ -160,14 +264,14 @@ namespace Extras
                     {
                         const int ai = offset * (tidx2 + 1) - 1;
                         const int bi = offset * (tidx2 + 2) - 1; 
-                        tileData[bi] += tileData[ai];
+                        tileData[bi] = op(tileData[ai], tileData[bi]);
                     }
                     offset *= 2;
                 }
                 
                 //  Zero highest element in tile
                 if (tid == 0) 
-                    tileData[domainSize - 1] = 0;
+                    tileData[domainSize - 1] = op.Identity();
                 
                 // Down sweep phase.
                 // Now: offset = domainSize
@@ -182,28 +286,23 @@ namespace Extras
                         const int bi = offset * (tidx2 + 2) - 1; 
                         T t = tileData[ai]; 
                         tileData[ai] = tileData[bi]; 
-                        tileData[bi] += t;
+                        tileData[bi] = op(tileData[bi], t);
                     }
                 }
                 tidx.barrier.wait_with_tile_static_memory_fence();
 
-                // Copy tile results out. For inclusive scan shift all elements left.
+                // Copy tile results out. For inclusive scan shift all elements left, the
+                // second element is calculated as the next one may be in the next tile.
 
-                if (gidx2 + 1 - (2 * Mode) < elementCount)
-                {
+                if (gidx2 < elementCount)
                     tilewiseOutput[gidx2] = tileData[tidx2 + Mode]; 
-                    tilewiseOutput[gidx2 + 1] = tileData[tidx2 + 1 + Mode];
-                }
+                if (gidx2 + 1 < elementCount)
+                    tilewiseOutput[gidx2 + 1] = (Mode == details::kInclusive) ? op(tileData[tidx2 + 1], second) : tileData[tidx2 + 1];
 
                 // Copy tile total out, this is the inclusive total.
 
                 if (tid == (TileSize - 1))
-                {
-                    // For inclusive scan calculate the last value
-                    if (Mode == details::kInclusive)
-                        tilewiseOutput[gidx2 + 1] = tileData[domainSize - 1] + input[gidx2 + 1];
-                    tileSums[tidx.tile[0]] = tileData[domainSize - 1] + input[gidx2 + 1];
-                }
+                    tileSums[tidx.tile[0]] = op(tileData[domainSize - 1], second);
             });
         }
     }
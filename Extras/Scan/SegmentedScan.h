@@ -0,0 +1,241 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <assert.h>
+
+#include "ScanOperators.h"
+#include "ScanLookBack.h"
+
+//===============================================================================
+//  Segmented scan running on CPU threads.
+//
+//  The input is divided into segments which are scanned independently, the scan
+//  starts again from each segment's first element. Segments are marked either by
+//  head flags, one per element and non-zero for the first element of a segment, 
+//  or by an ascending list of the offsets of the segments' first elements. The 
+//  first element of the input always starts a segment.
+//
+//  All the segments are scanned in a single pass with the decoupled look-back in
+//  ScanLookBack.h. The blocks' aggregates are combined with a segmented operator
+//  which drops the carry from earlier blocks at the first head it meets, so a 
+//  segment may span any number of blocks.
+//===============================================================================
+
+namespace Extras
+{
+    //===============================================================================
+    //  Exclusive segmented scan, output element at i contains the sum of the elements
+    //  from the start of its segment up to [i-1].
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename FlagIt, typename OutIt, typename Op>
+    inline void ExclusiveSegmentedScan(InIt first, InIt last, FlagIt headFlags, OutIt outFirst, const Op& op)
+    {
+        details::SegmentedScan<BlockSize, details::kExclusive>(first, last, outFirst, op, details::HeadFlagReader<FlagIt>(headFlags));
+    }
+
+    template <int BlockSize, typename InIt, typename FlagIt, typename OutIt>
+    inline void ExclusiveSegmentedScan(InIt first, InIt last, FlagIt headFlags, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        ExclusiveSegmentedScan<BlockSize>(first, last, headFlags, outFirst, SumOp<T>());
+    }
+
+    template <int BlockSize, typename InIt, typename OffsetIt, typename OutIt, typename Op>
+    inline void ExclusiveSegmentedScanByOffsets(InIt first, InIt last, OffsetIt offsetsFirst, OffsetIt offsetsLast, OutIt outFirst, const Op& op)
+    {
+        details::SegmentedScan<BlockSize, details::kExclusive>(first, last, outFirst, op, details::OffsetFlagReader<OffsetIt>(offsetsFirst, offsetsLast));
+    }
+
+    template <int BlockSize, typename InIt, typename OffsetIt, typename OutIt>
+    inline void ExclusiveSegmentedScanByOffsets(InIt first, InIt last, OffsetIt offsetsFirst, OffsetIt offsetsLast, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        ExclusiveSegmentedScanByOffsets<BlockSize>(first, last, offsetsFirst, offsetsLast, outFirst, SumOp<T>());
+    }
+
+    //===============================================================================
+    //  Inclusive segmented scan, output element at i contains the sum of the elements
+    //  from the start of its segment up to [i].
+    //===============================================================================
+
+    template <int BlockSize, typename InIt, typename FlagIt, typename OutIt, typename Op>
+    inline void InclusiveSegmentedScan(InIt first, InIt last, FlagIt headFlags, OutIt outFirst, const Op& op)
+    {
+        details::SegmentedScan<BlockSize, details::kInclusive>(first, last, outFirst, op, details::HeadFlagReader<FlagIt>(headFlags));
+    }
+
+    template <int BlockSize, typename InIt, typename FlagIt, typename OutIt>
+    inline void InclusiveSegmentedScan(InIt first, InIt last, FlagIt headFlags, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        InclusiveSegmentedScan<BlockSize>(first, last, headFlags, outFirst, SumOp<T>());
+    }
+
+    template <int BlockSize, typename InIt, typename OffsetIt, typename OutIt, typename Op>
+    inline void InclusiveSegmentedScanByOffsets(InIt first, InIt last, OffsetIt offsetsFirst, OffsetIt offsetsLast, OutIt outFirst, const Op& op)
+    {
+        details::SegmentedScan<BlockSize, details::kInclusive>(first, last, outFirst, op, details::OffsetFlagReader<OffsetIt>(offsetsFirst, offsetsLast));
+    }
+
+    template <int BlockSize, typename InIt, typename OffsetIt, typename OutIt>
+    inline void InclusiveSegmentedScanByOffsets(InIt first, InIt last, OffsetIt offsetsFirst, OffsetIt offsetsLast, OutIt outFirst)
+    {
+        typedef typename std::iterator_traits<InIt>::value_type T;
+
+        InclusiveSegmentedScanByOffsets<BlockSize>(first, last, offsetsFirst, offsetsLast, outFirst, SumOp<T>());
+    }
+
+    //===============================================================================
+    //  Implementation. Not supposed to be called directly.
+    //===============================================================================
+
+    namespace details
+    {
+        //  The combination of a run of elements, from its last segment head if it has one.
+
+        template <typename T>
+        struct SegmentedValue
+        {
+            T Value;
+            bool HasHead;
+        };
+
+        template <typename T>
+        inline SegmentedValue<T> MakeSegmentedValue(const T& value, bool hasHead)
+        {
+            SegmentedValue<T> result = { value, hasHead };
+            return result;
+        }
+
+        //  Combines two adjacent runs, right following left. Associative whenever op is.
+
+        template <typename T, typename Op>
+        class SegmentedOp
+        {
+        private:
+            Op m_op;
+
+        public:
+            explicit SegmentedOp(const Op& op) : m_op(op) { }
+
+            SegmentedValue<T> Identity() const { return MakeSegmentedValue(m_op.Identity(), false); }
+
+            SegmentedValue<T> operator()(const SegmentedValue<T>& left, const SegmentedValue<T>& right) const
+            {
+                if (right.HasHead)
+                    return right;
+                return MakeSegmentedValue(m_op(left.Value, right.Value), left.HasHead);
+            }
+        };
+
+        //  Fill flags with 1 for each element of a block that starts a segment and 0 
+        //  otherwise.
+
+        template <typename FlagIt>
+        class HeadFlagReader
+        {
+        private:
+            FlagIt m_headFlags;
+
+        public:
+            explicit HeadFlagReader(FlagIt headFlags) : m_headFlags(headFlags) { }
+
+            void operator()(int blockStart, int count, unsigned char* flags) const
+            {
+                for (int i = 0; i < count; ++i)
+                    flags[i] = (m_headFlags[blockStart + i]) ? 1 : 0;
+            }
+        };
+
+        template <typename OffsetIt>
+        class OffsetFlagReader
+        {
+        private:
+            OffsetIt m_offsetsFirst;
+            OffsetIt m_offsetsLast;
+
+        public:
+            OffsetFlagReader(OffsetIt offsetsFirst, OffsetIt offsetsLast) : m_offsetsFirst(offsetsFirst), m_offsetsLast(offsetsLast) { }
+
+            void operator()(int blockStart, int count, unsigned char* flags) const
+            {
+                std::fill(flags, flags + count, (unsigned char)0);
+                for (OffsetIt it = std::lower_bound(m_offsetsFirst, m_offsetsLast, blockStart); 
+                    (it != m_offsetsLast) && (*it < (blockStart + count)); ++it)
+                    flags[*it - blockStart] = 1;
+            }
+        };
+
+        template <int BlockSize, int Mode, typename InIt, typename OutIt, typename Op, typename FlagReader>
+        void SegmentedScan(InIt first, InIt last, OutIt outFirst, const Op& op, const FlagReader& readFlags)
+        {
+            typedef typename std::iterator_traits<InIt>::value_type T;
+            typedef SegmentedOp<T, Op> SegOp;
+
+            static_assert((Mode == details::kExclusive || Mode == details::kInclusive), "Mode must be either inclusive or exclusive.");
+            static_assert(BlockSize > 0, "BlockSize must be greater than zero.");
+
+            const int elementCount = int(std::distance(first, last));
+            assert(elementCount > 0);
+
+            const int blockCount = (elementCount + BlockSize - 1) / BlockSize;
+            const SegOp segmentedOp(op);
+            LookBackBlocks<SegmentedValue<T>>(blockCount, segmentedOp, [&](int b, const LookBackPublisher<SegmentedValue<T>, SegOp>& publish)
+            {
+                const int blockStart = b * BlockSize;
+                const int count = (std::min)(BlockSize, elementCount - blockStart);
+                const InIt blockFirst = first + blockStart;
+                const OutIt blockOutFirst = outFirst + blockStart;
+
+                unsigned char heads[BlockSize];
+                readFlags(blockStart, count, heads);
+
+                SegmentedValue<T> aggregate = segmentedOp.Identity();
+                for (int i = 0; i < count; ++i)
+                {
+                    if (heads[i])
+                        aggregate = MakeSegmentedValue(T(blockFirst[i]), true);
+                    else
+                        aggregate.Value = op(aggregate.Value, blockFirst[i]);
+                }
+
+                //  The carry is the identity for the first block so the first element
+                //  always behaves as a segment head.
+
+                T carry = publish(aggregate).Value;
+                for (int i = 0; i < count; ++i)
+                {
+                    const T value = blockFirst[i];
+                    if (heads[i])
+                        carry = op.Identity();
+                    if (Mode == details::kExclusive)
+                        blockOutFirst[i] = carry;
+                    carry = op(carry, value);
+                    if (Mode == details::kInclusive)
+                        blockOutFirst[i] = carry;
+                }
+            });
+        }
+    }
+}
@@ -16,9 +16,19 @@
 
 #include "stdafx.h"
 
+#include <psapi.h>
+#pragma comment (lib, "psapi.lib")
+
 #include "..\Scan\ScanSimple.h"
 #include "..\Scan\ScanTiled.h"
 #include "..\Scan\ScanTiledOptimized.h"
+#include "..\Scan\Scan.h"
+#include "..\Scan\ScanLookBack.h"
+#include "..\Scan\Compact.h"
+#include "..\Scan\RadixSort.h"
+#include "..\Scan\SegmentedScan.h"
+#include "..\Scan\Histogram.h"
+#include "..\Scan\RunLength.h"
 
 using namespace Extras;
 
@@ -66,10 +76,34 @@ public:
 
 typedef std::pair<std::shared_ptr<IScan>, std::wstring> ScanDescription;
 
-inline bool ValidateSizes(unsigned tileSize, unsigned elementCount);
+template <typename Func>
+void RunCpuScan(Benchmark& benchmark, accelerator_view& view, const std::wstring& scanName, const std::vector<int>& input, 
+    const std::vector<int>& expected, BenchmarkOpKind opKind, Func scan, const std::wstring& note = std::wstring());
+
+template <typename Func>
+void RunInPlaceScan(Benchmark& benchmark, accelerator_view& view, const std::wstring& scanName, const std::vector<int>& input, 
+    const std::vector<int>& expected, BenchmarkOpKind opKind, Func scan, const std::wstring& note);
+
+std::wstring FootprintNote(size_t bytes);
+
+void PrintPeakWorkingSet();
+
+template <typename Func>
+void RunCpuCompact(Benchmark& benchmark, accelerator_view& view, const std::wstring& compactName, 
+    const std::vector<int>& input, const std::vector<int>& expected, bool isStable, Func compact);
+
+template <typename K>
+void RunCpuSorts(Benchmark& benchmark, accelerator_view& view, const std::wstring& keyName, int elementCount);
+
+void RunCpuHistograms(Benchmark& benchmark, accelerator_view& view, int elementCount);
+
+void RunCpuRunLengths(Benchmark& benchmark, accelerator_view& view, int elementCount, int runLength);
 
 int _tmain(int argc, _TCHAR* argv[])
 {
+    BenchmarkOptions options;
+    options.Parse(argc, argv);
+
 #ifdef _DEBUG
     const size_t elementCount = 1024;
     const int tileSize = 64;
@@ -88,10 +122,7 @@ int _tmain(int argc, _TCHAR* argv[])
     std::wcout << "Running kernels with " << elementCount << " elements, " 
         << elementCount * sizeof(int) / 1024 << " KB of data ..."  << std::endl;    
     std::wcout << "Tile size:     " << tileSize << std::endl;
-
-    if (!ValidateSizes(2, elementCount))
-        std::wcout << "Tile size is not factor of element count. This will cause runtime errors." 
-        << std::endl;
+    std::wcout << "Warm-up runs:  " << options.WarmupRuns << ", repetitions: " << options.Repetitions << std::endl;
 
     accelerator defaultDevice;
     std::wcout << L"Using device : " << defaultDevice.get_description() << std::endl;
@@ -110,9 +141,10 @@ int _tmain(int argc, _TCHAR* argv[])
         ScanDescription(std::make_shared<TiledScan<tileSize>>(),            L"Tiled"),
         ScanDescription(std::make_shared<TiledOptScan<tileSize>>(),         L"Tiled Optimized") };
 
-    std::wcout << std::endl << "                                                           Total : Calc" << std::endl << std::endl;
-
     accelerator_view view = accelerator(accelerator::default_accelerator).default_view;
+    Benchmark benchmark(options, [&view]() { view.wait(); });
+    Benchmark::PrintHeader();
+
     for (ScanDescription s : scans)
     {
         IScan* scanImpl = s.first.get();
@@ -121,8 +153,7 @@ int _tmain(int argc, _TCHAR* argv[])
         std::fill(begin(input), end(input), 1);
         std::fill(begin(result), end(result), 0);
 
-        double computeTime = 0.0, totalTime = 0.0;
-        totalTime = JitAndTimeFunc(view, [&]()
+        const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
         {
             concurrency::array<int, 1> in(input.size());
             concurrency::array<int, 1> out(input.size());
@@ -134,27 +165,484 @@ int _tmain(int argc, _TCHAR* argv[])
             });
             copy(out, begin(result));
         });
-        if (!std::equal(begin(result), end(result), begin(expected)) && (scanName.compare(L"Overhead") != 0))
-            std::wcout << "FAILED:  " << scanName;
-        else     
-            std::wcout << "SUCCESS: " << scanName;
+        const bool isCorrect = std::equal(begin(result), end(result), begin(expected)) || (scanName.compare(L"Overhead") == 0);
+
+        //  Each scan reads the input and writes the output once and performs one addition
+        //  per element, except the overhead which does nothing. The footprint is the host 
+        //  input and result and the accelerator input and output.
+        const size_t ops = (scanName.compare(L"Overhead") == 0) ? 0 : elementCount;
+        benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", scanName, timing, 2 * elementCount * sizeof(int), elementCount,
+            ops, AcceleratorOps, FootprintNote(4 * elementCount * sizeof(int)));
+    }
+    std::wcout << std::endl;
+
+    //  The block size keeps each block in L2 while it is scanned.
+    RunCpuScan(benchmark, view, L"CPU sequential", input, expected, IntegerOps, [](const std::vector<int>& in, std::vector<int>& out)
+    {
+        std::partial_sum(begin(in), end(in), begin(out));
+    }, FootprintNote(2 * elementCount * sizeof(int)));
+    RunCpuScan(benchmark, view, L"CPU decoupled look-back", input, expected, IntegerOps, [](const std::vector<int>& in, std::vector<int>& out)
+    {
+        InclusiveScanLookBack<16 * 1024>(begin(in), end(in), begin(out));
+    }, FootprintNote(2 * elementCount * sizeof(int)));
+    std::wcout << std::endl;
+
+    //  In-place scans of host data need half the memory. The accelerator scans copy the 
+    //  data to one array rather than an input and an output array.
+    RunInPlaceScan(benchmark, view, L"CPU decoupled look-back in place", input, expected, IntegerOps, [](std::vector<int>& data)
+    {
+        InclusiveScanLookBackInPlace<16 * 1024>(begin(data), end(data));
+    }, FootprintNote(elementCount * sizeof(int)));
+    RunInPlaceScan(benchmark, view, L"Tiled in place", input, expected, AcceleratorOps, [](std::vector<int>& data)
+    {
+        InclusiveScanTiledInPlace<tileSize>(begin(data), end(data));
+    }, FootprintNote(2 * elementCount * sizeof(int)));
+    RunInPlaceScan(benchmark, view, L"Tiled Optimized in place", input, expected, AcceleratorOps, [](std::vector<int>& data)
+    {
+        InclusiveScanOptimizedInPlace<tileSize>(begin(data), end(data));
+    }, FootprintNote(2 * elementCount * sizeof(int)));
+    std::wcout << std::endl;
+
+    //  Scan host data either side of the point where Scan.h switches from the host to
+    //  the accelerator. The accelerator times include the copies.
+    const auto scanOpKind = [](int size) { return (size < details::kScanHostCutoff) ? IntegerOps : AcceleratorOps; };
+    const std::array<int, 5> crossoverSizes = { 1000, 8 * 1024 - 1, 32 * 1024 + 1, 128 * 1024 - 1, 512 * 1024 + 1 };
+    for (int crossoverSize : crossoverSizes)
+    {
+        std::vector<int> crossoverInput(crossoverSize, 1);
+        std::vector<int> crossoverExpected(crossoverSize);
+        std::iota(begin(crossoverExpected), end(crossoverExpected), 1);
+        std::wostringstream suffix;
+        suffix << L" " << crossoverSize;
 
-        std::wcout.width(std::max(0U, 55 - scanName.length()));
-        std::wcout << std::right << std::fixed << std::setprecision(2) << totalTime << " : " << computeTime << " (ms)"  << std::endl;        
+        RunCpuScan(benchmark, view, L"CPU sequential" + suffix.str(), crossoverInput, crossoverExpected, IntegerOps, [](const std::vector<int>& in, std::vector<int>& out)
+        {
+            std::partial_sum(begin(in), end(in), begin(out));
+        });
+        RunCpuScan(benchmark, view, L"Tiled Optimized with copies" + suffix.str(), crossoverInput, crossoverExpected, AcceleratorOps, [](const std::vector<int>& in, std::vector<int>& out)
+        {
+            InclusiveScanOptimized<tileSize>(begin(in), end(in), begin(out));
+        });
+        RunCpuScan(benchmark, view, L"Scan" + suffix.str(), crossoverInput, crossoverExpected, scanOpKind(crossoverSize), [](const std::vector<int>& in, std::vector<int>& out)
+        {
+            Extras::InclusiveScan<tileSize>(begin(in), end(in), begin(out));
+        });
     }
     std::wcout << std::endl;
+
+    //  Scan equal length segments, either one InclusiveScanOptimized call per segment
+    //  or a single segmented scan over all of them.
+    const int segmentSize = (std::max)(int(elementCount / 32), 2 * tileSize);
+    std::vector<int> segmentHeads(elementCount, 0);
+    std::vector<int> segmentOffsets;
+    std::vector<int> segmentedExpected(elementCount);
+    for (int s = 0; s < int(elementCount); s += segmentSize)
+    {
+        segmentHeads[s] = 1;
+        segmentOffsets.push_back(s);
+        std::iota(begin(segmentedExpected) + s, begin(segmentedExpected) + s + segmentSize, 1);
+    }
+
+    {
+        const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+        {
+            concurrency::array<int, 1> in(input.size());
+            concurrency::array<int, 1> out(input.size());
+            copy(begin(input), end(input), in);
+            array_view<int, 1> inView(in);
+            array_view<int, 1> outView(out);
+
+            computeTime = TimeFunc(view, [&]()
+            {
+                for (int s = 0; s < int(elementCount); s += segmentSize)
+                    InclusiveScanOptimized<tileSize>(inView.section(s, segmentSize), outView.section(s, segmentSize));
+            });
+            copy(out, begin(result));
+        });
+        const bool isCorrect = std::equal(begin(result), end(result), begin(segmentedExpected));
+        benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", L"Tiled Optimized per segment", timing, 2 * elementCount * sizeof(int), elementCount,
+            elementCount, AcceleratorOps);
+    }
+    RunCpuScan(benchmark, view, L"CPU segmented head flags", input, segmentedExpected, IntegerOps, [&segmentHeads](const std::vector<int>& in, std::vector<int>& out)
+    {
+        InclusiveSegmentedScan<16 * 1024>(begin(in), end(in), begin(segmentHeads), begin(out));
+    });
+    RunCpuScan(benchmark, view, L"CPU segmented offsets", input, segmentedExpected, IntegerOps, [&segmentOffsets](const std::vector<int>& in, std::vector<int>& out)
+    {
+        InclusiveSegmentedScanByOffsets<16 * 1024>(begin(in), end(in), begin(segmentOffsets), end(segmentOffsets), begin(out));
+    });
+    std::wcout << std::endl;
+
+    //  Compact pseudo-random values, keeping about half of them so that the branch in 
+    //  the scatter is unpredictable.
+    std::vector<int> values(elementCount);
+    int i = 0;
+    std::generate(begin(values), end(values), [&i]() { return int((i++ * 2654435761u) >> 8); });
+    const auto isSelected = [](int x) { return (x & 1) != 0; };
+    std::vector<int> selected;
+    std::copy_if(begin(values), end(values), std::back_inserter(selected), isSelected);
+
+    RunCpuCompact(benchmark, view, L"CPU std::copy_if", values, selected, true, [=](const std::vector<int>& in, std::vector<int>& out)
+    {
+        return int(std::copy_if(begin(in), end(in), begin(out), isSelected) - begin(out));
+    });
+    RunCpuCompact(benchmark, view, L"CPU compact", values, selected, true, [=](const std::vector<int>& in, std::vector<int>& out)
+    {
+        return int(CopyIf<16 * 1024>(begin(in), end(in), begin(out), isSelected) - begin(out));
+    });
+    RunCpuCompact(benchmark, view, L"CPU unstable compact", values, selected, false, [=](const std::vector<int>& in, std::vector<int>& out)
+    {
+        return int(UnstableCopyIf<16 * 1024>(begin(in), end(in), begin(out), isSelected) - begin(out));
+    });
+    std::wcout << std::endl;
+
+    //  100M 64-bit keys take 800MB for each of the input, expected and result vectors, more
+    //  than fits in a 32-bit process alongside the sort's own buffers.
+
+#if defined(_DEBUG)
+    const std::array<int, 1> sortSizes = { 64 * 1024 };
+#elif defined(_WIN64)
+    const std::array<int, 3> sortSizes = { 1000000, 10000000, 100000000 };
+#else
+    const std::array<int, 2> sortSizes = { 1000000, 10000000 };
+#endif
+    for (int sortSize : sortSizes)
+    {
+        RunCpuSorts<unsigned int>(benchmark, view, L"32-bit", sortSize);
+        RunCpuSorts<unsigned long long>(benchmark, view, L"64-bit", sortSize);
+        std::wcout << std::endl;
+    }
+
+    RunCpuHistograms(benchmark, view, int(elementCount) * 8);
+    std::wcout << std::endl;
+    RunCpuRunLengths(benchmark, view, int(elementCount) * 8, 4);
+    RunCpuRunLengths(benchmark, view, int(elementCount) * 8, 1000);
+    std::wcout << std::endl;
+
+    PrintPeakWorkingSet();
+    if (options.Roofline)
+        PrintRoofline(benchmark.Records(), MeasureMachinePeaks());
+    benchmark.WriteOutputs();
     return 0;
 }
 
 //----------------------------------------------------------------------------
-//  Ensure that the reduction can repeatedly divide the elements by tile size.
+//  Time an inclusive scan of host data, reading from and writing to host 
+//  memory. Like the accelerator scans, it reads the input and writes the 
+//  output once and performs one addition per element. Scans which copy the
+//  data to an accelerator pass AcceleratorOps as their opKind.
 //----------------------------------------------------------------------------
 
-inline bool ValidateSizes(unsigned tileSize, unsigned elementCount)
+template <typename Func>
+void RunCpuScan(Benchmark& benchmark, accelerator_view& view, const std::wstring& scanName, const std::vector<int>& input, 
+    const std::vector<int>& expected, BenchmarkOpKind opKind, Func scan, const std::wstring& note)
 {
-    while ((elementCount % tileSize) == 0) 
+    std::vector<int> result(input.size());
+    const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
     {
-        elementCount /= tileSize;
+        std::fill(begin(result), end(result), 0);
+        computeTime = TimeFunc(view, [&]()
+        {
+            scan(input, result);
+        });
+    });
+    const bool isCorrect = std::equal(begin(result), end(result), begin(expected));
+    benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", scanName, timing, 
+        2 * input.size() * sizeof(int), input.size(), input.size(), opKind, note);
+}
+
+//----------------------------------------------------------------------------
+//  Time an inclusive scan which overwrites its input. Each run scans a fresh 
+//  copy of the input.
+//----------------------------------------------------------------------------
+
+template <typename Func>
+void RunInPlaceScan(Benchmark& benchmark, accelerator_view& view, const std::wstring& scanName, const std::vector<int>& input, 
+    const std::vector<int>& expected, BenchmarkOpKind opKind, Func scan, const std::wstring& note)
+{
+    std::vector<int> data(input.size());
+    const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+    {
+        std::copy(begin(input), end(input), begin(data));
+        computeTime = TimeFunc(view, [&]()
+        {
+            scan(data);
+        });
+    });
+    const bool isCorrect = (data == expected);
+    benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", scanName, timing, 
+        2 * input.size() * sizeof(int), input.size(), input.size(), opKind, note);
+}
+
+//----------------------------------------------------------------------------
+//  The estimated memory footprint of a run as a note for its row. This is 
+//  computed from the host and accelerator buffers the size of the input, 
+//  excluding the much smaller tile sums and block descriptors, not measured.
+//----------------------------------------------------------------------------
+
+std::wstring FootprintNote(size_t bytes)
+{
+    std::wostringstream note;
+    note << L"est. footprint " << std::fixed << std::setprecision(1) << (bytes / (1024.0 * 1024.0)) << L" MB";
+    return note.str();
+}
+
+//----------------------------------------------------------------------------
+//  The measured peak working set of the whole process. Windows only keeps 
+//  the high water mark since the process started, so it can't be split 
+//  between rows. Accelerator memory on a discrete GPU is not included.
+//----------------------------------------------------------------------------
+
+void PrintPeakWorkingSet()
+{
+    PROCESS_MEMORY_COUNTERS counters = { sizeof(counters) };
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return;
+    std::wcout << L"Peak working set of the process " << std::fixed << std::setprecision(1) 
+        << (counters.PeakWorkingSetSize / (1024.0 * 1024.0)) << L" MB" << std::endl;
+    std::wcout.unsetf(std::ios_base::floatfield);
+}
+
+//----------------------------------------------------------------------------
+//  Time a stream compaction on the CPU. It reads the input once and writes only
+//  the selected elements. Each element takes two integer operations, the test 
+//  and adding it to the count or output position. The output of an unstable 
+//  compaction and the expected output are both sorted before they are compared.
+//----------------------------------------------------------------------------
+
+template <typename Func>
+void RunCpuCompact(Benchmark& benchmark, accelerator_view& view, const std::wstring& compactName, 
+    const std::vector<int>& input, const std::vector<int>& expected, bool isStable, Func compact)
+{
+    std::vector<int> result(input.size());
+    int count = 0;
+    const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+    {
+        std::fill(begin(result), end(result), 0);
+        computeTime = TimeFunc(view, [&]()
+        {
+            count = compact(input, result);
+        });
+    });
+    std::vector<int> ordered(expected);
+    if (!isStable)
+    {
+        std::sort(begin(ordered), end(ordered));
+        std::sort(begin(result), begin(result) + count);
+    }
+    const bool isCorrect = (count == int(ordered.size())) && std::equal(begin(ordered), end(ordered), begin(result));
+    benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", compactName, timing, 
+        (input.size() + expected.size()) * sizeof(int), input.size(), 2 * input.size(), IntegerOps);
+}
+
+//----------------------------------------------------------------------------
+//  Time sorts of pseudo-random keys on the CPU. Each sort is given a fresh copy
+//  of the keys. The bytes are one read and one write of the keys, the least any
+//  sort can move. The operations are those of the sort's algorithm, see 
+//  RunCpuSorts.
+//----------------------------------------------------------------------------
+
+template <typename K, typename Func>
+void RunCpuSort(Benchmark& benchmark, accelerator_view& view, const std::wstring& sortName, 
+    const std::vector<K>& input, const std::vector<K>& expected, size_t ops, Func sort)
+{
+    std::vector<K> result(input.size());
+    const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+    {
+        std::copy(begin(input), end(input), begin(result));
+        computeTime = TimeFunc(view, [&]()
+        {
+            sort(result);
+        });
+    });
+    const bool isCorrect = (expected == result);
+    benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", sortName, timing, 
+        2 * input.size() * sizeof(K), input.size(), ops, IntegerOps);
+}
+
+template <typename K>
+void RunCpuSorts(Benchmark& benchmark, accelerator_view& view, const std::wstring& keyName, int elementCount)
+{
+    std::vector<K> input(elementCount);
+    unsigned long long i = 0;
+    std::generate(begin(input), end(input), [&i]() { return K((++i * 6364136223846793005ull) >> 17); });
+    std::vector<K> expected(input);
+    std::sort(begin(expected), end(expected));
+
+    std::wostringstream suffix;
+    suffix << L" " << keyName << L" ";
+    if (elementCount >= 1000000)
+        suffix << (elementCount / 1000000) << L"M";
+    else
+        suffix << (elementCount / 1024) << L"K";
+
+    //  The comparison sorts make about n log2(n) comparisons. Each pass of the radix sort
+    //  takes three operations per key to count its digit, a shift, a mask and an increment,
+    //  and three more to scatter it, with one pass per byte of the key.
+    const size_t comparisons = size_t(elementCount * std::log(double(elementCount)) / std::log(2.0));
+    const size_t radixOps = 6 * sizeof(K) * size_t(elementCount);
+
+    RunCpuSort(benchmark, view, L"CPU std::sort" + suffix.str(), input, expected, comparisons, [](std::vector<K>& keys)
+    {
+        std::sort(begin(keys), end(keys));
+    });
+    RunCpuSort(benchmark, view, L"CPU parallel_sort" + suffix.str(), input, expected, comparisons, [](std::vector<K>& keys)
+    {
+        concurrency::parallel_sort(begin(keys), end(keys));
+    });
+    RunCpuSort(benchmark, view, L"CPU radix sort" + suffix.str(), input, expected, radixOps, [](std::vector<K>& keys)
+    {
+        RadixSort<64 * 1024>(begin(keys), end(keys));
+    });
+
+    //  The values are reset to their indices inside the timed region, which costs one
+    //  extra write of the values.
+    std::vector<int> values(input.size());
+    RunCpuSort(benchmark, view, L"CPU radix sort by key" + suffix.str(), input, expected, radixOps, [&values](std::vector<K>& keys)
+    {
+        std::iota(begin(values), end(values), 0);
+        RadixSortByKey<64 * 1024>(begin(keys), end(keys), begin(values));
+    });
+}
+
+//----------------------------------------------------------------------------
+//  Time histograms of pseudo-random 8-bit values into 256 bins, like the 
+//  histogram of an image channel. The bytes are one read of the input and each
+//  element takes one increment.
+//----------------------------------------------------------------------------
+
+void RunCpuHistograms(Benchmark& benchmark, accelerator_view& view, int elementCount)
+{
+    std::vector<unsigned char> input(elementCount);
+    unsigned int i = 0;
+    std::generate(begin(input), end(input), [&i]() { return static_cast<unsigned char>((++i * 2654435761u) >> 24); });
+    std::vector<int> expected(256, 0);
+    std::for_each(begin(input), end(input), [&expected](unsigned char x) { ++expected[x]; });
+
+    const auto runHistogram = [&](const std::wstring& name, const std::function<void (std::vector<int>&)>& histogram)
+    {
+        std::vector<int> result(256);
+        const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+        {
+            computeTime = TimeFunc(view, [&]()
+            {
+                histogram(result);
+            });
+        });
+        const bool isCorrect = (expected == result);
+        benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", name, timing, input.size(), input.size(), input.size(), IntegerOps);
+    };
+
+    runHistogram(L"CPU sequential histogram", [&input](std::vector<int>& counts)
+    {
+        std::fill(begin(counts), end(counts), 0);
+        std::for_each(begin(input), end(input), [&counts](unsigned char x) { ++counts[x]; });
+    });
+    runHistogram(L"CPU histogram", [&input](std::vector<int>& counts)
+    {
+        Histogram<64 * 1024>(begin(input), end(input), 256, begin(counts));
+    });
+}
+
+//----------------------------------------------------------------------------
+//  Time run-length encoding and decoding of runs averaging runLength elements.
+//  The bytes are one read of the input and one write of the output. Encoding
+//  takes two operations per element, comparing it with the one before and 
+//  counting it, and decoding one, counting it out of its run.
+//----------------------------------------------------------------------------
+
+void RunCpuRunLengths(Benchmark& benchmark, accelerator_view& view, int elementCount, int runLength)
+{
+    std::vector<int> input(elementCount);
+    unsigned int i = 0;
+    int value = 0;
+    std::generate(begin(input), end(input), [&]() 
+    { 
+        if (((++i * 2654435761u) >> 8) % runLength == 0)
+            ++value;
+        return value;
+    });
+
+    std::vector<int> expectedValues;
+    std::vector<int> expectedLengths;
+    for (int j = 0; j < elementCount; ++j)
+    {
+        if ((j == 0) || (input[j] != input[j - 1]))
+        {
+            expectedValues.push_back(input[j]);
+            expectedLengths.push_back(0);
+        }
+        ++expectedLengths.back();
     }
-    return elementCount < tileSize;
+    const size_t runCount = expectedValues.size();
+
+    std::wostringstream suffix;
+    suffix << L" runs of " << runLength;
+
+    const auto runEncode = [&](const std::wstring& name, const std::function<int (std::vector<int>&, std::vector<int>&)>& encode)
+    {
+        std::vector<int> values(input.size());
+        std::vector<int> lengths(input.size());
+        int count = 0;
+        const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+        {
+            computeTime = TimeFunc(view, [&]()
+            {
+                count = encode(values, lengths);
+            });
+        });
+        const bool isCorrect = (count == int(runCount)) && 
+            std::equal(begin(expectedValues), end(expectedValues), begin(values)) &&
+            std::equal(begin(expectedLengths), end(expectedLengths), begin(lengths));
+        benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", name + suffix.str(), timing, 
+            (input.size() + 2 * runCount) * sizeof(int), input.size(), 2 * input.size(), IntegerOps);
+    };
+
+    const auto runDecode = [&](const std::wstring& name, const std::function<void (std::vector<int>&)>& decode)
+    {
+        std::vector<int> result(input.size());
+        const BenchmarkResult timing = benchmark.Measure([&](double& computeTime)
+        {
+            std::fill(begin(result), end(result), 0);
+            computeTime = TimeFunc(view, [&]()
+            {
+                decode(result);
+            });
+        });
+        const bool isCorrect = (input == result);
+        benchmark.Report(isCorrect ? L"SUCCESS" : L"FAILED", name + suffix.str(), timing, 
+            (input.size() + 2 * runCount) * sizeof(int), input.size(), input.size(), IntegerOps);
+    };
+
+    runEncode(L"CPU sequential RLE encode", [&input](std::vector<int>& values, std::vector<int>& lengths)
+    {
+        int count = 0;
+        for (size_t j = 0; j < input.size(); ++j)
+        {
+            if ((j == 0) || (input[j] != input[j - 1]))
+            {
+                values[count] = input[j];
+                lengths[count++] = 0;
+            }
+            ++lengths[count - 1];
+        }
+        return count;
+    });
+    runEncode(L"CPU RLE encode", [&input](std::vector<int>& values, std::vector<int>& lengths)
+    {
+        return RunLengthEncode<16 * 1024>(begin(input), end(input), begin(values), begin(lengths));
+    });
+    runDecode(L"CPU sequential RLE decode", [&](std::vector<int>& out)
+    {
+        std::vector<int>::iterator it = begin(out);
+        for (size_t r = 0; r < runCount; ++r)
+        {
+            std::fill(it, it + expectedLengths[r], expectedValues[r]);
+            it += expectedLengths[r];
+        }
+    });
+    runDecode(L"CPU RLE decode", [&](std::vector<int>& out)
+    {
+        RunLengthDecode<16 * 1024>(begin(expectedValues), end(expectedValues), begin(expectedLengths), begin(out));
+    });
 }
@@ -18,14 +18,10 @@
 
 #include <amp.h>
 
-using namespace concurrency;
+#include "..\..\Samples\CaseStudies\Reduction\Benchmark.h"
+#include "..\..\Samples\CaseStudies\Reduction\PerfCounters.h"
 
-inline double ElapsedTime(const LARGE_INTEGER& start, const LARGE_INTEGER& end)
-{
-    LARGE_INTEGER freq;
-    QueryPerformanceFrequency(&freq);
-    return (double(end.QuadPart) - double(start.QuadPart)) * 1000.0 / double(freq.QuadPart);
-}
+using namespace concurrency;
 
 //  Note that this version of timer.h is different from the other versions include in the samples.
 //  It has an additional requirement. The case study needs to be able to call use TimeFunc to time
@@ -48,13 +44,16 @@ double TimeFunc(accelerator_view& view, Func f)
     //  Wait for all previous accelerator work to end.
     view.wait();
 
-    LARGE_INTEGER start, end;
-    QueryPerformanceCounter(&start);
+    //  Hardware counters, where available, cover the same region as the timer.
+    PerfCounters& counters = PerfCounters::Instance();
+    counters.Start();
+    BenchmarkTimer timer;
 
     f();
 
     //  Wait for all accelerator work to end.
     view.wait();
-    QueryPerformanceCounter(&end);
-    return ElapsedTime(start, end);
+    const double elapsed = timer.ElapsedMilliseconds();
+    counters.Stop();
+    return elapsed;
 }
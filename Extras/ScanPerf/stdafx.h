@@ -16,3 +16,5 @@
 #include <amp.h>
 
 #include "Timer.h"
+#include "..\..\Samples\CaseStudies\Reduction\Benchmark.h"
+#include "..\..\Samples\CaseStudies\Reduction\Roofline.h"
@@ -32,6 +32,7 @@
 
 #define WM_REPORTERROR (WM_USER + 1)
 #define WM_UPDATEWINDOW (WM_USER + 2)
+#define WM_BATCHCOMPLETE (WM_USER + 3)
 
 using namespace concurrency;
 
@@ -63,6 +64,7 @@ public:
 
     virtual void NotifyImageUpdate() = 0;
     virtual void NotifyError() = 0;
+    virtual void NotifyBatchComplete() = 0;
 };
 
 //--------------------------------------------------------------------------------------
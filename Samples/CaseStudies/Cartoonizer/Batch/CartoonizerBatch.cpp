@@ -0,0 +1,353 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//--------------------------------------------------------------------------------------
+//  Command line batch cartoonizer.
+//--------------------------------------------------------------------------------------
+//
+//  Cartoonizes every PNG, PPM and PGM file in a folder with one of the platform neutral 
+//  CPU processors in ../Core and writes the results to another folder, which is created 
+//  if it doesn't exist. Reports the time spent loading, processing and saving and the 
+//  overall frames per second, and optionally places the processor on a roofline. The 
+//  separable processor can also report its quality relative to the exact simplifier.
+//
+//  Usage:
+//
+//   CartoonizerBatch <input folder> <output folder> [options]
+//
+//   --processor NAME  simd, separable or fused (default fused).
+//   --phases N        Color simplifier phases (default 11, as the UI).
+//   --window N        Color simplifier neighbor window (default 12, as the UI).
+//   --format EXT      Output format, png or ppm (default png).
+//   --roofline        Measure the machine's peaks and compare the processor with them.
+//   --compare         Report the PSNR of each image relative to the exact simplifier.
+//                     Separable processor only. The exact simplifier is also timed.
+//
+//  Paths are expected to be ASCII. The core has no Windows dependencies so the driver
+//  also builds with GCC or Clang, for example:
+//
+//   g++ -std=c++11 -O2 -pthread -o CartoonizerBatch CartoonizerBatch.cpp ../Core/*.cpp
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+#include "../Core/IImageProcessor.h"
+#include "../Core/ImageIo.h"
+#include "../Core/ImageProcessorCpuFused.h"
+#include "../Core/ImageProcessorCpuSeparable.h"
+#include "../Core/ImageProcessorCpuSimd.h"
+#include "../Core/Stopwatch.h"
+
+#include "../../Reduction/Benchmark.h"
+#include "../../Reduction/Roofline.h"
+
+struct BatchOptions
+{
+    std::string InputFolder;
+    std::string OutputFolder;
+    std::string Processor;
+    std::string Format;
+    UINT Phases;
+    UINT NeighborWindow;
+    bool Roofline;
+    bool Compare;
+
+    BatchOptions() : Processor("fused"), Format("png"), Phases(11), NeighborWindow(12), Roofline(false), 
+        Compare(false) { }
+
+    //  Returns false if the folders are missing or an option is not recognized.
+
+    bool Parse(int argc, char* argv[])
+    {
+        std::vector<std::string> folders;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg(argv[i]);
+            if (arg.compare(0, 2, "--") != 0)
+            {
+                folders.push_back(arg);
+                continue;
+            }
+            if (arg == "--roofline")
+            {
+                Roofline = true;
+                continue;
+            }
+            if (arg == "--compare")
+            {
+                Compare = true;
+                continue;
+            }
+            if ((i + 1) >= argc)
+                return false;
+            const std::string value(argv[++i]);
+
+            if (arg == "--processor")
+                Processor = value;
+            else if (arg == "--phases")
+                Phases = UINT(std::max(1, std::atoi(value.c_str())));
+            else if (arg == "--window")
+                NeighborWindow = UINT(std::max(1, std::atoi(value.c_str())));
+            else if (arg == "--format")
+                Format = value;
+            else
+                return false;
+        }
+        if (folders.size() != 2)
+            return false;
+        InputFolder = folders[0];
+        OutputFolder = folders[1];
+        return ((Format == "png") || (Format == "ppm")) && (!Compare || (Processor == "separable"));
+    }
+};
+
+std::unique_ptr<IImageProcessor> CreateProcessor(const std::string& name, bool isComparingQuality)
+{
+    if (name == "simd")
+        return std::unique_ptr<IImageProcessor>(new ImageProcessorCpuSimd());
+    if (name == "separable")
+        return std::unique_ptr<IImageProcessor>(new ImageProcessorCpuSeparable(isComparingQuality));
+    if (name == "fused")
+        return std::unique_ptr<IImageProcessor>(new ImageProcessorCpuFused());
+    return std::unique_ptr<IImageProcessor>();
+}
+
+//  Names of the supported image files in a folder, sorted so runs are repeatable.
+
+std::vector<std::string> ListImageFiles(const std::string& folder)
+{
+    std::vector<std::string> names;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((folder + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Cannot read folder " + folder);
+    do
+    {
+        if (((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) && ImageIo::IsSupportedFile(data.cFileName))
+            names.push_back(data.cFileName);
+    }
+    while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(folder.c_str());
+    if (dir == nullptr)
+        throw std::runtime_error("Cannot read folder " + folder);
+    for (dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        if ((entry->d_name[0] != '.') && ImageIo::IsSupportedFile(entry->d_name))
+            names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+//  Create the folder if it doesn't exist. Its parent must exist.
+
+void CreateFolder(const std::string& folder)
+{
+#if defined(_WIN32)
+    if (!CreateDirectoryA(folder.c_str(), nullptr) && (GetLastError() != ERROR_ALREADY_EXISTS))
+        throw std::runtime_error("Cannot create folder " + folder);
+#else
+    if ((mkdir(folder.c_str(), 0777) != 0) && (errno != EEXIST))
+        throw std::runtime_error("Cannot create folder " + folder);
+#endif
+}
+
+inline std::string JoinPath(const std::string& folder, const std::string& name)
+{
+#if defined(_WIN32)
+    return folder + "\\" + name;
+#else
+    return folder + "/" + name;
+#endif
+}
+
+inline std::string ReplaceExtension(const std::string& name, const std::string& extension)
+{
+    return name.substr(0, name.find_last_of('.')) + "." + extension;
+}
+
+//  Estimated useful work of cartoonizing one image, ignoring the halos the fused processor 
+//  recomputes. The color simplifier does 28 flops per neighbor, 15 of them in the exp, and 
+//  23 per pixel written to normalize, clamp and convert back to YUV. Loading the frame 
+//  converts to YUV in 11 flops per pixel and the edge detector does 103 per pixel, 82 in 
+//  the Sobel filters over both frames and 21 for the intensity.
+//
+//  Bytes are the DRAM traffic if the planes don't fit in the cache. The fused processor's 
+//  tiles do, so it only reads and writes the image, plus copying it to destImage. When 
+//  comparing quality the exact simplifier runs as well, but not the PSNR, which is small.
+
+struct BatchWork
+{
+    double Flops;
+    double Bytes;
+};
+
+BatchWork EstimateWork(const std::string& processor, UINT width, UINT height, UINT phases, UINT neighborWindow, 
+    bool isComparingQuality)
+{
+    const double shift = neighborWindow / 2;
+    const double side = 2.0 * shift + 1.0;
+    const double neighbors = side * side - 1.0;
+    const double pixels = double(width) * height;
+    const double innerWidth = std::max(0.0, width - 2.0 * shift);
+    const double inner = innerWidth * std::max(0.0, height - 2.0 * shift);
+    const double edgeInner = std::max(0.0, width - 2.0 * (shift + 1.0)) * std::max(0.0, height - 2.0 * (shift + 1.0));
+
+    const bool isSeparable = (processor == "separable");
+    const double exactPhaseFlops = inner * (28.0 * neighbors + 23.0);
+    const double phaseFlops = isSeparable ? 
+        (height * innerWidth * (28.0 * side + 3.0) + inner * (28.0 * side + 23.0)) : exactPhaseFlops;
+    BatchWork work;
+    work.Flops = 11.0 * pixels + phases * phaseFlops + 103.0 * edgeInner;
+    if (processor == "fused")
+        work.Bytes = 16.0 * pixels;
+    else
+        work.Bytes = pixels * (28.0 + (isSeparable ? 76.0 : 44.0) * phases + 40.0 + 8.0);
+    if (isComparingQuality)
+    {
+        work.Flops += phases * exactPhaseFlops;
+        work.Bytes += pixels * 44.0 * phases;
+    }
+    return work;
+}
+
+void ReportStage(const std::string& stage, double milliseconds, size_t frames)
+{
+    std::cout << "  " << std::left << std::setw(10) << stage << std::right << std::fixed 
+        << std::setw(10) << std::setprecision(1) << milliseconds << " ms" 
+        << std::setw(10) << std::setprecision(2) << ((milliseconds > 0.0) ? (frames * 1000.0 / milliseconds) : 0.0) 
+        << " frames/sec" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    BatchOptions options;
+    std::unique_ptr<IImageProcessor> processor;
+    if (options.Parse(argc, argv))
+        processor = CreateProcessor(options.Processor, options.Compare);
+    if (!processor)
+    {
+        std::cerr << "Usage: CartoonizerBatch <input folder> <output folder> [--processor simd|separable|fused]" << std::endl
+            << "           [--phases N] [--window N] [--format png|ppm] [--roofline] [--compare]" << std::endl
+            << "       --compare requires the separable processor." << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> names;
+    try
+    {
+        names = ListImageFiles(options.InputFolder);
+        CreateFolder(options.OutputFolder);
+    }
+    catch (const std::runtime_error& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Cartoonizing " << names.size() << " images from " << options.InputFolder 
+        << " with the " << options.Processor << " processor, " << options.Phases << " phases, window " 
+        << options.NeighborWindow << " ..." << std::endl;
+
+    double loadTime = 0.0, processTime = 0.0, saveTime = 0.0;
+    size_t completed = 0, failed = 0;
+    BatchWork work = { 0.0, 0.0 };
+    double worstPsnr = 0.0;
+    Image32 srcImage, destImage;
+    const Stopwatch total;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        try
+        {
+            Stopwatch stage;
+            srcImage = ImageIo::Load(JoinPath(options.InputFolder, names[i]));
+            loadTime += stage.ElapsedMilliseconds();
+
+            stage.Restart();
+            destImage = srcImage;
+            processor->ProcessImage(srcImage, destImage, options.Phases, options.NeighborWindow);
+            processTime += stage.ElapsedMilliseconds();
+            const BatchWork imageWork = EstimateWork(options.Processor, srcImage.Width(), srcImage.Height(), 
+                options.Phases, options.NeighborWindow, options.Compare);
+            work.Flops += imageWork.Flops;
+            work.Bytes += imageWork.Bytes;
+            if (options.Compare)
+            {
+                //  Infinite if the image matched the exact simplifier.
+                const double psnr = static_cast<const ImageProcessorCpuSeparable*>(processor.get())->GetLastPsnr();
+                worstPsnr = (completed == 0) ? psnr : std::min(worstPsnr, psnr);
+                std::cout << "  " << names[i] << ": PSNR " << std::fixed << std::setprecision(2) << psnr << " dB" << std::endl;
+            }
+
+            stage.Restart();
+            ImageIo::Save(JoinPath(options.OutputFolder, ReplaceExtension(names[i], options.Format)), destImage);
+            saveTime += stage.ElapsedMilliseconds();
+            ++completed;
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "FAILED:  " << names[i] << ": " << ex.what() << std::endl;
+            ++failed;
+        }
+    }
+    const double totalTime = total.ElapsedMilliseconds();
+
+    std::cout << "Completed " << completed << " images, " << failed << " failed." << std::endl;
+    ReportStage("Load", loadTime, completed);
+    ReportStage("Process", processTime, completed);
+    ReportStage("Save", saveTime, completed);
+    ReportStage("Total", totalTime, completed);
+    if (options.Compare && (completed > 0))
+        std::cout << "  Worst PSNR " << std::fixed << std::setprecision(2) << worstPsnr << " dB relative to the exact simplifier" << std::endl;
+
+    if (options.Roofline && (completed > 0))
+    {
+        //  The whole batch is one row, timed by the processing stage alone.
+        BenchmarkRecord record;
+        record.Status = L"SUCCESS";
+        record.Name = L"CPU " + std::wstring(options.Processor.cbegin(), options.Processor.cend()) + L" processor";
+        record.Result.Total = ComputeStatistics(std::vector<double>(1, processTime), 0.0);
+        record.Result.Compute = record.Result.Total;
+        record.Bytes = (unsigned long long)work.Bytes;
+        record.Elements = completed;
+        record.Flops = (unsigned long long)work.Flops;
+        record.OpKind = FloatOps;
+        std::cout.flush();
+        PrintRoofline(std::vector<BenchmarkRecord>(1, record), MeasureMachinePeaks());
+    }
+    return (failed == 0) ? 0 : 1;
+}
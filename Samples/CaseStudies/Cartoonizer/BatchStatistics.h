@@ -0,0 +1,143 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <array>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <concrt.h>
+#include "GdiWrap.h"
+
+using namespace concurrency;
+
+enum BatchStage
+{
+    kBatchDecode = 0,
+    kBatchResize,
+    kBatchCartoonize,
+    kBatchEncode,
+    kBatchStageCount
+};
+
+//--------------------------------------------------------------------------------------
+//  Throughput of each stage when cartoonizing a folder of images in batch mode.
+//--------------------------------------------------------------------------------------
+//
+//  Each stage adds the time it spent working on every image. A stage's throughput is 
+//  the number of images it could complete per second with all of its workers busy, so 
+//  the stage with the lowest throughput is the one limiting the batch. Stages run on 
+//  different threads so all the methods are thread safe.
+
+class BatchStatistics
+{
+private:
+    mutable critical_section m_lock;
+    std::array<LONGLONG, kBatchStageCount> m_stageTicks;
+    std::array<int, kBatchStageCount> m_stageCounts;
+    std::array<int, kBatchStageCount> m_stageWorkers;
+    int m_failedCount;
+    LARGE_INTEGER m_startTime;
+    LARGE_INTEGER m_endTime;
+    LARGE_INTEGER m_clockFrequency;
+
+public:
+    BatchStatistics() : m_failedCount(0)
+    {
+        m_stageTicks.fill(0);
+        m_stageCounts.fill(0);
+        m_stageWorkers.fill(1);
+        QueryPerformanceFrequency(&m_clockFrequency);
+        QueryPerformanceCounter(&m_startTime);
+        m_endTime = m_startTime;
+    }
+
+    void SetWorkers(BatchStage stage, int workers)
+    {
+        critical_section::scoped_lock lock(m_lock);
+        m_stageWorkers[stage] = workers;
+    }
+
+    void Start()
+    {
+        critical_section::scoped_lock lock(m_lock);
+        QueryPerformanceCounter(&m_startTime);
+        m_endTime = m_startTime;
+    }
+
+    void Stop()
+    {
+        critical_section::scoped_lock lock(m_lock);
+        QueryPerformanceCounter(&m_endTime);
+    }
+
+    //  Add the time a stage spent on one image, in performance counter ticks.
+
+    void AddStageTime(BatchStage stage, LONGLONG ticks)
+    {
+        critical_section::scoped_lock lock(m_lock);
+        m_stageTicks[stage] += ticks;
+        m_stageCounts[stage]++;
+    }
+
+    //  Add the time since start, which was read with QueryPerformanceCounter.
+
+    void AddStageTime(BatchStage stage, const LARGE_INTEGER& start)
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        AddStageTime(stage, now.QuadPart - start.QuadPart);
+    }
+
+    void AddFailure()
+    {
+        critical_section::scoped_lock lock(m_lock);
+        m_failedCount++;
+    }
+
+    std::wstring Report() const
+    {
+        const wchar_t* stageNames[kBatchStageCount] = { L"Decode", L"Resize", L"Cartoonize", L"Encode" };
+
+        critical_section::scoped_lock lock(m_lock);
+        const double elapsed = double(m_endTime.QuadPart - m_startTime.QuadPart) / double(m_clockFrequency.QuadPart);
+        const int completed = m_stageCounts[kBatchEncode];
+
+        std::wostringstream report;
+        report << std::fixed << std::setprecision(1);
+        report << L"Cartoonized " << completed << L" images in " << elapsed << L" s, " 
+            << ((elapsed > 0.0) ? (completed / elapsed) : 0.0) << L" images/sec." << std::endl;
+        if (m_failedCount > 0)
+            report << m_failedCount << L" images could not be read or written." << std::endl;
+        report << std::endl;
+
+        for (int i = 0; i < kBatchStageCount; ++i)
+        {
+            const double average = (m_stageCounts[i] == 0) ? 0.0 : 
+                (1000.0 * double(m_stageTicks[i]) / double(m_stageCounts[i] * m_clockFrequency.QuadPart));
+            report << stageNames[i] << L": " << average << L" ms per image on " << m_stageWorkers[i] 
+                << ((m_stageWorkers[i] == 1) ? L" worker, " : L" workers, ") 
+                << ((average > 0.0) ? (1000.0 * m_stageWorkers[i] / average) : 0.0) << L" images/sec" << std::endl;
+        }
+        return report.str();
+    }
+
+private:
+    // Disable copy constructor and assignment.
+    BatchStatistics(const BatchStatistics&);
+    BatchStatistics const & operator=(BatchStatistics const&);
+};
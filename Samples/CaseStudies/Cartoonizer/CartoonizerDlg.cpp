@@ -35,6 +35,7 @@ CartoonizerDlg::CartoonizerDlg(CWnd* pParent /*=nullptr*/) : CDialogEx(Cartooniz
     m_cancelMessage(),
     m_imageName(L""),
     m_singleImageMode(false),
+    m_batchStatistics(nullptr),
     m_pipelinePerformance(),
     m_currentImagePerformance(0),
     m_simplifierPhases(11),                                     // Default values for sliders.
@@ -75,6 +76,13 @@ void CartoonizerDlg::DoDataExchange(CDataExchange* pDX)
     DDX_TextFormatted(pDX, IDC_EDIT_DISPLAYTIME, m_pipelinePerformance.GetAveragePhaseTime(kDisplay));
     DDX_TextFormatted(pDX, IDC_EDIT_TIMEPERIMAGE, m_pipelinePerformance.GetTimePerImage());
 
+    //  Only processors that compare their quality with the exact color simplifier report a PSNR.
+
+    CString psnr(L"");
+    if (m_pipelinePerformance.HasPsnr())
+        psnr.Format(_T("%4.1f"), m_pipelinePerformance.GetMinimumPsnr());
+    DDX_Text(pDX, IDC_EDIT_PSNR, psnr);
+
     // More pipeline performance data is available but in this sample it is not displayed in the UI.
 
     DDX_CBIndex(pDX, IDC_COMBO_INPUT, m_currentSource);
@@ -99,6 +107,7 @@ BEGIN_MESSAGE_MAP(CartoonizerDlg, CDialogEx)
     ON_BN_CLICKED(IDCANCEL, &CartoonizerDlg::OnBnClickedCancel)
     ON_MESSAGE(WM_REPORTERROR, &CartoonizerDlg::OnReportError)
     ON_MESSAGE(WM_UPDATEWINDOW, &CartoonizerDlg::OnUpdateWindow)
+    ON_MESSAGE(WM_BATCHCOMPLETE, &CartoonizerDlg::OnBatchComplete)
     ON_MESSAGE(WM_HSCROLL, &CartoonizerDlg::OnHScroll)
     ON_WM_SIZE()
     ON_WM_GETMINMAXINFO()
@@ -151,6 +160,10 @@ BOOL CartoonizerDlg::OnInitDialog()
          std::wstring(L" C++ AMP Simple Model: xx GPUs forked"),        // kAmpSimplePipeline
          std::wstring(L" C++ AMP Tiled Model:  xx GPUs forked"),        // kAmpTiledPipeline
          std::wstring(L" C++ AMP Textures:     xx GPUs forked"),        // kAmpTexturePipeline
+         std::wstring(L" CPU Multi-core SIMD"),                         // kCpuSimd
+         std::wstring(L" CPU Multi-core Separable"),                    // kCpuSeparable
+         std::wstring(L" CPU Multi-core Separable: PSNR vs. exact"),    // kCpuSeparableCompare
+         std::wstring(L" CPU Multi-core Fused Tiles"),                  // kCpuFused
     };
 
     //  Fix up processor names.
@@ -174,6 +187,10 @@ BOOL CartoonizerDlg::OnInitDialog()
 
     AddComboItem(pDropDown, processorNames, kCpuSingle);
     AddComboItem(pDropDown, processorNames, kCpuMulti);
+    AddComboItem(pDropDown, processorNames, kCpuSimd);
+    AddComboItem(pDropDown, processorNames, kCpuSeparable);
+    AddComboItem(pDropDown, processorNames, kCpuSeparableCompare);
+    AddComboItem(pDropDown, processorNames, kCpuFused);
 
     //  If there is a GPU or WARP accelerator then use it. Otherwise add a REF accelerator and display warning.
 
@@ -243,7 +260,10 @@ bool CartoonizerDlg::ConfigureSources()
     std::copy(jpegs.begin(), jpegs.end(), std::back_inserter(m_filePaths));
     std::sort(m_filePaths.begin(), m_filePaths.end());
     if (!m_filePaths.empty())
+    {
         m_inputSources.push_back(VideoSource(L"Images from folder"));
+        m_inputSources.push_back(VideoSource(L"Images from folder (batch)"));
+    }
 
     //  Configure video capture, search for available camera and add them to the dropdown.
 
@@ -368,6 +388,23 @@ LRESULT CartoonizerDlg::OnUpdateWindow(WPARAM wParam, LPARAM lParam)
     return 0L;
 }
 
+//  Batch pipeline has finished or been stopped. Report the throughput of each stage.
+//
+//  Ignore the message if another pipeline has been started since.
+
+LRESULT CartoonizerDlg::OnBatchComplete(WPARAM wParam, LPARAM lParam)
+{
+    if ((m_batchStatistics == nullptr) || ((m_pipeline != nullptr) && (m_pipeline->status() != agent_done)))
+        return 0L;
+
+    StopPipeline();
+    std::wstring report = m_batchStatistics->Report();
+    m_batchStatistics = nullptr;
+    ATLTRACE("Batch complete:\n%S\n", report.c_str());
+    MessageBox(report.c_str(), L"Batch Complete", MB_ICONINFORMATION | MB_OK);
+    return 0L;
+}
+
 //  Pipeline source changed. Update the rest of the UI (enable/disable buttons).
 
 void CartoonizerDlg::OnCbnSelchangeComboInput()
@@ -484,7 +521,7 @@ void CartoonizerDlg::OnBnClickedButtonCartoonize()
         reader = std::make_shared<VideoStreamReader>(GetInputSource().Source, true);
 
     // It makes no sense to send a single image through the multiplexed pipeline so use the equivalent single w/o the multiplexor.
-    FrameProcessorType pipelineType = (m_frameProcessorType < kAmpPipeline) ?  m_frameProcessorType : FrameProcessorType(m_frameProcessorType - 7);
+    FrameProcessorType pipelineType = !IsPipelineProcessor(m_frameProcessorType) ?  m_frameProcessorType : FrameProcessorType(m_frameProcessorType - 7);
     m_pipeline = std::unique_ptr<ImagePipeline>(new ImagePipeline(this, reader, pipelineType, 1, m_cancelMessage, m_errorMessages));
 
     m_pipelinePerformance = PipelinePerformanceData(m_pipeline->GetCartoonizerProcessorCount());
@@ -510,15 +547,32 @@ void CartoonizerDlg::OnBnClickedButtonStart()
     UpdateData(DDXReadData);
     StopPipeline();
 
+    //  Batch mode writes the cartoonized images to a folder beside the originals.
+
+    m_batchStatistics = nullptr;
+    std::wstring outputDirectory = FileUtils::GetApplicationDirectory().append(L"Cartoonized\\");
+    if (IsBatchSource())
+    {
+        if (!CreateDirectoryW(outputDirectory.c_str(), nullptr) && (GetLastError() != ERROR_ALREADY_EXISTS))
+        {
+            std::wstring message = L"Unable to create the output folder \"" + outputDirectory + L"\"";
+            AfxMessageBox(message.c_str(), MB_ICONERROR | MB_OK);
+            return;
+        }
+        m_batchStatistics = std::make_shared<BatchStatistics>();
+    }
+
     std::shared_ptr<IFrameReader> reader;
-    if (IsPictureSource())
+    if (IsBatchSource())
+        reader = std::make_shared<ImageFileBatchReader>(FileUtils::GetApplicationDirectory(), m_batchStatistics);
+    else if (IsPictureSource())
         reader = std::make_shared<ImageFileFolderReader>(FileUtils::GetApplicationDirectory());
     else
         reader = std::make_shared<VideoStreamReader>(GetInputSource().Source);   
 
     m_pipeline = std::unique_ptr<ImagePipeline>(
         new ImagePipeline(this, reader, m_frameProcessorType, 
-            kPipelineCapacity, m_cancelMessage, m_errorMessages));
+            kPipelineCapacity, m_cancelMessage, m_errorMessages, m_batchStatistics, outputDirectory));
     m_pipelinePerformance = PipelinePerformanceData(m_pipeline->GetCartoonizerProcessorCount());
     m_pipeline->start();
     m_pipelinePerformance.Start();
@@ -627,6 +681,8 @@ void CartoonizerDlg::OnSize(UINT nType, int cx, int cy)
     ResizeControl(IDC_STATIC_IMG, cx, cy, leftBorder, rightBorder);
     ResizeControl(IDC_STATIC_TPI, cx, cy, leftEdge, rightEdge + 80);
     ResizeControl(IDC_EDIT_TIMEPERIMAGE, cx, cy, rightEdge + 70, rightEdge);
+    ResizeControl(IDC_STATIC_PSNR, cx, cy, leftEdge, rightEdge + 80);
+    ResizeControl(IDC_EDIT_PSNR, cx, cy, rightEdge + 70, rightEdge);
     ResizeControl(IDC_EDIT_IMAGENAME, cx, cy, leftEdge, rightEdge);
 
     ResizeControl(IDC_STATIC_IPS, cx, cy, leftBorder, rightBorder);
@@ -676,7 +732,7 @@ void CartoonizerDlg::ResizeControl(UINT nControlID, int cx, int cy, int shiftLef
 
 void CartoonizerDlg::ReportError(const ErrorInfo& error)
 {
-    std::array<std::wstring, 5> phaseNames = { L"loading", L"scaling", L"filtering", L"displaying", L"processing" };
+    std::array<std::wstring, 6> phaseNames = { L"loading", L"scaling", L"filtering", L"displaying", L"encoding", L"processing" };
 
     SetButtonState(kPipelineStopped);
 
@@ -57,11 +57,13 @@ public:
 
     inline void NotifyError() { PostMessageW(WM_REPORTERROR, 0, 0); }
 
+    inline void NotifyBatchComplete() { PostMessageW(WM_BATCHCOMPLETE, 0, 0); }
+
 #pragma endregion
 
     enum { IDD = IDD_IMAGEPIPELINE_DIALOG };
     enum { DDXWriteData = false, DDXReadData = true };
-    enum { PictureSource = 0, VideoSources = 1 };
+    enum { PictureSource = 0, BatchSource = 1, VideoSources = 2 };
 
 protected:
     virtual void DoDataExchange(CDataExchange* pDX);
@@ -82,6 +84,10 @@ private:
     bool m_singleImageMode;
     static const int kPipelineCapacity = 6;
 
+    // Batch mode statistics, set until the batch is reported.
+
+    std::shared_ptr<BatchStatistics> m_batchStatistics;
+
     // Image processing settings
 
     FrameProcessorType m_frameProcessorType;
@@ -102,8 +108,8 @@ private:
     static const int m_imageTop = 10;
     static const int m_imageLeft = 10;
     static const int m_consoleWidth = 250;
-    static const int m_consoleHeightWin8 = 760;
-    static const int m_consoleHeightWin7 = 620;
+    static const int m_consoleHeightWin8 = 790;
+    static const int m_consoleHeightWin7 = 650;
     int m_consoleHeight;
 
     SIZE m_displaySize;
@@ -132,11 +138,15 @@ private:
 
     inline bool IsPipelineRunning() { return (m_pipeline != nullptr); }
 
-    inline bool VideoEnabled() { return (m_currentSource != PictureSource) || (m_currentSource == PictureSource && m_filePaths.empty()); }
+    // When there are images the first two sources are the images, then batch mode, otherwise there are only cameras.
+
+    inline bool VideoEnabled() { return (m_currentSource > BatchSource) || m_filePaths.empty(); }
+
+    inline bool PicturesEnabled() { return (m_currentSource <= BatchSource) && (!m_filePaths.empty()); }
 
-    inline bool PicturesEnabled() { return (m_currentSource == PictureSource) && (!m_filePaths.empty()); }
+    inline bool IsPictureSource() { return (m_currentSource <= BatchSource) && PicturesEnabled(); }
 
-    inline bool IsPictureSource() { return (m_currentSource == PictureSource) && PicturesEnabled(); }
+    inline bool IsBatchSource() { return (m_currentSource == BatchSource) && PicturesEnabled(); }
 
     void LoadVideoFrame();
 
@@ -166,6 +176,7 @@ public:
 
     afx_msg LRESULT OnReportError(WPARAM wParam, LPARAM lParam);
     afx_msg LRESULT OnUpdateWindow(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnBatchComplete(WPARAM wParam, LPARAM lParam);
 
     void OnGetMinMaxInfo(MINMAXINFO FAR* lpMMI);
     afx_msg void OnSize(UINT nType, int cx, int cy);
@@ -58,6 +58,10 @@ public:
         case kAmpSimple:
         case kCpuSingle:
         case kCpuMulti:
+        case kCpuSimd:
+        case kCpuSeparable:
+        case kCpuSeparableCompare:
+        case kCpuFused:
             ATLTRACE("Sequential pipeline agent, simple.\n");
             return std::shared_ptr<ImageCartoonizerAgentBase>(new ImageCartoonizerAgent(pDialog, processorType, cancellationSource, errorTarget, imageInput, imageOutput));
             break;
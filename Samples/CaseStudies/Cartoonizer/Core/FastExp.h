@@ -0,0 +1,79 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "CpuFeatures.h"
+
+//--------------------------------------------------------------------------------------
+//  Fast exponential for the CPU color simplifiers.
+//--------------------------------------------------------------------------------------
+//
+//  exp(x) = 2^n * 2^f where x * log2(e) = n + f and 0 <= f < 1. 2^f is approximated with
+//  a fifth order polynomial, relative error about 1e-7, and 2^n is built directly in the
+//  exponent bits. The simplifiers only use x <= 0 so large x are not handled. Very small x 
+//  are clamped so the result never underflows to zero and the weights always have a 
+//  non-zero sum.
+//
+//  The scalar and AVX2 versions perform the same operations so give the same results.
+
+class FastMath
+{
+public:
+    static inline float Exp(float x)
+    {
+        const float t = std::max(x * Log2E(), MinExponent());
+        const float n = floorf(t);
+        const float f = t - n;
+        float p = 0.00133335581f;
+        p = p * f + 0.00961812911f;
+        p = p * f + 0.0555041087f;
+        p = p * f + 0.240226507f;
+        p = p * f + 0.693147182f;
+        p = p * f + 1.0f;
+
+        const int bits = (static_cast<int>(n) + 127) << 23;
+        float scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    TARGET_AVX2 static inline __m256 Exp(__m256 x)
+    {
+        const __m256 t = _mm256_max_ps(_mm256_mul_ps(x, _mm256_set1_ps(Log2E())), _mm256_set1_ps(MinExponent()));
+        const __m256 n = _mm256_floor_ps(t);
+        const __m256 f = _mm256_sub_ps(t, n);
+        __m256 p = _mm256_set1_ps(0.00133335581f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.00961812911f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.0555041087f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.240226507f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.693147182f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f));
+
+        const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+    }
+
+private:
+    static inline float Log2E() { return 1.44269504f; }
+
+    static inline float MinExponent() { return -126.0f; }
+};
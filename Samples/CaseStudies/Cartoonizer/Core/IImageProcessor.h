@@ -0,0 +1,36 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include "Image32.h"
+
+//--------------------------------------------------------------------------------------
+//  Platform neutral equivalent of IFrameProcessor.
+//--------------------------------------------------------------------------------------
+//
+//  Cartoonizes srcImage into destImage, which must be the same size. Pixels within 
+//  neighborWindow / 2 + 1 of the edge of the image are not written, so destImage 
+//  should start as a copy of srcImage.
+
+class IImageProcessor
+{
+public:
+    virtual ~IImageProcessor() { }
+
+    virtual void ProcessImage(const Image32& srcImage, Image32& destImage, 
+        UINT phases, UINT neighborWindow) = 0;
+};
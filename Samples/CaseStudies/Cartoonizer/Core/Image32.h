@@ -0,0 +1,155 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+typedef unsigned int UINT;
+typedef unsigned char byte;
+
+//--------------------------------------------------------------------------------------
+//  Platform neutral 32bpp image.
+//--------------------------------------------------------------------------------------
+//
+//  Each pixel is four bytes in B, G, R, A order, the same layout as a GDI+ 
+//  PixelFormat32bppARGB bitmap. An image either owns its pixels, in a buffer aligned 
+//  for AVX with rows padded to the same alignment, or is a view of pixels owned by 
+//  something else such as a locked GDI+ bitmap. Copying an image always makes an owned
+//  copy of the pixels, moving it transfers the buffer or view.
+
+class Image32
+{
+public:
+    static const UINT kBytesPerPixel = 4;
+    static const UINT kAlignment = 32;
+
+private:
+    std::vector<byte> m_buffer;
+    byte* m_pixels;
+    UINT m_width;
+    UINT m_height;
+    UINT m_stride;
+
+public:
+    Image32() : m_pixels(nullptr), m_width(0), m_height(0), m_stride(0) { }
+
+    Image32(UINT width, UINT height) : m_pixels(nullptr), m_width(0), m_height(0), m_stride(0)
+    {
+        Resize(width, height);
+    }
+
+    Image32(const Image32& other) : m_pixels(nullptr), m_width(0), m_height(0), m_stride(0)
+    {
+        *this = other;
+    }
+
+    Image32(Image32&& other) : m_pixels(nullptr), m_width(0), m_height(0), m_stride(0)
+    {
+        *this = std::move(other);
+    }
+
+    Image32& operator=(const Image32& other)
+    {
+        if (this == &other)
+            return *this;
+        if (IsView())
+            *this = Image32();
+        Resize(other.m_width, other.m_height);
+        CopyFrom(other);
+        return *this;
+    }
+
+    Image32& operator=(Image32&& other)
+    {
+        if (this == &other)
+            return *this;
+        m_buffer.swap(other.m_buffer);
+        std::swap(m_pixels, other.m_pixels);
+        std::swap(m_width, other.m_width);
+        std::swap(m_height, other.m_height);
+        std::swap(m_stride, other.m_stride);
+        return *this;
+    }
+
+    //  View of pixels owned elsewhere. stride is the number of bytes between the start of 
+    //  each row.
+
+    static Image32 View(byte* pixels, UINT width, UINT height, UINT stride)
+    {
+        assert(stride >= (width * kBytesPerPixel));
+
+        Image32 image;
+        image.m_pixels = pixels;
+        image.m_width = width;
+        image.m_height = height;
+        image.m_stride = stride;
+        return image;
+    }
+
+    //  Change the size of the image. The contents are undefined afterwards. A view can 
+    //  only be resized to its current size.
+
+    void Resize(UINT width, UINT height)
+    {
+        if ((m_width == width) && (m_height == height))
+            return;
+        assert(!IsView());
+
+        m_width = width;
+        m_height = height;
+        m_stride = (width * kBytesPerPixel + kAlignment - 1) / kAlignment * kAlignment;
+        m_buffer.resize(size_t(m_stride) * m_height + kAlignment);
+        const uintptr_t address = reinterpret_cast<uintptr_t>(m_buffer.data());
+        m_pixels = m_buffer.data() + ((kAlignment - address % kAlignment) % kAlignment);
+    }
+
+    //  Copy the pixels of an image of the same size.
+
+    void CopyFrom(const Image32& other)
+    {
+        assert((m_width == other.m_width) && (m_height == other.m_height));
+
+        for (UINT y = 0; y < m_height; ++y)
+            memcpy(Row(y), other.Row(y), m_width * kBytesPerPixel);
+    }
+
+    inline UINT Width() const { return m_width; }
+
+    inline UINT Height() const { return m_height; }
+
+    inline UINT Stride() const { return m_stride; }
+
+    inline bool IsEmpty() const { return (m_width == 0) || (m_height == 0); }
+
+    inline bool IsView() const { return (m_pixels != nullptr) && m_buffer.empty(); }
+
+    inline byte* Row(UINT y)
+    {
+        assert(y < m_height);
+        return m_pixels + size_t(y) * m_stride;
+    }
+
+    inline const byte* Row(UINT y) const
+    {
+        assert(y < m_height);
+        return m_pixels + size_t(y) * m_stride;
+    }
+};
@@ -0,0 +1,204 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#include <ctype.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "ImageIo.h"
+
+Image32 ImageIo::Load(const std::string& path)
+{
+    try
+    {
+        return Decode(ReadFile(path));
+    }
+    catch (const std::runtime_error& ex)
+    {
+        throw std::runtime_error(path + ": " + ex.what());
+    }
+}
+
+void ImageIo::Save(const std::string& path, const Image32& image)
+{
+    WriteFile(path, Encode(image, path));
+}
+
+bool ImageIo::IsSupportedFile(const std::string& path)
+{
+    const std::string extension = Extension(path);
+    return (extension == ".png") || (extension == ".ppm") || (extension == ".pgm");
+}
+
+std::vector<byte> ImageIo::ReadFile(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Unable to open " + path);
+
+    file.seekg(0, std::ios::end);
+    const std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<byte> data(size_t(std::max(size, std::streamoff(0))));
+    if ((size < 0) || !file.read(reinterpret_cast<char*>(data.data()), data.size()))
+        throw std::runtime_error("Unable to read " + path);
+    return data;
+}
+
+void ImageIo::WriteFile(const std::string& path, const std::vector<byte>& data)
+{
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+        throw std::runtime_error("Unable to create " + path);
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+    if (!file)
+        throw std::runtime_error("Unable to write " + path);
+}
+
+Image32 ImageIo::Decode(const std::vector<byte>& data)
+{
+    const byte pngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if ((data.size() >= sizeof(pngSignature)) && std::equal(pngSignature, pngSignature + sizeof(pngSignature), data.begin()))
+        return DecodePng(data);
+    if ((data.size() >= 2) && (data[0] == 'P') && ((data[1] == '5') || (data[1] == '6')))
+        return DecodePnm(data);
+    throw std::runtime_error("Not a PNG or binary PPM/PGM image");
+}
+
+std::vector<byte> ImageIo::Encode(const Image32& image, const std::string& path)
+{
+    const std::string extension = Extension(path);
+    if (extension == ".png")
+        return EncodePng(image);
+    if (extension == ".ppm")
+        return EncodePpm(image);
+    throw std::runtime_error("Unable to write images of type " + extension + " to " + path);
+}
+
+std::string ImageIo::Extension(const std::string& path)
+{
+    const size_t dot = path.find_last_of('.');
+    if ((dot == std::string::npos) || (path.find_first_of("/\\", dot) != std::string::npos))
+        return std::string();
+
+    std::string extension = path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(tolower(c)); });
+    return extension;
+}
+
+//--------------------------------------------------------------------------------------
+//  PPM and PGM.
+//--------------------------------------------------------------------------------------
+//
+//  The header is the magic number, width, height and maximum sample value separated by
+//  whitespace, which may include comments from '#' to the end of a line. A single 
+//  whitespace character separates it from the samples. Samples over 255 take two bytes,
+//  most significant first.
+
+namespace
+{
+    UINT ReadPnmValue(const std::vector<byte>& data, size_t& position)
+    {
+        while (position < data.size())
+        {
+            if (data[position] == '#')
+            {
+                while ((position < data.size()) && (data[position] != '\n'))
+                    ++position;
+            }
+            else if (isspace(data[position]))
+                ++position;
+            else
+                break;
+        }
+
+        if ((position >= data.size()) || !isdigit(data[position]))
+            throw std::runtime_error("Invalid PPM/PGM header");
+        UINT value = 0;
+        while ((position < data.size()) && isdigit(data[position]))
+        {
+            value = value * 10 + (data[position++] - '0');
+            if (value > 0xFFFFFF)
+                throw std::runtime_error("Invalid PPM/PGM header");
+        }
+        return value;
+    }
+}
+
+Image32 ImageIo::DecodePnm(const std::vector<byte>& data)
+{
+    size_t position = 2;
+    const UINT channels = (data[1] == '6') ? 3 : 1;
+    const UINT width = ReadPnmValue(data, position);
+    const UINT height = ReadPnmValue(data, position);
+    const UINT maxValue = ReadPnmValue(data, position);
+    if ((width == 0) || (height == 0) || (maxValue == 0) || (maxValue > 65535))
+        throw std::runtime_error("Unsupported PPM/PGM size or sample range");
+    ++position;
+
+    const UINT bytesPerSample = (maxValue > 255) ? 2 : 1;
+    if ((data.size() < position) || ((data.size() - position) / (size_t(width) * channels * bytesPerSample) < height))
+        throw std::runtime_error("Truncated PPM/PGM image");
+
+    Image32 image(width, height);
+    const byte* samples = data.data() + position;
+    for (UINT y = 0; y < height; ++y)
+    {
+        byte* pixels = image.Row(y);
+        for (UINT x = 0; x < width; ++x)
+        {
+            UINT rgb[3];
+            for (UINT c = 0; c < channels; ++c, samples += bytesPerSample)
+            {
+                const UINT sample = (bytesPerSample == 2) ? ((samples[0] << 8) | samples[1]) : samples[0];
+                rgb[c] = (std::min(sample, maxValue) * 255 + maxValue / 2) / maxValue;
+            }
+            if (channels == 1)
+                rgb[1] = rgb[2] = rgb[0];
+
+            pixels[4 * x] = byte(rgb[2]);
+            pixels[4 * x + 1] = byte(rgb[1]);
+            pixels[4 * x + 2] = byte(rgb[0]);
+            pixels[4 * x + 3] = 255;
+        }
+    }
+    return image;
+}
+
+std::vector<byte> ImageIo::EncodePpm(const Image32& image)
+{
+    std::ostringstream header;
+    header << "P6\n" << image.Width() << " " << image.Height() << "\n255\n";
+    const std::string text = header.str();
+
+    std::vector<byte> data(text.begin(), text.end());
+    data.reserve(text.size() + size_t(image.Width()) * image.Height() * 3);
+    for (UINT y = 0; y < image.Height(); ++y)
+    {
+        const byte* pixels = image.Row(y);
+        for (UINT x = 0; x < image.Width(); ++x)
+        {
+            data.push_back(pixels[4 * x + 2]);
+            data.push_back(pixels[4 * x + 1]);
+            data.push_back(pixels[4 * x]);
+        }
+    }
+    return data;
+}
@@ -0,0 +1,72 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Image32.h"
+
+//--------------------------------------------------------------------------------------
+//  Image file reading and writing without any platform image libraries.
+//--------------------------------------------------------------------------------------
+//
+//  Supports binary PPM (P6) and PGM (P5) with up to 16 bits per sample, and PNG with 8 or
+//  16 bits per sample in any color type but without interlacing. Only the most 
+//  significant byte of 16-bit samples is kept. PPM is always written as 8-bit P6. PNG is 
+//  written as 8-bit RGB, or RGBA if any pixel is transparent, compressed with the fixed 
+//  Huffman codes. This is quick but the files are larger than from a full encoder.
+//
+//  The file functions throw std::runtime_error if a file cannot be read or written, or 
+//  is not in a supported format.
+
+class ImageIo
+{
+public:
+    //  Read a PNG or PPM/PGM file, identified by its contents.
+
+    static Image32 Load(const std::string& path);
+
+    //  Write a PNG or PPM file, chosen by the extension of path (".png" or ".ppm").
+
+    static void Save(const std::string& path, const Image32& image);
+
+    //  True if path has an extension Load and Save handle.
+
+    static bool IsSupportedFile(const std::string& path);
+
+    static std::vector<byte> ReadFile(const std::string& path);
+
+    static void WriteFile(const std::string& path, const std::vector<byte>& data);
+
+    //  Decode or encode an image held in memory.
+
+    static Image32 Decode(const std::vector<byte>& data);
+
+    static std::vector<byte> Encode(const Image32& image, const std::string& path);
+
+    static Image32 DecodePng(const std::vector<byte>& data);
+
+    static std::vector<byte> EncodePng(const Image32& image);
+
+    static Image32 DecodePnm(const std::vector<byte>& data);
+
+    static std::vector<byte> EncodePpm(const Image32& image);
+
+private:
+    static std::string Extension(const std::string& path);
+};
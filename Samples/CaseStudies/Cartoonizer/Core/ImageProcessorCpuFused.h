@@ -0,0 +1,161 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Image32.h"
+#include "ImageProcessorCpuSimd.h"
+#include "Parallel.h"
+#include "PlanarFrame.h"
+
+//--------------------------------------------------------------------------------------
+//  Multi-core CPU image processor fusing the color simplifier and edge detection.
+//--------------------------------------------------------------------------------------
+//
+//  The other CPU processors make a pass over the whole frame for each simplifier phase 
+//  and another for edge detection, so an HD frame is streamed through memory many times.
+//  Here the frame is divided into tiles small enough to stay in a core's cache. Each 
+//  tile is loaded along with a halo of surrounding pixels, and then all the simplifier 
+//  phases and the edge detection are run on it before it is written out. Tiles are 
+//  processed in parallel. Each tile takes a set of buffers from a pool and returns it 
+//  when done, so there are only ever as many sets as tiles in flight.
+//
+//  Each phase needs pixels neighborWindow / 2 beyond those it updates, so the area of 
+//  the tile that is correct shrinks by that much after every phase. The halo is wide 
+//  enough for all the phases plus the one pixel border used by edge detection. Halo 
+//  pixels are simplified more than once, by each tile they border, but the results are
+//  the same as ImageProcessorCpuSimd.
+//
+//  A tile and its buffers take about 1.7MB for three phases of a window of six, and the 
+//  halo adds up to 40% to the simplifier's work. Larger tiles reduce the extra work 
+//  but no longer fit in cache.
+
+class ImageProcessorCpuFused : public ImageProcessorCpuSimd
+{
+public:
+    static const UINT kTileWidth = 256;
+    static const UINT kTileHeight = 64;
+
+private:
+    struct TileBuffers
+    {
+        PlanarFrame original;
+        std::array<PlanarFrame, kBufSize> planes;
+    };
+
+    std::vector<std::unique_ptr<TileBuffers>> m_freeBuffers;
+    std::mutex m_freeBuffersLock;
+
+public:
+    void ProcessImage(const Image32& srcImage, Image32& destImage, 
+        UINT phases, UINT neighborWindow)
+    {
+        assert((srcImage.Width() == destImage.Width()) && (srcImage.Height() == destImage.Height()));
+        assert(phases > 0);
+        assert(neighborWindow > 0);
+
+        const UINT tilesAcross = (srcImage.Width() + kTileWidth - 1) / kTileWidth;
+        const UINT tilesDown = (srcImage.Height() + kTileHeight - 1) / kTileHeight;
+        ParallelFor(0u, tilesAcross * tilesDown, [=, &srcImage, &destImage](UINT tile)
+        {
+            const UINT startWidth = (tile % tilesAcross) * kTileWidth;
+            const UINT startHeight = (tile / tilesAcross) * kTileHeight;
+            std::unique_ptr<TileBuffers> buffers = AcquireBuffers();
+            ProcessTile(srcImage, destImage, phases, neighborWindow, *buffers, 
+                startWidth, startHeight, std::min(startWidth + kTileWidth, srcImage.Width()), 
+                std::min(startHeight + kTileHeight, srcImage.Height()));
+            ReleaseBuffers(std::move(buffers));
+        });
+    }
+
+private:
+    std::unique_ptr<TileBuffers> AcquireBuffers()
+    {
+        std::lock_guard<std::mutex> lock(m_freeBuffersLock);
+        if (m_freeBuffers.empty())
+            return std::unique_ptr<TileBuffers>(new TileBuffers());
+        std::unique_ptr<TileBuffers> buffers = std::move(m_freeBuffers.back());
+        m_freeBuffers.pop_back();
+        return buffers;
+    }
+
+    void ReleaseBuffers(std::unique_ptr<TileBuffers> buffers)
+    {
+        std::lock_guard<std::mutex> lock(m_freeBuffersLock);
+        m_freeBuffers.push_back(std::move(buffers));
+    }
+
+    //  Process the pixels in [startWidth, endWidth) x [startHeight, endHeight) of the frame.
+
+    void ProcessTile(const Image32& srcImage, Image32& destImage, 
+        UINT phases, UINT neighborWindow, TileBuffers& buffers, 
+        UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight) const
+    {
+        const int width = srcImage.Width();
+        const int height = srcImage.Height();
+        const int shift = neighborWindow / 2;
+        const int halo = phases * shift + 1;
+
+        //  Load the tile and its halo, clipped to the frame.
+
+        const int left = std::max(int(startWidth) - halo, 0);
+        const int top = std::max(int(startHeight) - halo, 0);
+        const int right = std::min(int(endWidth) + halo, width);
+        const int bottom = std::min(int(endHeight) + halo, height);
+        buffers.original.LoadRegion(srcImage, left, top, right - left, bottom - top);
+        buffers.planes[kCurrent].Resize(right - left, bottom - top);
+        buffers.planes[kNext].Resize(right - left, bottom - top);
+
+        //  Simplify the part of the tile that will be correct after each phase. Where the 
+        //  tile meets the edge of the frame there are no missing pixels so that side of the
+        //  tile does not shrink. Pixels outside it are copied, like the border of the frame.
+
+        const PlanarFrame* src = &buffers.original;
+        int next = kCurrent;
+        for (int i = 1; i <= int(phases); ++i)
+        {
+            const int simplifyLeft = std::max((left == 0) ? 0 : (left + i * shift), shift) - left;
+            const int simplifyTop = std::max((top == 0) ? 0 : (top + i * shift), shift) - top;
+            const int simplifyRight = std::min((right == width) ? width : (right - i * shift), width - shift) - left;
+            const int simplifyBottom = std::min((bottom == height) ? height : (bottom - i * shift), height - shift) - top;
+
+            PlanarFrame& dest = buffers.planes[next];
+            for (int y = 0; y < (bottom - top); ++y)
+                SimplifyRowOrCopy(*src, dest, neighborWindow, y, 
+                    std::max(simplifyLeft, 0), std::max(simplifyTop, 0), std::max(simplifyRight, 0), std::max(simplifyBottom, 0), m_useAvx2);
+            src = &dest;
+            next = 1 - next;
+        }
+
+        //  Detect edges in the tile's own pixels, excluding the border of the frame.
+
+        const int edgeLeft = std::max(int(startWidth), shift + 1);
+        const int edgeTop = std::max(int(startHeight), shift + 1);
+        const int edgeRight = std::min(int(endWidth), width - shift - 1);
+        const int edgeBottom = std::min(int(endHeight), height - shift - 1);
+        for (int y = edgeTop; y < edgeBottom; ++y)
+        {
+            byte* destPixels = destImage.Row(y) + 4 * left;
+            PlanarEdgeDetector::ApplyEdgeDetectionRow(*src, buffers.original, destPixels, y - top, 
+                std::max(edgeLeft - left, 0), std::max(edgeRight - left, 0), m_useAvx2);
+        }
+    }
+};
@@ -0,0 +1,204 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#include <math.h>
+#include <assert.h>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "ImageProcessorCpuSeparable.h"
+#include "FastExp.h"
+#include "Parallel.h"
+
+//--------------------------------------------------------------------------------------
+//  Separable color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  The horizontal pass covers every row so that the vertical pass has all the rows of 
+//  its window. Only the vertical pass truncates its results, like the 8-bit frame 
+//  buffers, the horizontal pass keeps full precision.
+
+void ImageProcessorCpuSeparable::ApplyColorSimplifierSeparable(const PlanarFrame& srcFrame, PlanarFrame& intermediateFrame, PlanarFrame& destFrame, 
+    UINT neighborWindow, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2)
+{
+    assert((srcFrame.Width() == destFrame.Width()) && (srcFrame.Height() == destFrame.Height()));
+    assert((srcFrame.Width() == intermediateFrame.Width()) && (srcFrame.Height() == intermediateFrame.Height()));
+
+    const UINT width = srcFrame.Width();
+    ParallelFor(0u, srcFrame.Height(), [=, &srcFrame, &intermediateFrame](UINT y)
+    {
+        if (useAvx2)
+            FilterRowAvx2(srcFrame, srcFrame, intermediateFrame, neighborWindow, y, startWidth, endWidth, false);
+        else
+            FilterRow(srcFrame, srcFrame, intermediateFrame, neighborWindow, y, startWidth, endWidth, false);
+    });
+
+    ParallelFor(0u, srcFrame.Height(), [=, &srcFrame, &intermediateFrame, &destFrame](UINT y)
+    {
+        if ((y < startHeight) || (y >= endHeight) || (startWidth >= endWidth))
+        {
+            destFrame.CopyRow(srcFrame, y, 0, width);
+            return;
+        }
+        destFrame.CopyRow(srcFrame, y, 0, startWidth);
+        destFrame.CopyRow(srcFrame, y, endWidth, width);
+        if (useAvx2)
+            FilterRowAvx2(srcFrame, intermediateFrame, destFrame, neighborWindow, y, startWidth, endWidth, true);
+        else
+            FilterRow(srcFrame, intermediateFrame, destFrame, neighborWindow, y, startWidth, endWidth, true);
+        destFrame.UpdateYuv(y, startWidth, endWidth);
+    });
+}
+
+//  Filter part of a row along a row or column of the window. The weights come from the 
+//  U and V planes of guideFrame and the colors from srcFrame.
+
+void ImageProcessorCpuSeparable::FilterRow(const PlanarFrame& guideFrame, const PlanarFrame& srcFrame, PlanarFrame& destFrame, 
+    UINT neighborWindow, UINT idxY, UINT startWidth, UINT endWidth, bool isVertical)
+{
+    const int shift = neighborWindow / 2;
+    const float* orgU = guideFrame.Row(PlanarFrame::kU, idxY);
+    const float* orgV = guideFrame.Row(PlanarFrame::kV, idxY);
+    float* destR = destFrame.Row(PlanarFrame::kR, idxY);
+    float* destG = destFrame.Row(PlanarFrame::kG, idxY);
+    float* destB = destFrame.Row(PlanarFrame::kB, idxY);
+
+    for (UINT idxX = startWidth; idxX < endWidth; ++idxX)
+    {
+        float sum = 0;
+        float partialSumR = 0, partialSumG = 0, partialSumB = 0;
+
+        for (int d = -shift; d <= shift; ++d)
+        {
+            const UINT y = isVertical ? (idxY + d) : idxY;
+            const UINT x = isVertical ? idxX : (idxX + d);
+            const float du = guideFrame.Row(PlanarFrame::kU, y)[x] - orgU[idxX];
+            const float dv = guideFrame.Row(PlanarFrame::kV, y)[x] - orgV[idxX];
+            const float value = FastMath::Exp(Decay() * (du * du + dv * dv));
+            sum += value;
+            partialSumR += srcFrame.Row(PlanarFrame::kR, y)[x] * value;
+            partialSumG += srcFrame.Row(PlanarFrame::kG, y)[x] * value;
+            partialSumB += srcFrame.Row(PlanarFrame::kB, y)[x] * value;
+        }
+
+        destR[idxX] = partialSumR / sum;
+        destG[idxX] = partialSumG / sum;
+        destB[idxX] = partialSumB / sum;
+        if (isVertical)
+        {
+            destR[idxX] = floorf(std::min(std::max(destR[idxX], 0.0f), 255.0f));
+            destG[idxX] = floorf(std::min(std::max(destG[idxX], 0.0f), 255.0f));
+            destB[idxX] = floorf(std::min(std::max(destB[idxX], 0.0f), 255.0f));
+        }
+    }
+}
+
+void ImageProcessorCpuSeparable::FilterRowAvx2(const PlanarFrame& guideFrame, const PlanarFrame& srcFrame, PlanarFrame& destFrame, 
+    UINT neighborWindow, UINT idxY, UINT startWidth, UINT endWidth, bool isVertical)
+{
+    const int shift = neighborWindow / 2;
+    const float* orgU = guideFrame.Row(PlanarFrame::kU, idxY);
+    const float* orgV = guideFrame.Row(PlanarFrame::kV, idxY);
+    float* destR = destFrame.Row(PlanarFrame::kR, idxY);
+    float* destG = destFrame.Row(PlanarFrame::kG, idxY);
+    float* destB = destFrame.Row(PlanarFrame::kB, idxY);
+
+    const __m256 decay = _mm256_set1_ps(Decay());
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 maxValue = _mm256_set1_ps(255.0f);
+
+    UINT idxX = startWidth;
+    for (; (idxX + 8) <= endWidth; idxX += 8)
+    {
+        const __m256 u0 = _mm256_loadu_ps(orgU + idxX);
+        const __m256 v0 = _mm256_loadu_ps(orgV + idxX);
+        __m256 sum = zero;
+        __m256 partialSumR = zero, partialSumG = zero, partialSumB = zero;
+
+        for (int d = -shift; d <= shift; ++d)
+        {
+            const UINT y = isVertical ? (idxY + d) : idxY;
+            const UINT x = isVertical ? idxX : (idxX + d);
+            const __m256 du = _mm256_sub_ps(_mm256_loadu_ps(guideFrame.Row(PlanarFrame::kU, y) + x), u0);
+            const __m256 dv = _mm256_sub_ps(_mm256_loadu_ps(guideFrame.Row(PlanarFrame::kV, y) + x), v0);
+            const __m256 value = FastMath::Exp(_mm256_mul_ps(decay, _mm256_add_ps(_mm256_mul_ps(du, du), _mm256_mul_ps(dv, dv))));
+            sum = _mm256_add_ps(sum, value);
+            partialSumR = _mm256_add_ps(partialSumR, _mm256_mul_ps(_mm256_loadu_ps(srcFrame.Row(PlanarFrame::kR, y) + x), value));
+            partialSumG = _mm256_add_ps(partialSumG, _mm256_mul_ps(_mm256_loadu_ps(srcFrame.Row(PlanarFrame::kG, y) + x), value));
+            partialSumB = _mm256_add_ps(partialSumB, _mm256_mul_ps(_mm256_loadu_ps(srcFrame.Row(PlanarFrame::kB, y) + x), value));
+        }
+
+        __m256 r = _mm256_div_ps(partialSumR, sum);
+        __m256 g = _mm256_div_ps(partialSumG, sum);
+        __m256 b = _mm256_div_ps(partialSumB, sum);
+        if (isVertical)
+        {
+            r = _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(r, zero), maxValue));
+            g = _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(g, zero), maxValue));
+            b = _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(b, zero), maxValue));
+        }
+        _mm256_storeu_ps(destR + idxX, r);
+        _mm256_storeu_ps(destG + idxX, g);
+        _mm256_storeu_ps(destB + idxX, b);
+    }
+    _mm256_zeroupper();
+
+    if (idxX < endWidth)
+        FilterRow(guideFrame, srcFrame, destFrame, neighborWindow, idxY, idxX, endWidth, isVertical);
+}
+
+//--------------------------------------------------------------------------------------
+//  Quality comparison.
+//--------------------------------------------------------------------------------------
+//
+//  PSNR = 10 * log10(255^2 / MSE) over the R, G and B values of the pixels inside the
+//  bounds. Each row's squared error is summed separately and the rows added in order so
+//  the result does not depend on the scheduling of the rows.
+
+double ImageProcessorCpuSeparable::CalculatePsnr(const PlanarFrame& expectedFrame, const PlanarFrame& actualFrame,
+    UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight)
+{
+    assert((expectedFrame.Width() == actualFrame.Width()) && (expectedFrame.Height() == actualFrame.Height()));
+    if ((startWidth >= endWidth) || (startHeight >= endHeight))
+        return std::numeric_limits<double>::infinity();
+
+    std::vector<double> rowErrors(endHeight - startHeight, 0.0);
+    ParallelFor(startHeight, endHeight, [=, &expectedFrame, &actualFrame, &rowErrors](UINT y)
+    {
+        double error = 0.0;
+        for (int plane = PlanarFrame::kR; plane <= PlanarFrame::kB; ++plane)
+        {
+            const float* expected = expectedFrame.Row(PlanarFrame::Plane(plane), y);
+            const float* actual = actualFrame.Row(PlanarFrame::Plane(plane), y);
+            for (UINT x = startWidth; x < endWidth; ++x)
+            {
+                const double diff = double(expected[x]) - actual[x];
+                error += diff * diff;
+            }
+        }
+        rowErrors[y - startHeight] = error;
+    });
+
+    double squaredError = 0.0;
+    for (size_t i = 0; i < rowErrors.size(); ++i)
+        squaredError += rowErrors[i];
+    if (squaredError == 0.0)
+        return std::numeric_limits<double>::infinity();
+
+    const double meanSquaredError = squaredError / (3.0 * (endWidth - startWidth) * (endHeight - startHeight));
+    return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,105 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <array>
+
+#include "CpuFeatures.h"
+#include "ImageProcessorCpuSimd.h"
+#include "PlanarFrame.h"
+
+//--------------------------------------------------------------------------------------
+//  Multi-core CPU image processor with a separable approximation of the color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  The simplifier is a bilateral filter with a box shaped spatial window, so its cost 
+//  grows with the square of the window. Here each phase is split into a horizontal and 
+//  then a vertical pass along a single row or column of the window. Both passes weight 
+//  their neighbors by distance in U and V from the pixel in the phase's source frame, 
+//  so edges in the source are respected by both. The cost grows linearly with the window.
+//
+//  Unlike the exact filter each pass includes the pixel itself. Features that are only 
+//  visible along a diagonal of the window are smoothed a little less.
+//
+//  When comparing quality the exact simplifier is also run on each frame and the peak 
+//  signal to noise ratio of the approximation, relative to the exact result, is recorded.
+//  It depends heavily on the frame and does not change monotonically with the window, so 
+//  measure it on representative frames (CartoonizerBatch --compare) for each window used.
+
+class ImageProcessorCpuSeparable : public ImageProcessorCpuSimd
+{
+private:
+    PlanarFrame m_intermediate;
+    std::array<PlanarFrame, kBufSize> m_exactPlanes;
+    bool m_isComparingQuality;
+    double m_lastPsnr;
+
+public:
+    ImageProcessorCpuSeparable(bool isComparingQuality = false) : 
+        m_isComparingQuality(isComparingQuality),
+        m_lastPsnr(0.0)
+    {
+    }
+
+    //  PSNR in dB of the last frame when comparing quality. Infinite if the results matched.
+
+    inline double GetLastPsnr() const { return m_lastPsnr; }
+
+protected:
+    const PlanarFrame& SimplifyFrame(const PlanarFrame& srcFrame, UINT phases, UINT neighborWindow)
+    {
+        const UINT width = srcFrame.Width();
+        const UINT height = srcFrame.Height();
+        m_planes[kCurrent].Resize(width, height);
+        m_planes[kNext].Resize(width, height);
+        m_intermediate.Resize(width, height);
+
+        const PlanarFrame* src = &srcFrame;
+        int next = kCurrent;
+        const UINT shift = neighborWindow / 2;
+
+        for (UINT i = 0; i < phases; ++i)
+        {
+            ApplyColorSimplifierSeparable(*src, m_intermediate, m_planes[next], neighborWindow, 
+                shift, shift, InteriorEnd(width, shift), InteriorEnd(height, shift), m_useAvx2);
+            src = &m_planes[next];
+            next = 1 - next;
+        }
+
+        if (m_isComparingQuality)
+        {
+            const PlanarFrame& exact = SimplifyFrameExact(srcFrame, m_exactPlanes, phases, neighborWindow, m_useAvx2);
+            m_lastPsnr = CalculatePsnr(exact, *src, shift, shift, InteriorEnd(width, shift), InteriorEnd(height, shift));
+        }
+        return *src;
+    }
+
+    //  Simplify the pixels inside the bounds, using intermediateFrame for the horizontal
+    //  pass, and copy the remaining pixels unchanged.
+
+    static void ApplyColorSimplifierSeparable(const PlanarFrame& srcFrame, PlanarFrame& intermediateFrame, PlanarFrame& destFrame, 
+        UINT neighborWindow, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2);
+
+    static void FilterRow(const PlanarFrame& guideFrame, const PlanarFrame& srcFrame, PlanarFrame& destFrame, 
+        UINT neighborWindow, UINT y, UINT startWidth, UINT endWidth, bool isVertical);
+
+    TARGET_AVX2 static void FilterRowAvx2(const PlanarFrame& guideFrame, const PlanarFrame& srcFrame, PlanarFrame& destFrame, 
+        UINT neighborWindow, UINT y, UINT startWidth, UINT endWidth, bool isVertical);
+
+    static double CalculatePsnr(const PlanarFrame& expectedFrame, const PlanarFrame& actualFrame,
+        UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight);
+};
@@ -0,0 +1,164 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#include <math.h>
+#include <assert.h>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "ImageProcessorCpuSimd.h"
+#include "FastExp.h"
+#include "Parallel.h"
+
+//--------------------------------------------------------------------------------------
+//  Color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  The same filter as FrameProcessorCpuBase::SimplifyIndex. The distance between two 
+//  pixels is only ever squared so it is calculated directly from the U and V planes 
+//  without a square root. Each destination row's YUV planes are updated as soon as the 
+//  row is complete, ready for the next phase.
+
+void ImageProcessorCpuSimd::ApplyColorSimplifierSimd(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow,
+    UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2)
+{
+    assert((srcFrame.Width() == destFrame.Width()) && (srcFrame.Height() == destFrame.Height()));
+
+    ParallelFor(0u, srcFrame.Height(), [=, &srcFrame, &destFrame](UINT y)
+    {
+        SimplifyRowOrCopy(srcFrame, destFrame, neighborWindow, y, startWidth, startHeight, endWidth, endHeight, useAvx2);
+    });
+}
+
+void ImageProcessorCpuSimd::SimplifyRowOrCopy(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+    UINT y, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2)
+{
+    const UINT width = srcFrame.Width();
+    if ((y < startHeight) || (y >= endHeight) || (startWidth >= endWidth))
+    {
+        destFrame.CopyRow(srcFrame, y, 0, width);
+        return;
+    }
+    destFrame.CopyRow(srcFrame, y, 0, startWidth);
+    destFrame.CopyRow(srcFrame, y, endWidth, width);
+    if (useAvx2)
+        SimplifyRowAvx2(srcFrame, destFrame, neighborWindow, y, startWidth, endWidth);
+    else
+        SimplifyRow(srcFrame, destFrame, neighborWindow, y, startWidth, endWidth);
+    destFrame.UpdateYuv(y, startWidth, endWidth);
+}
+
+void ImageProcessorCpuSimd::SimplifyRow(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+    UINT idxY, UINT startWidth, UINT endWidth)
+{
+    const int shift = neighborWindow / 2;
+    const float* orgU = srcFrame.Row(PlanarFrame::kU, idxY);
+    const float* orgV = srcFrame.Row(PlanarFrame::kV, idxY);
+    float* destR = destFrame.Row(PlanarFrame::kR, idxY);
+    float* destG = destFrame.Row(PlanarFrame::kG, idxY);
+    float* destB = destFrame.Row(PlanarFrame::kB, idxY);
+
+    for (int idxX = startWidth; idxX < int(endWidth); ++idxX)
+    {
+        float sum = 0;
+        float partialSumR = 0, partialSumG = 0, partialSumB = 0;
+
+        for (int y = (int(idxY) - shift); y <= (int(idxY) + shift); ++y)
+        {
+            const float* r = srcFrame.Row(PlanarFrame::kR, y);
+            const float* g = srcFrame.Row(PlanarFrame::kG, y);
+            const float* b = srcFrame.Row(PlanarFrame::kB, y);
+            const float* u = srcFrame.Row(PlanarFrame::kU, y);
+            const float* v = srcFrame.Row(PlanarFrame::kV, y);
+            for (int x = (idxX - shift); x <= (idxX + shift); ++x)
+            {
+                if (x == idxX && y == int(idxY)) // don't apply filter to the requested index, only to the neighbors
+                    continue;
+
+                const float du = u[x] - orgU[idxX];
+                const float dv = v[x] - orgV[idxX];
+                const float value = FastMath::Exp(Decay() * (du * du + dv * dv));
+                sum += value;
+                partialSumR += r[x] * value;
+                partialSumG += g[x] * value;
+                partialSumB += b[x] * value;
+            }
+        }
+
+        destR[idxX] = floorf(std::min(std::max(partialSumR / sum, 0.0f), 255.0f));
+        destG[idxX] = floorf(std::min(std::max(partialSumG / sum, 0.0f), 255.0f));
+        destB[idxX] = floorf(std::min(std::max(partialSumB / sum, 0.0f), 255.0f));
+    }
+}
+
+//  Eight adjacent pixels are simplified together. Their neighbors at each offset are 
+//  also adjacent so are read with a single unaligned load from each plane. Any pixels 
+//  left over at the end of the row use the scalar version.
+
+void ImageProcessorCpuSimd::SimplifyRowAvx2(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+    UINT idxY, UINT startWidth, UINT endWidth)
+{
+    const int shift = neighborWindow / 2;
+    const float* orgU = srcFrame.Row(PlanarFrame::kU, idxY);
+    const float* orgV = srcFrame.Row(PlanarFrame::kV, idxY);
+    float* destR = destFrame.Row(PlanarFrame::kR, idxY);
+    float* destG = destFrame.Row(PlanarFrame::kG, idxY);
+    float* destB = destFrame.Row(PlanarFrame::kB, idxY);
+
+    const __m256 decay = _mm256_set1_ps(Decay());
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 maxValue = _mm256_set1_ps(255.0f);
+
+    UINT idxX = startWidth;
+    for (; (idxX + 8) <= endWidth; idxX += 8)
+    {
+        const __m256 u0 = _mm256_loadu_ps(orgU + idxX);
+        const __m256 v0 = _mm256_loadu_ps(orgV + idxX);
+        __m256 sum = zero;
+        __m256 partialSumR = zero, partialSumG = zero, partialSumB = zero;
+
+        for (int dy = -shift; dy <= shift; ++dy)
+        {
+            const UINT y = idxY + dy;
+            const float* r = srcFrame.Row(PlanarFrame::kR, y) + idxX;
+            const float* g = srcFrame.Row(PlanarFrame::kG, y) + idxX;
+            const float* b = srcFrame.Row(PlanarFrame::kB, y) + idxX;
+            const float* u = srcFrame.Row(PlanarFrame::kU, y) + idxX;
+            const float* v = srcFrame.Row(PlanarFrame::kV, y) + idxX;
+            for (int dx = -shift; dx <= shift; ++dx)
+            {
+                if (dx == 0 && dy == 0)
+                    continue;
+
+                const __m256 du = _mm256_sub_ps(_mm256_loadu_ps(u + dx), u0);
+                const __m256 dv = _mm256_sub_ps(_mm256_loadu_ps(v + dx), v0);
+                const __m256 value = FastMath::Exp(_mm256_mul_ps(decay, _mm256_add_ps(_mm256_mul_ps(du, du), _mm256_mul_ps(dv, dv))));
+                sum = _mm256_add_ps(sum, value);
+                partialSumR = _mm256_add_ps(partialSumR, _mm256_mul_ps(_mm256_loadu_ps(r + dx), value));
+                partialSumG = _mm256_add_ps(partialSumG, _mm256_mul_ps(_mm256_loadu_ps(g + dx), value));
+                partialSumB = _mm256_add_ps(partialSumB, _mm256_mul_ps(_mm256_loadu_ps(b + dx), value));
+            }
+        }
+
+        _mm256_storeu_ps(destR + idxX, _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(_mm256_div_ps(partialSumR, sum), zero), maxValue)));
+        _mm256_storeu_ps(destG + idxX, _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(_mm256_div_ps(partialSumG, sum), zero), maxValue)));
+        _mm256_storeu_ps(destB + idxX, _mm256_floor_ps(_mm256_min_ps(_mm256_max_ps(_mm256_div_ps(partialSumB, sum), zero), maxValue)));
+    }
+    _mm256_zeroupper();
+
+    if (idxX < endWidth)
+        SimplifyRow(srcFrame, destFrame, neighborWindow, idxY, idxX, endWidth);
+}
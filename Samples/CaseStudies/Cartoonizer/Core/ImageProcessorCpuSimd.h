@@ -0,0 +1,129 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+
+#include "CpuFeatures.h"
+#include "IImageProcessor.h"
+#include "Image32.h"
+#include "PlanarEdgeDetector.h"
+#include "PlanarFrame.h"
+
+//--------------------------------------------------------------------------------------
+//  Multi-core CPU image processor with a vectorized color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  The frame is converted to planar YUV once and each simplifier phase works on the 
+//  planes, weighting eight neighboring pixels at a time with AVX2 when the CPU supports
+//  it. The planes of the original and the simplified frame are then passed directly to
+//  the edge detection, so neither is converted to YUV again.
+
+class ImageProcessorCpuSimd : public IImageProcessor
+{
+protected:
+    enum FrameBuffers
+    {
+        kCurrent = 0,
+        kNext = 1,
+        kBufSize = 2
+    };
+
+    PlanarFrame m_original;
+    std::array<PlanarFrame, kBufSize> m_planes;
+    bool m_useAvx2;
+
+public:
+    ImageProcessorCpuSimd() : m_useAvx2(IsAvx2Supported()) { }
+
+    void ProcessImage(const Image32& srcImage, Image32& destImage, 
+        UINT phases, UINT neighborWindow)
+    {
+        assert((srcImage.Width() == destImage.Width()) && (srcImage.Height() == destImage.Height()));
+        assert(phases > 0);
+        assert(neighborWindow > 0);
+
+        m_original.Load(srcImage);
+        const PlanarFrame& simplified = SimplifyFrame(m_original, phases, neighborWindow);
+
+        const UINT shift = neighborWindow / 2 + 1;
+        PlanarEdgeDetector::ApplyEdgeDetection(simplified, m_original, destImage,
+            shift, shift, InteriorEnd(srcImage.Width(), shift), InteriorEnd(srcImage.Height(), shift), true, m_useAvx2);
+    }
+
+protected:
+    //  End of the interior of a frame, border pixels in from each edge. Never before the 
+    //  start, so in a frame too small to have an interior nothing is simplified or detected.
+
+    static inline UINT InteriorEnd(UINT size, UINT border) { return std::max(size, 2 * border) - border; }
+
+    //  Simplify srcFrame and return the result, which is one of m_planes.
+
+    virtual const PlanarFrame& SimplifyFrame(const PlanarFrame& srcFrame, UINT phases, UINT neighborWindow)
+    {
+        return SimplifyFrameExact(srcFrame, m_planes, phases, neighborWindow, m_useAvx2);
+    }
+
+    //  Process the image. Each phase reads the result of the previous one, alternating 
+    //  between the two frame buffers.
+
+    static const PlanarFrame& SimplifyFrameExact(const PlanarFrame& srcFrame, std::array<PlanarFrame, kBufSize>& planes, 
+        UINT phases, UINT neighborWindow, bool useAvx2)
+    {
+        const UINT width = srcFrame.Width();
+        const UINT height = srcFrame.Height();
+        planes[kCurrent].Resize(width, height);
+        planes[kNext].Resize(width, height);
+
+        const PlanarFrame* src = &srcFrame;
+        int next = kCurrent;
+        const UINT shift = neighborWindow / 2;
+
+        for (UINT i = 0; i < phases; ++i)
+        {
+            ApplyColorSimplifierSimd(*src, planes[next], neighborWindow, 
+                shift, shift, InteriorEnd(width, shift), InteriorEnd(height, shift), useAvx2);
+            src = &planes[next];
+            next = 1 - next;
+        }
+        return *src;
+    }
+
+    // k is the exponential decay constant and is calculated from a standard deviation of 0.025
+
+    static inline float Decay() 
+    { 
+        const float standardDeviation = 0.025f;
+        return -0.5f / (standardDeviation * standardDeviation); 
+    }
+
+    //  Simplify the pixels inside the bounds and copy the remaining pixels unchanged.
+
+    static void ApplyColorSimplifierSimd(const PlanarFrame& srcFrame, PlanarFrame& destFrame,
+        UINT neighborWindow, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2);
+
+    static void SimplifyRowOrCopy(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+        UINT y, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool useAvx2);
+
+    static void SimplifyRow(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+        UINT y, UINT startWidth, UINT endWidth);
+
+    TARGET_AVX2 static void SimplifyRowAvx2(const PlanarFrame& srcFrame, PlanarFrame& destFrame, UINT neighborWindow, 
+        UINT y, UINT startWidth, UINT endWidth);
+};
@@ -0,0 +1,62 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#if defined(_MSC_VER)
+#include <ppl.h>
+#else
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+#include "Image32.h"
+
+//--------------------------------------------------------------------------------------
+//  Parallel loop for the platform neutral image processors.
+//--------------------------------------------------------------------------------------
+//
+//  Calls func(i) for every i in [first, last). Visual C++ uses the PPL. Elsewhere one 
+//  thread per core claims the next index from a shared counter until none are left. 
+//  Either way func must be safe to call concurrently for different indices.
+
+template <typename Func>
+inline void ParallelFor(UINT first, UINT last, const Func& func)
+{
+#if defined(_MSC_VER)
+    concurrency::parallel_for(first, last, func);
+#else
+    if (first >= last)
+        return;
+
+    const UINT workers = std::min(last - first, std::max(std::thread::hardware_concurrency(), 1u));
+    std::atomic<UINT> next(first);
+    auto work = [&next, last, &func]()
+    {
+        for (UINT i = next++; i < last; i = next++)
+            func(i);
+    };
+
+    std::vector<std::thread> threads;
+    for (UINT i = 1; i < workers; ++i)
+        threads.push_back(std::thread(work));
+    work();
+    for (auto& t : threads)
+        t.join();
+#endif
+}
@@ -0,0 +1,181 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#include <math.h>
+#include <assert.h>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "PlanarEdgeDetector.h"
+#include "Parallel.h"
+
+//--------------------------------------------------------------------------------------
+//  Edge detection.
+//--------------------------------------------------------------------------------------
+//
+//  The same filter as the original FrameProcessorCpuBase::ApplyEdgeDetectionMulti. The
+//  gradients are summed in a different order so may differ in the last bit, which very 
+//  occasionally changes a channel by one.
+
+void PlanarEdgeDetector::ApplyEdgeDetection(const PlanarFrame& srcFrame, const PlanarFrame& orgFrame, Image32& destImage, 
+    UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool isParallel, bool useAvx2)
+{
+    assert((srcFrame.Width() == orgFrame.Width()) && (srcFrame.Height() == orgFrame.Height()));
+    assert((srcFrame.Width() == destImage.Width()) && (srcFrame.Height() == destImage.Height()));
+
+    auto detectRow = [=, &srcFrame, &orgFrame, &destImage](UINT y)
+    {
+        ApplyEdgeDetectionRow(srcFrame, orgFrame, destImage.Row(y), y, startWidth, endWidth, useAvx2);
+    };
+
+    if (isParallel)
+        ParallelFor(startHeight, endHeight, detectRow);
+    else
+        for (UINT y = startHeight; y < endHeight; ++y)
+            detectRow(y);
+}
+
+void PlanarEdgeDetector::ApplyEdgeDetectionRow(const PlanarFrame& srcFrame, const PlanarFrame& orgFrame, 
+    byte* destPixels, UINT y, UINT startWidth, UINT endWidth, bool useAvx2)
+{
+    const float beta = 0.8f;        // Weighting of source (color simplied) frame for edge detection
+
+    const float s0 = 0.054f;        // Minimum Threshold of source frame Sobel value to detect an edge
+    const float s1 = 0.064f;        // Maximum Threshold of source frame Sobel value to effect the darkness of the edge
+    const float a0 = 0.3f;          // Minimum Threshold of original frame Sobel value to detect an edge
+    const float a1 = 0.7f;          // Maximum Threshold of original frame Sobel value to effect the darkness of the edge
+
+    const float* r = srcFrame.Row(PlanarFrame::kR, y);
+    const float* g = srcFrame.Row(PlanarFrame::kG, y);
+    const float* b = srcFrame.Row(PlanarFrame::kB, y);
+    float edgeS[kChunkWidth];
+    float edgeA[kChunkWidth];
+
+    for (UINT x = startWidth; x < endWidth; x += kChunkWidth)
+    {
+        const UINT count = std::min(endWidth - x, UINT(kChunkWidth));
+        CalculateEdges(srcFrame, y, x, count, edgeS, useAvx2);
+        CalculateEdges(orgFrame, y, x, count, edgeA, useAvx2);
+
+        for (UINT i = 0; i < count; ++i)
+        {
+            const float intensity = (1 - beta) * SmoothStep(s0, s1, edgeS[i]) + beta * SmoothStep(a0, a1, edgeA[i]);
+            const float oneMinusi = 1 - intensity;
+            destPixels[4 * (x + i)] = static_cast<byte>(b[x + i] * oneMinusi);
+            destPixels[4 * (x + i) + 1] = static_cast<byte>(g[x + i] * oneMinusi);
+            destPixels[4 * (x + i) + 2] = static_cast<byte>(r[x + i] * oneMinusi);
+        }
+    }
+}
+
+void PlanarEdgeDetector::CalculateEdges(const PlanarFrame& srcFrame, UINT y, UINT startWidth, UINT count, 
+    float* edges, bool useAvx2)
+{
+    const float alpha = 0.3f;       // Weighting of original frame for edge detection
+
+    float dy[kChunkWidth];
+    float du[kChunkWidth];
+    float dv[kChunkWidth];
+    if (useAvx2)
+    {
+        CalculateSobelAvx2(srcFrame, PlanarFrame::kY, y, startWidth, count, dy);
+        CalculateSobelAvx2(srcFrame, PlanarFrame::kU, y, startWidth, count, du);
+        CalculateSobelAvx2(srcFrame, PlanarFrame::kV, y, startWidth, count, dv);
+    }
+    else
+    {
+        CalculateSobel(srcFrame, PlanarFrame::kY, y, startWidth, count, dy);
+        CalculateSobel(srcFrame, PlanarFrame::kU, y, startWidth, count, du);
+        CalculateSobel(srcFrame, PlanarFrame::kV, y, startWidth, count, dv);
+    }
+
+    for (UINT i = 0; i < count; ++i)
+        edges[i] = (1 - alpha) * dy[i] + alpha * (du[i] + dv[i]) / 2;
+}
+
+//  The vertical passes cover one extra column either side of the pixels, which the 
+//  horizontal passes read as neighbors. Element i of smooth and diff is the column at 
+//  startWidth + i - 1.
+
+void PlanarEdgeDetector::CalculateSobel(const PlanarFrame& srcFrame, PlanarFrame::Plane plane, 
+    UINT y, UINT startWidth, UINT count, float* magnitudes)
+{
+    assert((count <= kChunkWidth) && (startWidth > 0) && ((startWidth + count) < srcFrame.Width()));
+    assert((y > 0) && ((y + 1) < srcFrame.Height()));
+
+    const float* above = srcFrame.Row(plane, y - 1) + startWidth - 1;
+    const float* row = srcFrame.Row(plane, y) + startWidth - 1;
+    const float* below = srcFrame.Row(plane, y + 1) + startWidth - 1;
+    float smooth[kChunkWidth + 2];
+    float diff[kChunkWidth + 2];
+
+    for (UINT i = 0; i < (count + 2); ++i)
+    {
+        smooth[i] = (above[i] + below[i]) + 2 * row[i];
+        diff[i] = below[i] - above[i];
+    }
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        const float gx = (diff[i] + diff[i + 2]) + 2 * diff[i + 1];
+        const float gy = smooth[i + 2] - smooth[i];
+        magnitudes[i] = sqrt((gx * gx) + (gy * gy));
+    }
+}
+
+void PlanarEdgeDetector::CalculateSobelAvx2(const PlanarFrame& srcFrame, PlanarFrame::Plane plane, 
+    UINT y, UINT startWidth, UINT count, float* magnitudes)
+{
+    assert((count <= kChunkWidth) && (startWidth > 0) && ((startWidth + count) < srcFrame.Width()));
+    assert((y > 0) && ((y + 1) < srcFrame.Height()));
+
+    const float* above = srcFrame.Row(plane, y - 1) + startWidth - 1;
+    const float* row = srcFrame.Row(plane, y) + startWidth - 1;
+    const float* below = srcFrame.Row(plane, y + 1) + startWidth - 1;
+    float smooth[kChunkWidth + 2];
+    float diff[kChunkWidth + 2];
+
+    UINT i = 0;
+    for (; (i + 8) <= (count + 2); i += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(above + i);
+        const __m256 r = _mm256_loadu_ps(row + i);
+        const __m256 b = _mm256_loadu_ps(below + i);
+        _mm256_storeu_ps(smooth + i, _mm256_add_ps(_mm256_add_ps(a, b), _mm256_add_ps(r, r)));
+        _mm256_storeu_ps(diff + i, _mm256_sub_ps(b, a));
+    }
+    for (; i < (count + 2); ++i)
+    {
+        smooth[i] = (above[i] + below[i]) + 2 * row[i];
+        diff[i] = below[i] - above[i];
+    }
+
+    for (i = 0; (i + 8) <= count; i += 8)
+    {
+        const __m256 d1 = _mm256_loadu_ps(diff + i + 1);
+        const __m256 gx = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(diff + i), _mm256_loadu_ps(diff + i + 2)), _mm256_add_ps(d1, d1));
+        const __m256 gy = _mm256_sub_ps(_mm256_loadu_ps(smooth + i + 2), _mm256_loadu_ps(smooth + i));
+        _mm256_storeu_ps(magnitudes + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy))));
+    }
+    _mm256_zeroupper();
+
+    for (; i < count; ++i)
+    {
+        const float gx = (diff[i] + diff[i + 2]) + 2 * diff[i + 1];
+        const float gy = smooth[i + 2] - smooth[i];
+        magnitudes[i] = sqrt((gx * gx) + (gy * gy));
+    }
+}
@@ -0,0 +1,108 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "Image32.h"
+#include "PlanarFrame.h"
+
+//--------------------------------------------------------------------------------------
+//  Edge detection engine for the CPU image processors.
+//--------------------------------------------------------------------------------------
+//
+//  FrameProcessorCpuBase::CalculateSobel used to convert all nine neighbors of a pixel 
+//  to YUV and was called for both the simplified and the original frame, so every pixel 
+//  was converted 18 times. Here both frames are converted to YUV planes once. 
+//
+//  The Sobel kernels are separable: Gx is a [-1 0 1] difference down each column followed 
+//  by a [1 2 1] smoothing along the row, Gy is a [1 2 1] smoothing down each column 
+//  followed by a [-1 0 1] difference along the row. Each row is processed in chunks. The
+//  vertical passes are calculated once for every column of a chunk and then reused by the 
+//  three pixels that read them in the horizontal passes. With AVX2 each pass handles 
+//  eight columns at a time. The scalar and AVX2 versions perform the same operations so 
+//  give the same results.
+
+class PlanarEdgeDetector
+{
+public:
+    static const UINT kChunkWidth = 128;
+
+private:
+    PlanarFrame m_source;
+    PlanarFrame m_original;
+    bool m_useAvx2;
+
+public:
+    PlanarEdgeDetector() : m_useAvx2(IsAvx2Supported()) { }
+
+    //  Detect edges in images, converting each to planes first. Runs on the calling 
+    //  thread unless isParallel is set.
+
+    void Apply(const Image32& srcImage, Image32& destImage, const Image32& orgImage, 
+        UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool isParallel)
+    {
+        if (isParallel)
+        {
+            m_source.Load(srcImage);
+            m_original.Load(orgImage);
+        }
+        else
+        {
+            m_source.LoadRegion(srcImage, 0, 0, srcImage.Width(), srcImage.Height());
+            m_original.LoadRegion(orgImage, 0, 0, orgImage.Width(), orgImage.Height());
+        }
+        ApplyEdgeDetection(m_source, m_original, destImage, startWidth, startHeight, endWidth, endHeight, 
+            isParallel, m_useAvx2);
+    }
+
+    //  Detect edges in frames that are already planar. The planar frames and destImage 
+    //  must be the same size.
+
+    static void ApplyEdgeDetection(const PlanarFrame& srcFrame, const PlanarFrame& orgFrame, Image32& destImage, 
+        UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight, bool isParallel, bool useAvx2);
+
+    //  Detect edges in part of a row. destPixels is the first pixel of the destination 
+    //  row, which corresponds to x = 0 in the planar frames.
+
+    static void ApplyEdgeDetectionRow(const PlanarFrame& srcFrame, const PlanarFrame& orgFrame, 
+        byte* destPixels, UINT y, UINT startWidth, UINT endWidth, bool useAvx2);
+
+private:
+    //  The same as ImageUtils::SmoothStep, an implementation of direct3d::smoothstep.
+
+    static inline float SmoothStep(float a, float b, float x)
+    {
+        if (x < a) return 0.0f;
+        if (x >= b) return 1.0f;
+
+        x = (x - a) / (b - a);
+        return (x * x * (3.0f - 2.0f * x));
+    }
+
+    //  Gradient magnitude of one plane for count pixels starting at (startWidth, y).
+
+    static void CalculateSobel(const PlanarFrame& srcFrame, PlanarFrame::Plane plane, 
+        UINT y, UINT startWidth, UINT count, float* magnitudes);
+
+    TARGET_AVX2 static void CalculateSobelAvx2(const PlanarFrame& srcFrame, PlanarFrame::Plane plane, 
+        UINT y, UINT startWidth, UINT count, float* magnitudes);
+
+    //  Combine the Y, U and V gradients into a single edge strength for each pixel.
+
+    static void CalculateEdges(const PlanarFrame& srcFrame, UINT y, UINT startWidth, UINT count, 
+        float* edges, bool useAvx2);
+};
@@ -0,0 +1,185 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+#include "Image32.h"
+#include "Parallel.h"
+
+//--------------------------------------------------------------------------------------
+//  Frame stored as one float plane per channel for the CPU frame processors.
+//--------------------------------------------------------------------------------------
+//
+//  Holds the R, G and B values (0 to 255) of each pixel along with its Y, U and V values, 
+//  so that each pixel is converted to YUV once rather than every time it is read. Rows are 
+//  padded to a multiple of eight floats so a row can be read eight pixels at a time.
+
+class PlanarFrame
+{
+public:
+    enum Plane
+    {
+        kR = 0,
+        kG,
+        kB,
+        kY,
+        kU,
+        kV,
+        kPlaneCount
+    };
+
+    static const UINT kRowAlignment = 8;
+
+private:
+    std::vector<float> m_data;
+    UINT m_width;
+    UINT m_height;
+    UINT m_stride;
+
+public:
+    PlanarFrame() : m_width(0), m_height(0), m_stride(0) { }
+
+    void Resize(UINT width, UINT height)
+    {
+        if ((m_width == width) && (m_height == height))
+            return;
+        m_width = width;
+        m_height = height;
+        m_stride = (width + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+        m_data.resize(size_t(kPlaneCount) * m_stride * m_height);
+    }
+
+    inline UINT Width() const { return m_width; }
+
+    inline UINT Height() const { return m_height; }
+
+    inline float* Row(Plane plane, UINT y) 
+    {
+        assert(y < m_height);
+        return &m_data[(size_t(plane) * m_height + y) * m_stride];
+    }
+
+    inline const float* Row(Plane plane, UINT y) const
+    {
+        assert(y < m_height);
+        return &m_data[(size_t(plane) * m_height + y) * m_stride];
+    }
+
+    //  Read an image and convert every pixel to YUV.
+
+    void Load(const Image32& srcImage)
+    {
+        Resize(srcImage.Width(), srcImage.Height());
+        ParallelFor(0u, m_height, [this, &srcImage](UINT y)
+        {
+            LoadRow(srcImage, 0, y, y);
+        });
+    }
+
+    //  Read a region of an image on the calling thread. The frame is resized to the 
+    //  region and its top left pixel becomes (0, 0).
+
+    void LoadRegion(const Image32& srcImage, UINT left, UINT top, UINT width, UINT height)
+    {
+        assert(((left + width) <= srcImage.Width()) && ((top + height) <= srcImage.Height()));
+
+        Resize(width, height);
+        for (UINT y = 0; y < m_height; ++y)
+            LoadRow(srcImage, left, top + y, y);
+    }
+
+    //  Write part of the frame, truncating each channel to a byte as the 8-bit frame 
+    //  buffers do.
+
+    void Store(Image32& destImage, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight) const
+    {
+        assert((endWidth <= m_width) && (endHeight <= m_height));
+        assert((endWidth <= destImage.Width()) && (endHeight <= destImage.Height()));
+
+        ParallelFor(startHeight, endHeight, [=, &destImage](UINT y)
+        {
+            byte* pixels = destImage.Row(y);
+            const float* r = Row(kR, y);
+            const float* g = Row(kG, y);
+            const float* b = Row(kB, y);
+            for (UINT x = startWidth; x < endWidth; ++x)
+            {
+                pixels[4 * x] = static_cast<byte>(b[x]);
+                pixels[4 * x + 1] = static_cast<byte>(g[x]);
+                pixels[4 * x + 2] = static_cast<byte>(r[x]);
+            }
+        });
+    }
+
+    //  Recalculate Y, U and V from R, G and B for part of a row. Matches ImageUtils::RGBToYUV
+    //  with the weights in ImageUtils::W.
+
+    void UpdateYuv(UINT y, UINT startWidth, UINT endWidth)
+    {
+        const float weightR = 0.299f;
+        const float weightG = 0.114f;
+        const float weightB = 1.000f - 0.299f - 0.114f;
+        const float wr = weightR / 255.0f;
+        const float wg = weightG / 255.0f;
+        const float wb = weightB / 255.0f;
+        const float uScale = 0.436f / (1 - weightB);
+        const float vScale = 0.615f / (1 - weightG);
+
+        const float* r = Row(kR, y);
+        const float* g = Row(kG, y);
+        const float* b = Row(kB, y);
+        float* yy = Row(kY, y);
+        float* u = Row(kU, y);
+        float* v = Row(kV, y);
+        for (UINT x = startWidth; x < endWidth; ++x)
+        {
+            yy[x] = wr * r[x] + wg * g[x] + wb * b[x];
+            u[x] = uScale * (b[x] / 255.0f - yy[x]);
+            v[x] = vScale * (r[x] / 255.0f - yy[x]);
+        }
+    }
+
+    //  Copy every plane of part of a row from another frame of the same size.
+
+    void CopyRow(const PlanarFrame& srcFrame, UINT y, UINT startWidth, UINT endWidth)
+    {
+        assert((srcFrame.m_width == m_width) && (srcFrame.m_height == m_height));
+
+        for (int plane = 0; plane < kPlaneCount; ++plane)
+            std::copy(srcFrame.Row(Plane(plane), y) + startWidth, srcFrame.Row(Plane(plane), y) + endWidth, 
+                Row(Plane(plane), y) + startWidth);
+    }
+
+private:
+    void LoadRow(const Image32& srcImage, UINT left, UINT srcY, UINT y)
+    {
+        const byte* pixels = srcImage.Row(srcY) + 4 * left;
+        float* r = Row(kR, y);
+        float* g = Row(kG, y);
+        float* b = Row(kB, y);
+        for (UINT x = 0; x < m_width; ++x)
+        {
+            b[x] = pixels[4 * x];
+            g[x] = pixels[4 * x + 1];
+            r[x] = pixels[4 * x + 2];
+        }
+        UpdateYuv(y, 0, m_width);
+    }
+};
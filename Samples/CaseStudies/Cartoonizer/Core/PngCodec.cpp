@@ -0,0 +1,815 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "ImageIo.h"
+
+//--------------------------------------------------------------------------------------
+//  PNG decoder and encoder, including the zlib inflate and deflate they need.
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    //  Checksums. CRC-32 covers each PNG chunk and Adler-32 the uncompressed zlib data.
+
+    std::vector<uint32_t> MakeCrcTable()
+    {
+        std::vector<uint32_t> table(256);
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            table[n] = c;
+        }
+        return table;
+    }
+
+    const std::vector<uint32_t> crcTable = MakeCrcTable();
+
+    uint32_t Crc32(const byte* data, size_t length)
+    {
+        uint32_t c = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; ++i)
+            c = crcTable[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+        return c ^ 0xFFFFFFFFu;
+    }
+
+    uint32_t Adler32(const byte* data, size_t length)
+    {
+        const uint32_t modulus = 65521;
+        uint32_t a = 1, b = 0;
+        while (length > 0)
+        {
+            //  The largest block that cannot overflow b before it is reduced.
+            const size_t block = std::min(length, size_t(5552));
+            for (size_t i = 0; i < block; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= modulus;
+            b %= modulus;
+            data += block;
+            length -= block;
+        }
+        return (b << 16) | a;
+    }
+
+    inline uint32_t ReadBigEndian(const byte* p)
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    inline void WriteBigEndian(std::vector<byte>& out, uint32_t value)
+    {
+        out.push_back(byte(value >> 24));
+        out.push_back(byte(value >> 16));
+        out.push_back(byte(value >> 8));
+        out.push_back(byte(value));
+    }
+
+    inline UINT ReverseBits(UINT code, UINT length)
+    {
+        UINT reversed = 0;
+        for (UINT i = 0; i < length; ++i, code >>= 1)
+            reversed = (reversed << 1) | (code & 1);
+        return reversed;
+    }
+
+    //  Deflate length and distance codes. Symbol i of each covers values from its base 
+    //  to its base plus 2^extra - 1.
+
+    const UINT lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const UINT lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const UINT distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const UINT distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    const UINT kWindowSize = 32768;
+    const UINT kMinMatch = 3;
+    const UINT kMaxMatch = 258;
+
+    //  Code lengths of the fixed Huffman codes.
+
+    std::vector<byte> FixedLiteralLengths()
+    {
+        std::vector<byte> lengths(288, 8);
+        std::fill(lengths.begin() + 144, lengths.begin() + 256, byte(9));
+        std::fill(lengths.begin() + 256, lengths.begin() + 280, byte(7));
+        return lengths;
+    }
+
+    //------------------------------------------------------------------------------
+    //  Inflate.
+    //------------------------------------------------------------------------------
+
+    //  Reads bits least significant first. Reading past the end returns zeros, which 
+    //  is checked for once each block is complete.
+
+    class BitReader
+    {
+    private:
+        const byte* m_data;
+        size_t m_size;
+        size_t m_position;
+        uint64_t m_bits;
+        UINT m_count;
+
+    public:
+        BitReader(const byte* data, size_t size) : m_data(data), m_size(size), m_position(0), m_bits(0), m_count(0) { }
+
+        inline UINT Peek(UINT count)
+        {
+            while (m_count <= 56)
+            {
+                const uint64_t next = (m_position < m_size) ? m_data[m_position] : 0;
+                m_bits |= next << m_count;
+                m_count += 8;
+                ++m_position;
+            }
+            return UINT(m_bits & ((uint64_t(1) << count) - 1));
+        }
+
+        inline void Consume(UINT count)
+        {
+            m_bits >>= count;
+            m_count -= count;
+        }
+
+        inline UINT Read(UINT count)
+        {
+            const UINT value = Peek(count);
+            Consume(count);
+            return value;
+        }
+
+        void AlignToByte()
+        {
+            Consume(m_count % 8);
+        }
+
+        bool IsOverrun() const
+        {
+            return (m_position - m_count / 8) > m_size;
+        }
+    };
+
+    //  Canonical Huffman code decoded with a single table indexed by the next 
+    //  MaxLength bits. Each entry is the symbol and its code length, or zero for 
+    //  bit patterns that are not a code.
+
+    class HuffmanTable
+    {
+    private:
+        std::vector<uint16_t> m_entries;
+        UINT m_maxLength;
+
+    public:
+        HuffmanTable() : m_maxLength(1) { }
+
+        void Build(const byte* lengths, UINT count)
+        {
+            UINT lengthCounts[16] = { 0 };
+            m_maxLength = 1;
+            for (UINT i = 0; i < count; ++i)
+            {
+                ++lengthCounts[lengths[i]];
+                m_maxLength = std::max(m_maxLength, UINT(lengths[i]));
+            }
+            lengthCounts[0] = 0;
+
+            int left = 1;
+            UINT nextCode[16] = { 0 };
+            for (UINT length = 1; length < 16; ++length)
+            {
+                left = (left << 1) - int(lengthCounts[length]);
+                if (left < 0)
+                    throw std::runtime_error("Invalid Huffman code in compressed data");
+                nextCode[length] = (nextCode[length - 1] + lengthCounts[length - 1]) << 1;
+            }
+
+            m_entries.assign(size_t(1) << m_maxLength, 0);
+            for (UINT symbol = 0; symbol < count; ++symbol)
+            {
+                const UINT length = lengths[symbol];
+                if (length == 0)
+                    continue;
+                const UINT reversed = ReverseBits(nextCode[length]++, length);
+                for (UINT i = reversed; i < m_entries.size(); i += (1u << length))
+                    m_entries[i] = uint16_t((symbol << 4) | length);
+            }
+        }
+
+        inline UINT Decode(BitReader& reader) const
+        {
+            const UINT entry = m_entries[reader.Peek(m_maxLength)];
+            if (entry == 0)
+                throw std::runtime_error("Invalid Huffman code in compressed data");
+            reader.Consume(entry & 0xF);
+            return entry >> 4;
+        }
+    };
+
+    void InflateBlock(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, std::vector<byte>& out)
+    {
+        for (;;)
+        {
+            const UINT symbol = literals.Decode(reader);
+            if (symbol < 256)
+            {
+                out.push_back(byte(symbol));
+                continue;
+            }
+            if (symbol == 256)
+                return;
+
+            const UINT lengthSymbol = symbol - 257;
+            if (lengthSymbol >= 29)
+                throw std::runtime_error("Invalid length in compressed data");
+            const UINT length = lengthBase[lengthSymbol] + reader.Read(lengthExtra[lengthSymbol]);
+
+            const UINT distanceSymbol = distances.Decode(reader);
+            if (distanceSymbol >= 30)
+                throw std::runtime_error("Invalid distance in compressed data");
+            const UINT distance = distanceBase[distanceSymbol] + reader.Read(distanceExtra[distanceSymbol]);
+            if (distance > out.size())
+                throw std::runtime_error("Invalid distance in compressed data");
+
+            //  The source and destination may overlap, repeating the last distance bytes.
+            size_t from = out.size() - distance;
+            for (UINT i = 0; i < length; ++i)
+                out.push_back(out[from++]);
+
+            if (reader.IsOverrun())
+                throw std::runtime_error("Truncated compressed data");
+        }
+    }
+
+    void ReadDynamicTables(BitReader& reader, HuffmanTable& literals, HuffmanTable& distances)
+    {
+        const UINT literalCount = reader.Read(5) + 257;
+        const UINT distanceCount = reader.Read(5) + 1;
+        const UINT codeLengthCount = reader.Read(4) + 4;
+
+        const UINT order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        byte codeLengthLengths[19] = { 0 };
+        for (UINT i = 0; i < codeLengthCount; ++i)
+            codeLengthLengths[order[i]] = byte(reader.Read(3));
+        HuffmanTable codeLengths;
+        codeLengths.Build(codeLengthLengths, 19);
+
+        byte lengths[286 + 30];
+        UINT count = 0;
+        while (count < (literalCount + distanceCount))
+        {
+            const UINT symbol = codeLengths.Decode(reader);
+            if (symbol < 16)
+            {
+                lengths[count++] = byte(symbol);
+                continue;
+            }
+
+            byte value = 0;
+            UINT repeat;
+            if (symbol == 16)
+            {
+                if (count == 0)
+                    throw std::runtime_error("Invalid code lengths in compressed data");
+                value = lengths[count - 1];
+                repeat = 3 + reader.Read(2);
+            }
+            else if (symbol == 17)
+                repeat = 3 + reader.Read(3);
+            else
+                repeat = 11 + reader.Read(7);
+
+            if ((count + repeat) > (literalCount + distanceCount))
+                throw std::runtime_error("Invalid code lengths in compressed data");
+            std::fill(lengths + count, lengths + count + repeat, value);
+            count += repeat;
+        }
+        if (lengths[256] == 0)
+            throw std::runtime_error("Missing end of block code in compressed data");
+
+        literals.Build(lengths, literalCount);
+        distances.Build(lengths + literalCount, distanceCount);
+    }
+
+    //  Decompress a zlib stream, checking its Adler-32.
+
+    std::vector<byte> Inflate(const std::vector<byte>& data, size_t expectedSize)
+    {
+        if ((data.size() < 6) || ((data[0] & 0x0F) != 8) || (((data[0] << 8) | data[1]) % 31 != 0) || ((data[1] & 0x20) != 0))
+            throw std::runtime_error("Unsupported compressed data");
+
+        std::vector<byte> out;
+        out.reserve(expectedSize);
+        BitReader reader(data.data() + 2, data.size() - 2);
+
+        HuffmanTable fixedLiterals, fixedDistances;
+        HuffmanTable literals, distances;
+        bool hasFixedTables = false;
+        bool isFinal = false;
+        while (!isFinal)
+        {
+            isFinal = (reader.Read(1) != 0);
+            const UINT type = reader.Read(2);
+            if (type == 0)
+            {
+                reader.AlignToByte();
+                const UINT length = reader.Read(16);
+                const UINT complement = reader.Read(16);
+                if (length != (~complement & 0xFFFF))
+                    throw std::runtime_error("Invalid stored block in compressed data");
+                for (UINT i = 0; i < length; ++i)
+                    out.push_back(byte(reader.Read(8)));
+            }
+            else if (type == 1)
+            {
+                if (!hasFixedTables)
+                {
+                    const std::vector<byte> literalLengths = FixedLiteralLengths();
+                    const std::vector<byte> distanceLengths(30, 5);
+                    fixedLiterals.Build(literalLengths.data(), 288);
+                    fixedDistances.Build(distanceLengths.data(), 30);
+                    hasFixedTables = true;
+                }
+                InflateBlock(reader, fixedLiterals, fixedDistances, out);
+            }
+            else if (type == 2)
+            {
+                ReadDynamicTables(reader, literals, distances);
+                InflateBlock(reader, literals, distances, out);
+            }
+            else
+                throw std::runtime_error("Invalid block type in compressed data");
+
+            if (reader.IsOverrun())
+                throw std::runtime_error("Truncated compressed data");
+        }
+
+        reader.AlignToByte();
+        uint32_t adler = 0;
+        for (int i = 0; i < 4; ++i)
+            adler = (adler << 8) | reader.Read(8);
+        if (reader.IsOverrun() || (adler != Adler32(out.data(), out.size())))
+            throw std::runtime_error("Corrupt compressed data");
+        return out;
+    }
+
+    //------------------------------------------------------------------------------
+    //  Deflate.
+    //------------------------------------------------------------------------------
+
+    //  Writes bits least significant first.
+
+    class BitWriter
+    {
+    private:
+        std::vector<byte>& m_out;
+        uint64_t m_bits;
+        UINT m_count;
+
+    public:
+        BitWriter(std::vector<byte>& out) : m_out(out), m_bits(0), m_count(0) { }
+
+        inline void Write(UINT value, UINT count)
+        {
+            m_bits |= uint64_t(value) << m_count;
+            m_count += count;
+            while (m_count >= 8)
+            {
+                m_out.push_back(byte(m_bits));
+                m_bits >>= 8;
+                m_count -= 8;
+            }
+        }
+
+        void Flush()
+        {
+            if (m_count > 0)
+                m_out.push_back(byte(m_bits));
+            m_bits = 0;
+            m_count = 0;
+        }
+    };
+
+    //  Fixed Huffman codes, already bit reversed for BitWriter.
+
+    class FixedCodes
+    {
+    private:
+        UINT m_literalCodes[288];
+        byte m_literalLengths[288];
+        UINT m_distanceCodes[30];
+        byte m_lengthSymbols[kMaxMatch + 1];
+
+    public:
+        FixedCodes()
+        {
+            const std::vector<byte> lengths = FixedLiteralLengths();
+            UINT lengthCounts[16] = { 0 };
+            for (UINT i = 0; i < 288; ++i)
+                ++lengthCounts[lengths[i]];
+            UINT nextCode[16] = { 0 };
+            for (UINT length = 1; length < 16; ++length)
+                nextCode[length] = (nextCode[length - 1] + ((length > 1) ? lengthCounts[length - 1] : 0)) << 1;
+            for (UINT symbol = 0; symbol < 288; ++symbol)
+            {
+                m_literalLengths[symbol] = lengths[symbol];
+                m_literalCodes[symbol] = ReverseBits(nextCode[lengths[symbol]]++, lengths[symbol]);
+            }
+
+            for (UINT symbol = 0; symbol < 30; ++symbol)
+                m_distanceCodes[symbol] = ReverseBits(symbol, 5);
+
+            for (UINT symbol = 0; symbol < 29; ++symbol)
+                for (UINT length = lengthBase[symbol]; (length <= kMaxMatch) && (length < lengthBase[symbol] + (1u << lengthExtra[symbol])); ++length)
+                    m_lengthSymbols[length] = byte(symbol);
+            m_lengthSymbols[kMaxMatch] = 28;
+        }
+
+        inline void WriteLiteral(BitWriter& writer, UINT symbol) const
+        {
+            writer.Write(m_literalCodes[symbol], m_literalLengths[symbol]);
+        }
+
+        inline void WriteMatch(BitWriter& writer, UINT length, UINT distance) const
+        {
+            const UINT lengthSymbol = m_lengthSymbols[length];
+            WriteLiteral(writer, 257 + lengthSymbol);
+            writer.Write(length - lengthBase[lengthSymbol], lengthExtra[lengthSymbol]);
+
+            const UINT distanceSymbol = UINT(std::upper_bound(distanceBase, distanceBase + 30, distance) - distanceBase) - 1;
+            writer.Write(m_distanceCodes[distanceSymbol], 5);
+            writer.Write(distance - distanceBase[distanceSymbol], distanceExtra[distanceSymbol]);
+        }
+    };
+
+    const FixedCodes fixedCodes;
+
+    inline UINT HashAt(const byte* data)
+    {
+        return ((UINT(data[0]) << 10) ^ (UINT(data[1]) << 5) ^ UINT(data[2])) & (kWindowSize - 1);
+    }
+
+    //  Compress into a zlib stream with a single fixed Huffman block. Matches are found
+    //  greedily by following a short chain of earlier positions with the same three 
+    //  byte hash.
+
+    std::vector<byte> Deflate(const std::vector<byte>& data)
+    {
+        const int kMaxChain = 16;
+
+        std::vector<byte> out;
+        out.reserve(data.size() / 2 + 64);
+        out.push_back(0x78);
+        out.push_back(0x01);
+
+        BitWriter writer(out);
+        writer.Write(1, 1);
+        writer.Write(1, 2);
+
+        std::vector<int> head(kWindowSize, -1);
+        std::vector<int> previous(kWindowSize, -1);
+        const size_t size = data.size();
+        size_t position = 0;
+        while (position < size)
+        {
+            UINT bestLength = 0;
+            UINT bestDistance = 0;
+            if ((position + kMinMatch) <= size)
+            {
+                const UINT hash = HashAt(&data[position]);
+                const UINT maxLength = UINT(std::min(size - position, size_t(kMaxMatch)));
+                int candidate = head[hash];
+                for (int chain = 0; (candidate >= 0) && (chain < kMaxChain); ++chain)
+                {
+                    const size_t distance = position - candidate;
+                    if ((distance == 0) || (distance > kWindowSize))
+                        break;
+
+                    UINT length = 0;
+                    while ((length < maxLength) && (data[candidate + length] == data[position + length]))
+                        ++length;
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = UINT(distance);
+                        if (length == maxLength)
+                            break;
+                    }
+                    candidate = previous[candidate & (kWindowSize - 1)];
+                }
+            }
+
+            const UINT advance = (bestLength >= kMinMatch) ? bestLength : 1;
+            if (bestLength >= kMinMatch)
+                fixedCodes.WriteMatch(writer, bestLength, bestDistance);
+            else
+                fixedCodes.WriteLiteral(writer, data[position]);
+
+            for (size_t end = position + advance; position < end; ++position)
+            {
+                if ((position + kMinMatch) > size)
+                    continue;
+                const UINT hash = HashAt(&data[position]);
+                previous[position & (kWindowSize - 1)] = head[hash];
+                head[hash] = int(position);
+            }
+        }
+
+        fixedCodes.WriteLiteral(writer, 256);
+        writer.Flush();
+        WriteBigEndian(out, Adler32(data.data(), data.size()));
+        return out;
+    }
+
+    //------------------------------------------------------------------------------
+    //  PNG filters.
+    //------------------------------------------------------------------------------
+
+    enum PngFilter
+    {
+        kFilterNone = 0,
+        kFilterSub,
+        kFilterUp,
+        kFilterAverage,
+        kFilterPaeth,
+        kFilterCount
+    };
+
+    inline byte Paeth(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = abs(p - a);
+        const int pb = abs(p - b);
+        const int pc = abs(p - c);
+        if ((pa <= pb) && (pa <= pc))
+            return byte(a);
+        return byte((pb <= pc) ? b : c);
+    }
+
+    //  Predict each byte from its left (a), up (b) and up-left (c) neighbors. Bytes 
+    //  left of the row are zero.
+
+    inline byte Predict(PngFilter filter, const byte* row, const byte* prior, size_t i, UINT bytesPerPixel)
+    {
+        const int a = (i >= bytesPerPixel) ? row[i - bytesPerPixel] : 0;
+        const int b = prior[i];
+        const int c = (i >= bytesPerPixel) ? prior[i - bytesPerPixel] : 0;
+        switch (filter)
+        {
+        case kFilterSub:
+            return byte(a);
+        case kFilterUp:
+            return byte(b);
+        case kFilterAverage:
+            return byte((a + b) / 2);
+        case kFilterPaeth:
+            return Paeth(a, b, c);
+        default:
+            return 0;
+        }
+    }
+
+    //  Image channels for each PNG color type, or zero for invalid types.
+
+    UINT PngChannels(UINT colorType)
+    {
+        switch (colorType)
+        {
+        case 0: return 1;
+        case 2: return 3;
+        case 3: return 1;
+        case 4: return 2;
+        case 6: return 4;
+        default: return 0;
+        }
+    }
+
+    void AppendChunk(std::vector<byte>& out, const char* type, const std::vector<byte>& data)
+    {
+        WriteBigEndian(out, uint32_t(data.size()));
+        const size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        WriteBigEndian(out, Crc32(&out[start], out.size() - start));
+    }
+}
+
+Image32 ImageIo::DecodePng(const std::vector<byte>& data)
+{
+    const size_t kSignatureSize = 8;
+
+    UINT width = 0, height = 0, bitDepth = 0, colorType = 0;
+    std::vector<byte> palette;
+    std::vector<byte> paletteAlpha;
+    std::vector<byte> compressed;
+    bool isEnd = false;
+
+    const byte signature[kSignatureSize] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if ((data.size() < kSignatureSize) || (memcmp(data.data(), signature, kSignatureSize) != 0))
+        throw std::runtime_error("Not a PNG image");
+
+    size_t position = kSignatureSize;
+    while (!isEnd)
+    {
+        if ((data.size() - position) < 12)
+            throw std::runtime_error("Truncated PNG image");
+        const uint32_t length = ReadBigEndian(&data[position]);
+        if ((data.size() - position - 12) < length)
+            throw std::runtime_error("Truncated PNG image");
+        const byte* type = &data[position + 4];
+        const byte* chunk = &data[position + 8];
+        if (Crc32(type, length + 4) != ReadBigEndian(chunk + length))
+            throw std::runtime_error("Corrupt PNG chunk");
+
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length != 13)
+                throw std::runtime_error("Invalid PNG header");
+            width = ReadBigEndian(chunk);
+            height = ReadBigEndian(chunk + 4);
+            bitDepth = chunk[8];
+            colorType = chunk[9];
+            if ((chunk[10] != 0) || (chunk[11] != 0))
+                throw std::runtime_error("Invalid PNG header");
+            if (chunk[12] != 0)
+                throw std::runtime_error("Interlaced PNG images are not supported");
+        }
+        else if (memcmp(type, "PLTE", 4) == 0)
+            palette.assign(chunk, chunk + length);
+        else if (memcmp(type, "tRNS", 4) == 0)
+            paletteAlpha.assign(chunk, chunk + length);
+        else if (memcmp(type, "IDAT", 4) == 0)
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        else if (memcmp(type, "IEND", 4) == 0)
+            isEnd = true;
+        else if ((type[0] & 0x20) == 0)
+            throw std::runtime_error("Unsupported critical PNG chunk");
+        position += length + 12;
+    }
+
+    const UINT channels = PngChannels(colorType);
+    if ((width == 0) || (height == 0) || (width > (1u << 24)) || (height > (1u << 24)) || (channels == 0))
+        throw std::runtime_error("Invalid PNG header");
+    if (!((bitDepth == 8) || ((bitDepth == 16) && (colorType != 3))))
+        throw std::runtime_error("Only 8 and 16-bit PNG images are supported");
+    if ((colorType == 3) && (palette.empty() || ((palette.size() % 3) != 0)))
+        throw std::runtime_error("Invalid PNG palette");
+
+    const UINT bytesPerPixel = channels * bitDepth / 8;
+    const size_t rowBytes = size_t(width) * bytesPerPixel;
+    std::vector<byte> filtered = Inflate(compressed, (rowBytes + 1) * height);
+    if (filtered.size() < ((rowBytes + 1) * height))
+        throw std::runtime_error("Truncated PNG image");
+
+    Image32 image(width, height);
+    std::vector<byte> prior(rowBytes, 0);
+    for (UINT y = 0; y < height; ++y)
+    {
+        const PngFilter filter = PngFilter(filtered[y * (rowBytes + 1)]);
+        if (filter >= kFilterCount)
+            throw std::runtime_error("Invalid PNG filter");
+        byte* row = &filtered[y * (rowBytes + 1) + 1];
+        if (filter != kFilterNone)
+            for (size_t i = 0; i < rowBytes; ++i)
+                row[i] = byte(row[i] + Predict(filter, row, prior.data(), i, bytesPerPixel));
+
+        //  Take the most significant byte of each sample.
+
+        const UINT step = bitDepth / 8;
+        byte* pixels = image.Row(y);
+        for (UINT x = 0; x < width; ++x)
+        {
+            const byte* samples = row + size_t(x) * bytesPerPixel;
+            byte r, g, b, a = 255;
+            if (colorType == 3)
+            {
+                const UINT index = samples[0];
+                if ((3 * index + 2) >= palette.size())
+                    throw std::runtime_error("Invalid PNG palette index");
+                r = palette[3 * index];
+                g = palette[3 * index + 1];
+                b = palette[3 * index + 2];
+                if (index < paletteAlpha.size())
+                    a = paletteAlpha[index];
+            }
+            else if (channels <= 2)
+            {
+                r = g = b = samples[0];
+                if (channels == 2)
+                    a = samples[step];
+            }
+            else
+            {
+                r = samples[0];
+                g = samples[step];
+                b = samples[2 * step];
+                if (channels == 4)
+                    a = samples[3 * step];
+            }
+            pixels[4 * x] = b;
+            pixels[4 * x + 1] = g;
+            pixels[4 * x + 2] = r;
+            pixels[4 * x + 3] = a;
+        }
+        std::copy(row, row + rowBytes, prior.begin());
+    }
+    return image;
+}
+
+//  Each row uses the filter giving the smallest sum of absolute differences, treated
+//  as signed bytes, which usually compresses best.
+
+std::vector<byte> ImageIo::EncodePng(const Image32& image)
+{
+    const UINT width = image.Width();
+    const UINT height = image.Height();
+    bool hasAlpha = false;
+    for (UINT y = 0; (y < height) && !hasAlpha; ++y)
+    {
+        const byte* pixels = image.Row(y);
+        for (UINT x = 0; x < width; ++x)
+            hasAlpha |= (pixels[4 * x + 3] != 255);
+    }
+
+    const UINT bytesPerPixel = hasAlpha ? 4 : 3;
+    const size_t rowBytes = size_t(width) * bytesPerPixel;
+    std::vector<byte> filtered((rowBytes + 1) * height);
+    std::vector<byte> row(rowBytes);
+    std::vector<byte> prior(rowBytes, 0);
+    std::vector<byte> candidate(rowBytes);
+    for (UINT y = 0; y < height; ++y)
+    {
+        const byte* pixels = image.Row(y);
+        for (UINT x = 0; x < width; ++x)
+        {
+            row[x * bytesPerPixel] = pixels[4 * x + 2];
+            row[x * bytesPerPixel + 1] = pixels[4 * x + 1];
+            row[x * bytesPerPixel + 2] = pixels[4 * x];
+            if (hasAlpha)
+                row[x * bytesPerPixel + 3] = pixels[4 * x + 3];
+        }
+
+        byte* out = &filtered[y * (rowBytes + 1)];
+        UINT bestCost = UINT(-1);
+        for (int filter = kFilterNone; filter < kFilterCount; ++filter)
+        {
+            UINT cost = 0;
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                candidate[i] = byte(row[i] - Predict(PngFilter(filter), row.data(), prior.data(), i, bytesPerPixel));
+                cost += abs(int(static_cast<signed char>(candidate[i])));
+            }
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                out[0] = byte(filter);
+                std::copy(candidate.begin(), candidate.end(), out + 1);
+            }
+        }
+        row.swap(prior);
+    }
+
+    std::vector<byte> png;
+    const byte signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.insert(png.end(), signature, signature + sizeof(signature));
+
+    std::vector<byte> header;
+    WriteBigEndian(header, width);
+    WriteBigEndian(header, height);
+    header.push_back(8);
+    header.push_back(hasAlpha ? 6 : 2);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    AppendChunk(png, "IHDR", header);
+    AppendChunk(png, "IDAT", Deflate(filtered));
+    AppendChunk(png, "IEND", std::vector<byte>());
+    return png;
+}
@@ -0,0 +1,65 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+//--------------------------------------------------------------------------------------
+//  Wall clock timer for reporting throughput.
+//--------------------------------------------------------------------------------------
+//
+//  The steady_clock in Visual Studio 2012 and 2013 only ticks every few milliseconds so
+//  QueryPerformanceCounter is used there instead.
+
+class Stopwatch
+{
+private:
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+    LARGE_INTEGER m_start;
+#else
+    std::chrono::steady_clock::time_point m_start;
+#endif
+
+public:
+    Stopwatch() { Restart(); }
+
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+    void Restart() { QueryPerformanceCounter(&m_start); }
+
+    double ElapsedMilliseconds() const
+    {
+        LARGE_INTEGER end, freq;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&freq);
+        return (double(end.QuadPart) - double(m_start.QuadPart)) * 1000.0 / double(freq.QuadPart);
+    }
+#else
+    void Restart() { m_start = std::chrono::steady_clock::now(); }
+
+    double ElapsedMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+#endif
+};
@@ -144,109 +144,20 @@ void FrameProcessorCpuBase::SimplifyIndex(const Gdiplus::BitmapData& srcFrame, G
 //  Edge detection.
 //--------------------------------------------------------------------------------------
 
+//  See PlanarEdgeDetector.
+
 void FrameProcessorCpuBase::ApplyEdgeDetectionSingle(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame, 
                                            const Gdiplus::BitmapData& orgFrame, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight)
 {
-    const UINT bpp = Gdiplus::GetPixelFormatSize(srcFrame.PixelFormat);
-
-    const float alpha = 0.3f;       // Weighting of original frame for edge detection
-    const float beta = 0.8f;        // Weighting of source (color simplied) frame for edge detection
-
-    const float s0 = 0.054f;        // Minimum Threshold of source frame Sobel value to detect an edge
-    const float s1 = 0.064f;        // Maximum Threshold of source frame Sobel value to effect the darkness of the edge
-    const float a0 = 0.3f;          // Minimum Threshold of original frame Sobel value to detect an edge
-    const float a1 = 0.7f;          // Maximum Threshold of original frame Sobel value to effect the darkness of the edge
-
-    for (UINT y = startHeight; y < endHeight; ++y)
-        for (UINT x = startWidth; x < endWidth; ++x)
-        {
-            float Sy, Su, Sv;
-            float Ay, Au, Av;
-
-            CalculateSobel(srcFrame, x, y, Sy, Su, Sv);
-            CalculateSobel(orgFrame, x, y, Ay, Au, Av); 
-
-            float edgeS = (1 - alpha) * Sy + alpha * (Su + Sv) / 2;
-            float edgeA = (1 - alpha) * Ay + alpha * (Au + Av) / 2;
-            float i = (1 - beta) * ImageUtils::SmoothStep(s0, s1, edgeS) + beta * ImageUtils::SmoothStep(a0, a1, edgeA);
-
-            float oneMinusi = 1 - i;
-            COLORREF srcClr = BitmapUtils::GetPixel(static_cast<byte*>(srcFrame.Scan0), x, y, srcFrame.Stride, bpp);
-            COLORREF destClr = RGB(GetRValue(srcClr) * oneMinusi, GetGValue(srcClr) * oneMinusi, GetBValue(srcClr) * oneMinusi);
-            BitmapUtils::SetPixel(static_cast<byte*>(destFrame.Scan0), x, y, destFrame.Stride, bpp, destClr);            
-        }
+    Image32 destImage = ImageViewOf(destFrame);
+    m_edgeDetector.Apply(ImageViewOf(srcFrame), destImage, ImageViewOf(orgFrame), 
+        startWidth, startHeight, endWidth, endHeight, false);
 }
 
 void FrameProcessorCpuBase::ApplyEdgeDetectionMulti(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame, 
                                            const Gdiplus::BitmapData& orgFrame, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight)
 {
-    const UINT bpp = Gdiplus::GetPixelFormatSize(srcFrame.PixelFormat);
-
-    const float alpha = 0.3f;       // Weighting of original frame for edge detection
-    const float beta = 0.8f;        // Weighting of source (color simplied) frame for edge detection
-
-    const float s0 = 0.054f;        // Minimum Threshold of source frame Sobel value to detect an edge
-    const float s1 = 0.064f;        // Maximum Threshold of source frame Sobel value to effect the darkness of the edge
-    const float a0 = 0.3f;          // Minimum Threshold of original frame Sobel value to detect an edge
-    const float a1 = 0.7f;          // Maximum Threshold of original frame Sobel value to effect the darkness of the edge
-
-    parallel_for(startHeight, endHeight,  [&srcFrame, &destFrame, &orgFrame, startWidth, endWidth, alpha, beta, s0, s1, a0, a1, bpp](int y)
-    {
-        for (UINT x = startWidth; x < endWidth; ++x)
-        {
-            float Sy, Su, Sv;
-            float Ay, Au, Av;
-
-            CalculateSobel(srcFrame, x, y, Sy, Su, Sv);
-            CalculateSobel(orgFrame, x, y, Ay, Au, Av); 
-
-            float edgeS = (1 - alpha) * Sy + alpha * (Su + Sv) / 2;
-            float edgeA = (1 - alpha) * Ay + alpha * (Au + Av) / 2;
-            float i = (1 - beta) * ImageUtils::SmoothStep(s0, s1, edgeS) + beta * ImageUtils::SmoothStep(a0, a1, edgeA);
-
-            float oneMinusi = 1 - i;
-            COLORREF srcClr = BitmapUtils::GetPixel(static_cast<byte*>(srcFrame.Scan0), x, y, srcFrame.Stride, bpp);
-            COLORREF destClr = RGB(GetRValue(srcClr) * oneMinusi, GetGValue(srcClr) * oneMinusi, GetBValue(srcClr) * oneMinusi);
-            BitmapUtils::SetPixel(static_cast<byte*>(destFrame.Scan0), x, y, destFrame.Stride, bpp, destClr);
-        }
-    });
-}
-
-void FrameProcessorCpuBase::CalculateSobel(const Gdiplus::BitmapData& srcFrame, int idxX, int idxY, float& dy, float& du, float& dv)
-{
-    const UINT bpp = Gdiplus::GetPixelFormatSize(srcFrame.PixelFormat);
-
-    // Apply the Sobel operator to the image.  The Sobel operation is analogous
-    // to a first derivative of the grayscale part of the image.  Portions of
-    // the image that change rapidly (edges) have higher sobel values.
-
-    // Gx is the matrix used to calculate the horizontal gradient of image
-    // Gy is the matrix used to calculate the vertical gradient of image
-    int gx[3][3] = { { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } };        //  The matrix Gx
-    int gy[3][3] = { {  1, 2, 1 }, {  0, 0, 0 }, { -1, -2, -1 } };      //  The matrix Gy
-
-    float new_yX = 0, new_yY = 0;
-    float new_uX = 0, new_uY = 0;
-    float new_vX = 0, new_vY = 0;
-    for (int y = -1; y <= 1; ++y)
-        for (int x = -1; x <= 1; ++x)
-        {
-            const int gX = gx[x + 1][y + 1];
-            const int gY = gy[x + 1][y + 1];
-            float clrY, clrU, clrV;
-
-            ImageUtils::RGBToYUV(BitmapUtils::GetPixel(static_cast<byte*>(srcFrame.Scan0), idxX + x, idxY + y, srcFrame.Stride, bpp), clrY, clrU, clrV);
-
-            new_yX += gX * clrY;
-            new_yY += gY * clrY;
-            new_uX += gX * clrU;
-            new_uY += gY * clrU;
-            new_vX += gX * clrV;
-            new_vY += gY * clrV;
-        }
-
-    // Calculate the magnitude of the gradient from the horizontal and vertical gradients
-    dy = sqrt((new_yX * new_yX) + (new_yY * new_yY));
-    du = sqrt((new_uX * new_uX) + (new_uY * new_uY));
-    dv = sqrt((new_vX * new_vX) + (new_vY * new_vY));
+    Image32 destImage = ImageViewOf(destFrame);
+    m_edgeDetector.Apply(ImageViewOf(srcFrame), destImage, ImageViewOf(orgFrame), 
+        startWidth, startHeight, endWidth, endHeight, true);
 }
@@ -20,6 +20,8 @@
 #include <array>
 
 #include "IFrameProcessor.h"
+#include "Core/PlanarEdgeDetector.h"
+#include "GdiImageAdapter.h"
 #include "utilities.h"
 
 class FrameProcessorCpuBase
@@ -30,6 +32,7 @@ protected:
     std::array<std::shared_ptr<Gdiplus::BitmapData>, kBufSize> m_frames;
     UINT m_height;
     UINT m_width;
+    PlanarEdgeDetector m_edgeDetector;
 
     void ConfigureFrameBuffers(const Gdiplus::BitmapData& srcFrame);
     void FrameProcessorCpuBase::ReleaseFrameBuffers();
@@ -44,13 +47,11 @@ protected:
 
     static void SimplifyIndex(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame, UINT neighborWindow, int x, int y);
 
-    //  Edge detection.
+    //  Edge detection. Both frames are converted to YUV planes once per call.
 
-    static void ApplyEdgeDetectionSingle(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame,
+    void ApplyEdgeDetectionSingle(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame,
         const Gdiplus::BitmapData& orgFrame, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight);
 
-    static void ApplyEdgeDetectionMulti(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame,
+    void ApplyEdgeDetectionMulti(const Gdiplus::BitmapData& srcFrame, Gdiplus::BitmapData& destFrame,
         const Gdiplus::BitmapData& orgFrame, UINT startWidth, UINT startHeight, UINT endWidth, UINT endHeight);
-
-    static void CalculateSobel(const Gdiplus::BitmapData& srcFrame, int idxX, int idxY, float& dy, float& du, float& dv);
 };
@@ -0,0 +1,61 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include "GdiWrap.h"
+
+#include "Core/ImageProcessorCpuSeparable.h"
+#include "GdiImageAdapter.h"
+#include "IFrameProcessor.h"
+#include "utilities.h"
+
+//--------------------------------------------------------------------------------------
+//  Multi-core CPU frame processor with a separable approximation of the color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  Runs ImageProcessorCpuSeparable on the locked bitmaps. When comparing quality the 
+//  PSNR of each frame relative to the exact simplifier is traced and shown in the 
+//  dialog's performance panel.
+
+class FrameProcessorCpuSeparable : public IFrameProcessor
+{
+private:
+    ImageProcessorCpuSeparable m_processor;
+    bool m_isComparingQuality;
+
+public:
+    FrameProcessorCpuSeparable(bool isComparingQuality = false) : 
+        m_processor(isComparingQuality),
+        m_isComparingQuality(isComparingQuality)
+    {
+    }
+
+    void ProcessImage(const Gdiplus::BitmapData& srcFrame, 
+        Gdiplus::BitmapData& destFrame,
+        UINT phases, UINT neighborWindow)
+    {
+        Image32 destImage = ImageViewOf(destFrame);
+        m_processor.ProcessImage(ImageViewOf(srcFrame), destImage, phases, neighborWindow);
+        if (m_isComparingQuality)
+            ATLTRACE("Separable color simplifier PSNR: %.2f dB\n", m_processor.GetLastPsnr());
+    }
+
+    double GetLastPsnr() const
+    {
+        return m_isComparingQuality ? m_processor.GetLastPsnr() : 0.0;
+    }
+};
@@ -0,0 +1,44 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include "GdiWrap.h"
+
+#include "Core/ImageProcessorCpuSimd.h"
+#include "GdiImageAdapter.h"
+#include "IFrameProcessor.h"
+
+//--------------------------------------------------------------------------------------
+//  Multi-core CPU frame processor with a vectorized color simplifier.
+//--------------------------------------------------------------------------------------
+//
+//  Runs ImageProcessorCpuSimd on the locked bitmaps. See Core/ImageProcessorCpuSimd.h.
+
+class FrameProcessorCpuSimd : public IFrameProcessor
+{
+private:
+    ImageProcessorCpuSimd m_processor;
+
+public:
+    void ProcessImage(const Gdiplus::BitmapData& srcFrame, 
+        Gdiplus::BitmapData& destFrame,
+        UINT phases, UINT neighborWindow)
+    {
+        Image32 destImage = ImageViewOf(destFrame);
+        m_processor.ProcessImage(ImageViewOf(srcFrame), destImage, phases, neighborWindow);
+    }
+};
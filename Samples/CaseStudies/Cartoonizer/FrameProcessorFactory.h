@@ -27,6 +27,9 @@
 #include "FrameProcessorAmpMulti.h"
 #include "FrameProcessorCpuSingle.h"
 #include "FrameProcessorCpuMulti.h"
+#include "FrameProcessorCpuSimd.h"
+#include "FrameProcessorCpuSeparable.h"
+#include "FrameProcessorCpuFused.h"
 
 using namespace concurrency;
 
@@ -60,9 +63,22 @@ enum FrameProcessorType
     kAmpPipeline = 9,
     kAmpSimplePipeline = 9,
     kAmpTiledPipeline,
-    kAmpTexturePipeline
+    kAmpTexturePipeline,
+
+    //  These use the ImageCartoonizerAgent and run optimized cartoonizers on a 
+    //  multi-core CPU.
+
+    kCpuSimd = 12,
+    kCpuSeparable,
+    kCpuSeparableCompare,
+    kCpuFused
 };
 
+inline bool IsPipelineProcessor(FrameProcessorType processorType)
+{
+    return (processorType >= kAmpPipeline) && (processorType <= kAmpTexturePipeline);
+}
+
 //--------------------------------------------------------------------------------------
 //  Factory for creating frame processors.
 //--------------------------------------------------------------------------------------
@@ -112,6 +128,22 @@ public:
             ATLTRACE("CPU multi-core.\n");
             return std::make_shared<FrameProcessorCpuMulti>();
             break;
+        case kCpuSimd:
+            ATLTRACE("CPU multi-core, SIMD.\n");
+            return std::make_shared<FrameProcessorCpuSimd>();
+            break;
+        case kCpuSeparable:
+            ATLTRACE("CPU multi-core, separable simplifier.\n");
+            return std::make_shared<FrameProcessorCpuSeparable>();
+            break;
+        case kCpuSeparableCompare:
+            ATLTRACE("CPU multi-core, separable simplifier compared to exact.\n");
+            return std::make_shared<FrameProcessorCpuSeparable>(true);
+            break;
+        case kCpuFused:
+            ATLTRACE("CPU multi-core, fused tiles.\n");
+            return std::make_shared<FrameProcessorCpuFused>();
+            break;
         default:
             assert(false);
             return nullptr;
@@ -0,0 +1,39 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include "GdiWrap.h"
+#include <stdlib.h>
+
+#include "Core/Image32.h"
+
+//--------------------------------------------------------------------------------------
+//  Wraps locked GDI+ bitmaps as images for the platform neutral processors in Core.
+//--------------------------------------------------------------------------------------
+//
+//  The bitmaps must be PixelFormat32bppARGB, which has the same layout as Image32. The 
+//  views share the bitmap's pixels so nothing is copied.
+
+inline Image32 ImageViewOf(Gdiplus::BitmapData& data)
+{
+    return Image32::View(static_cast<byte*>(data.Scan0), data.Width, data.Height, UINT(abs(data.Stride)));
+}
+
+inline const Image32 ImageViewOf(const Gdiplus::BitmapData& data)
+{
+    return Image32::View(static_cast<byte*>(data.Scan0), data.Width, data.Height, UINT(abs(data.Stride)));
+}
@@ -31,4 +31,8 @@ public:
     virtual void ProcessImage(const Gdiplus::BitmapData& srcFrame, 
         Gdiplus::BitmapData& destFrame, UINT phases, 
         UINT neighborWindow) = 0;
+
+    //  PSNR in dB of the last frame relative to the exact color simplifier, or zero if 
+    //  the processor doesn't measure its quality.
+    virtual double GetLastPsnr() const { return 0.0; }
 };
@@ -16,16 +16,22 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <agents.h>
+#include <ppl.h>
 #include "GdiWrap.h"
 
+#include "BatchStatistics.h"
 #include"ImageInfo.h"
 #include "VideoReader.h"
 #include "VideoFormatConverter.h"
 
 using namespace concurrency;
 //--------------------------------------------------------------------------------------
-//  Image readers for; a single (in memory) frame, a folder of images and a video stream.
+//  Image readers for; a single (in memory) frame, a folder of images, a batch of images 
+//  and a video stream.
 //--------------------------------------------------------------------------------------
 
 class IFrameReader
@@ -101,6 +107,104 @@ private:
     ImageFileFolderReader const & operator=(ImageFileFolderReader const&);
 };
 
+//  Read each image in a folder once, decoding the next few images in parallel while the 
+//  pipeline works on the current one. Images that can't be decoded are counted and skipped,
+//  so the sequence numbers stay consecutive.
+
+class ImageFileBatchReader : public IFrameReader
+{
+private:
+    typedef std::pair<size_t, std::shared_ptr<single_assignment<BitmapPtr>>> DecodeRequest;
+
+    std::vector<std::wstring> m_filePaths;
+    size_t m_nextFile;
+    std::deque<DecodeRequest> m_decoding;
+    std::shared_ptr<BatchStatistics> m_statistics;
+    task_group m_decoders;
+
+public:
+    ImageFileBatchReader(const std::wstring& directoryPath, std::shared_ptr<BatchStatistics> statistics, 
+            int decodeAhead = GetProcessorCount()) :
+        m_nextFile(0),
+        m_statistics(statistics)
+    {
+        m_filePaths = FileUtils::ListFilesInDirectory(directoryPath, L"jpg");
+        std::vector<std::wstring> jpegs = FileUtils::ListFilesInDirectory(directoryPath, L"jpeg");
+        std::copy(jpegs.begin(), jpegs.end(), std::back_inserter(m_filePaths));
+        std::sort(m_filePaths.begin(), m_filePaths.end());
+
+        m_statistics->SetWorkers(kBatchDecode, decodeAhead);
+        for (int i = 0; i < decodeAhead; ++i)
+            ScheduleNextFile();
+    }
+
+    ~ImageFileBatchReader()
+    {
+        m_decoders.cancel();
+        m_decoders.wait();
+    }
+
+    ImageInfoPtr NextFrame(int sequence, const LARGE_INTEGER& clockOffset)
+    {
+        while (!m_decoding.empty())
+        {
+            DecodeRequest request = m_decoding.front();
+            m_decoding.pop_front();
+            BitmapPtr img = receive(*request.second);
+            ScheduleNextFile();
+            if (img == nullptr)
+                continue;
+
+            const std::wstring& filePath = m_filePaths[request.first];
+            ImageInfoPtr pInfo = std::make_shared<ImageInfo>(sequence, FileUtils::GetFilenameFromPath(filePath), img.get(), clockOffset);
+            ATLTRACE("Reading file: %d %S\n", pInfo->GetSequence(), pInfo->GetName().c_str());
+            return pInfo;
+        }
+        return nullptr;
+    }
+
+private:
+    void ScheduleNextFile()
+    {
+        if (m_nextFile == m_filePaths.size())
+            return;
+        DecodeRequest request(m_nextFile++, std::make_shared<single_assignment<BitmapPtr>>());
+        m_decoding.push_back(request);
+
+        const std::wstring filePath = m_filePaths[request.first];
+        std::shared_ptr<single_assignment<BitmapPtr>> result = request.second;
+        std::shared_ptr<BatchStatistics> statistics = m_statistics;
+        m_decoders.run([filePath, result, statistics]()
+        {
+            LARGE_INTEGER start;
+            QueryPerformanceCounter(&start);
+            BitmapPtr img = nullptr;
+            try
+            {
+                img = BitmapUtils::LoadBitmapAndConvert(filePath);
+                statistics->AddStageTime(kBatchDecode, start);
+            }
+            catch (CException* e)
+            {
+                ATLTRACE("Unable to read file: %S\n", filePath.c_str());
+                statistics->AddFailure();
+                e->Delete();
+            }
+            catch (std::exception&)
+            {
+                ATLTRACE("Unable to read file: %S\n", filePath.c_str());
+                statistics->AddFailure();
+            }
+            send(*result, img);
+        });
+    }
+
+private:
+    // Disable copy constructor and assignment.
+    ImageFileBatchReader(const ImageFileBatchReader&);
+    ImageFileBatchReader const & operator=(ImageFileBatchReader const&);
+};
+
 //  Read a sequence of video images, or a single image from a camera.
 
 class VideoStreamReader : public IFrameReader
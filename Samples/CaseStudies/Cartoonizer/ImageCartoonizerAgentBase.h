@@ -78,6 +78,7 @@ protected:
             processor->ProcessImage(originalImage, processedImage,
                                     GetPhases(settings), GetNeighborWindow(settings));
             pInfo->SetBitmap(outBitmap);
+            pInfo->SetPsnr(processor->GetLastPsnr());
 
             //  Unlock the bitmap buffers.
 
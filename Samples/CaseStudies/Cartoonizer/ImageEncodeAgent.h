@@ -0,0 +1,194 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ppl.h>
+
+#include "AgentBase.h"
+#include "BatchStatistics.h"
+#include "Core/ImageIo.h"
+#include "GdiImageAdapter.h"
+#include "PipelineGovernor.h"
+
+using namespace concurrency;
+
+//--------------------------------------------------------------------------------------
+//  Agent for writing cartoonized images to PNG files in batch mode.
+//--------------------------------------------------------------------------------------
+//
+//  The agent copies each image's pixels and passes the image on straight away. The copies
+//  are encoded and written by tasks, so several images are encoded in parallel. At most 
+//  encoderCount images wait to be written at once; after that the agent blocks until one 
+//  is written, holding up the rest of the pipeline. GDI+ bitmaps can't be used on more 
+//  than one thread at a time so the images are encoded with the Core PNG encoder.
+//
+//  A file that can't be written is counted in the statistics and the batch carries on.
+
+class ImageEncodeAgent : public AgentBase
+{
+private:
+    ISource<ImageInfoPtr>& m_imageInput;
+    ITarget<ImageInfoPtr>& m_imageOutput;
+    std::wstring m_outputDirectory;
+    std::shared_ptr<BatchStatistics> m_statistics;
+    PipelineGovernor m_encoderGovernor;
+    task_group m_encoders;
+
+public:
+    ImageEncodeAgent(IImagePipelineDialog* const pDialog, ISource<bool>& cancellationSource, ITarget<ErrorInfo>& errorTarget,
+            ISource<ImageInfoPtr>& imageInput, ITarget<ImageInfoPtr>& imageOutput, 
+            const std::wstring& outputDirectory, std::shared_ptr<BatchStatistics> statistics, int encoderCount) :
+        AgentBase(pDialog, cancellationSource, errorTarget),
+        m_imageInput(imageInput),
+        m_imageOutput(imageOutput),
+        m_outputDirectory(outputDirectory),
+        m_statistics(statistics),
+        m_encoderGovernor(encoderCount)
+    {
+    }
+
+    void run()
+    {
+        ImageInfoPtr pInfo = nullptr;
+        do
+        {
+            pInfo = receive(m_imageInput);
+            EncodeImage(pInfo);
+            asend(m_imageOutput, pInfo);
+        }
+        while (nullptr != pInfo);
+
+        m_encoderGovernor.WaitForEmptyPipeline();
+        m_encoders.wait();
+        ATLTRACE("Encode agent shutting down.\n");
+        done();
+    }
+
+private:
+    void EncodeImage(const ImageInfoPtr& pInfo)
+    {
+#ifdef _DEBUG
+        if (nullptr == pInfo)
+            ATLTRACE("Encode image: empty frame%S.\n", IsCancellationPending() ? L" (skipped)" : L"");
+        else
+            ATLTRACE("Encode image: frame %d%S.\n", pInfo->GetSequence(), IsCancellationPending() ? L" (skipped)" : L"");
+#endif
+        try
+        {
+            if (IsCancellationPending() || (nullptr == pInfo))
+                return;
+
+            //  The earlier stages only time themselves, so their times are recorded here.
+
+            const ImagePerformanceData performance = pInfo->GetPerformanceData();
+            m_statistics->AddStageTime(kBatchResize, performance.GetPhaseDuration(kResize));
+            m_statistics->AddStageTime(kBatchCartoonize, performance.GetPhaseDuration(kCartoonize));
+
+            std::shared_ptr<Image32> pImage = CopyImage(pInfo->GetBitmapPtr());
+            std::wstring filePath = OutputPath(pInfo->GetName());
+
+            m_encoderGovernor.WaitForAvailablePipelineSlot();
+            m_encoders.run([this, pImage, filePath]()
+            {
+                LARGE_INTEGER start;
+                QueryPerformanceCounter(&start);
+                if (WriteImage(*pImage, filePath))
+                    m_statistics->AddStageTime(kBatchEncode, start);
+                else
+                    m_statistics->AddFailure();
+                m_encoderGovernor.FreePipelineSlot();
+            });
+        }
+        catch (CException* e)
+        {
+            ShutdownOnError(kEncode, pInfo, e);
+            e->Delete();
+        }
+        catch (std::exception& e)
+        {
+            ShutdownOnError(kEncode, pInfo, e);
+        }
+    }
+
+    //  Copy the bitmap's pixels. The processors don't all set alpha so the copy is made opaque.
+
+    static std::shared_ptr<Image32> CopyImage(const BitmapPtr& pBitmap)
+    {
+        Gdiplus::Rect rect(0, 0, pBitmap->GetWidth(), pBitmap->GetHeight());
+        Gdiplus::BitmapData bitmapData;
+        Gdiplus::Status st = pBitmap->LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &bitmapData);
+        if (st != Gdiplus::Ok)
+            throw std::runtime_error("Unable to lock bitmap for encoding.");
+
+        std::shared_ptr<Image32> pImage;
+        try
+        {
+            const Image32 view = ImageViewOf(bitmapData);
+            pImage = std::make_shared<Image32>(view);
+        }
+        catch (...)
+        {
+            pBitmap->UnlockBits(&bitmapData);
+            throw;
+        }
+        pBitmap->UnlockBits(&bitmapData);
+
+        for (UINT y = 0; y < pImage->Height(); ++y)
+        {
+            byte* pixels = pImage->Row(y);
+            for (UINT x = 0; x < pImage->Width(); ++x)
+                pixels[4 * x + 3] = 255;
+        }
+        return pImage;
+    }
+
+    std::wstring OutputPath(const std::wstring& imageName) const
+    {
+        std::wstring stem = imageName.substr(0, imageName.find_last_of(L'.'));
+        return std::wstring(m_outputDirectory).append(stem).append(L".png");
+    }
+
+    static bool WriteImage(const Image32& image, const std::wstring& filePath)
+    {
+        try
+        {
+            std::vector<byte> data = ImageIo::EncodePng(image);
+            std::ofstream file(filePath.c_str(), std::ios::binary);
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!file)
+            {
+                ATLTRACE("Unable to write file: %S\n", filePath.c_str());
+                return false;
+            }
+        }
+        catch (std::exception& e)
+        {
+            ATLTRACE("Unable to encode file: %S, %s\n", filePath.c_str(), e.what());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Disable copy constructor and assignment.
+    ImageEncodeAgent(const ImageEncodeAgent&);
+    ImageEncodeAgent const & operator=(ImageEncodeAgent const&);
+};
@@ -30,6 +30,7 @@ enum PipelineStage
     kResize,    
     kCartoonize,
     kDisplay,
+    kEncode,        // Batch mode only. Not included in the performance data for each image.
 };
 
 enum Sequence
@@ -49,12 +50,14 @@ private:
     LARGE_INTEGER m_clockOffset;
     std::vector<LONGLONG> m_phaseStartTick;
     std::vector<LONGLONG> m_phaseEndTick;
+    double m_psnr;
 
 public:
     ImagePerformanceData(int sequenceNumber) :  
         m_sequenceNumber(sequenceNumber), 
         m_phaseStartTick(4, 0),
-        m_phaseEndTick(4, 0)
+        m_phaseEndTick(4, 0),
+        m_psnr(0.0)
     {
     }
 
@@ -82,6 +85,12 @@ public:
     int GetSequence() const { return m_sequenceNumber; }
 
     LONGLONG GetPhaseDuration(int phase) const { return m_phaseEndTick[phase] - m_phaseStartTick[phase]; }
+
+    //  PSNR of the cartoonized image relative to the exact color simplifier, zero if not measured.
+
+    void SetPsnr(double psnr) { m_psnr = psnr; }
+
+    double GetPsnr() const { return m_psnr; }
 };
 
 //--------------------------------------------------------------------------------------
@@ -96,6 +105,8 @@ private:
     LARGE_INTEGER m_currentTime;
     LARGE_INTEGER m_clockFrequency;
     std::vector<LONGLONG> m_totalPhaseTime;
+    double m_minimumPsnr;
+    int m_psnrCount;
     int m_cartoonizerParallelism;
 
 public:
@@ -105,6 +116,8 @@ public:
         m_currentTime(),
         m_clockFrequency(),
         m_totalPhaseTime(4, 0),
+        m_minimumPsnr(0.0),
+        m_psnrCount(0),
         m_cartoonizerParallelism(cartoonizerParallelism)
     {
         m_currentTime.QuadPart = m_startTime.QuadPart = 0;
@@ -124,12 +137,21 @@ public:
 
     inline double GetTimePerImage() const { return (m_imageCount == 0) ? 0 : (1000.0 * GetElapsedTime() / double(m_imageCount)); }
 
+    //  Lowest PSNR of the images whose quality was measured, zero if there were none. An 
+    //  image that matched exactly has an infinite PSNR so an average would not be useful.
+
+    inline bool HasPsnr() const { return (m_psnrCount > 0); }
+
+    inline double GetMinimumPsnr() const { return m_minimumPsnr; }
+
     void Start()
     {
         QueryPerformanceCounter(&m_startTime);
         QueryPerformanceCounter(&m_currentTime);
         m_imageCount = 0;
         std::fill(m_totalPhaseTime.begin(), m_totalPhaseTime.end(), 0);
+        m_minimumPsnr = 0.0;
+        m_psnrCount = 0;
     }
 
     void Update(const ImagePerformanceData& data)
@@ -138,6 +160,11 @@ public:
         m_imageCount++;
         for (int i = 0; i < 4; i++)
             m_totalPhaseTime[i] += data.GetPhaseDuration(i);
+        if (data.GetPsnr() > 0.0)
+        {
+            m_minimumPsnr = (m_psnrCount == 0) ? data.GetPsnr() : std::min(m_minimumPsnr, data.GetPsnr());
+            m_psnrCount++;
+        }
     }
 };
 
@@ -187,6 +214,8 @@ public:
 
     inline ImagePerformanceData GetPerformanceData() const { return m_currentImagePerformance; }
 
+    inline void SetPsnr(double psnr) { m_currentImagePerformance.SetPsnr(psnr); }
+
     void ResizeImage(const RECT& rect);
 
     void PhaseStart(int phase);
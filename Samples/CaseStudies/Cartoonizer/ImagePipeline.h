@@ -24,6 +24,7 @@
 #include "ImageResizeAgent.h"
 #include "CartoonizerFactory.h"
 #include "ImageDisplayAgent.h"
+#include "ImageEncodeAgent.h"
 #include "IFrameProcessor.h"
 #include "IFrameReader.h"
 #include "PipelineGovernor.h"
@@ -40,6 +41,10 @@
 //
 // If one of the stages throws an exception then the AgentBase::ShutdownOnError method will notify the UI and 
 // send a cancel message to shutdown the pipeline.
+//
+// In batch mode, when batchStatistics is set, an ImageEncodeAgent between the cartoonizer and the display
+// writes each image to outputDirectory. Images are cartoonized at their original size. The dialog is 
+// notified when the pipeline has shut down so it can report the statistics.
 
 using namespace concurrency;
 
@@ -53,19 +58,24 @@ private:
     std::shared_ptr<IFrameReader> m_frameReader;
     FrameProcessorType m_processorType;
     PipelineGovernor m_governor;
-    unbounded_buffer<ImageInfoPtr> m_buffer1, m_buffer2, m_buffer3;
+    unbounded_buffer<ImageInfoPtr> m_buffer1, m_buffer2, m_buffer3, m_buffer4;
     std::unique_ptr<ImageResizeAgent> m_imageResizer;
     std::shared_ptr<ImageCartoonizerAgentBase> m_imageCartoonizer;
+    std::unique_ptr<ImageEncodeAgent> m_imageEncoder;
     std::unique_ptr<ImageDisplayAgent> m_imageDisplayer;
+    std::shared_ptr<BatchStatistics> m_batchStatistics;
+    std::wstring m_outputDirectory;
 
 public:
     ImagePipeline(IImagePipelineDialog* const dialog, std::shared_ptr<IFrameReader> reader, 
         FrameProcessorType processorType, int pipelineCapacity,
-        ISource<bool>& cancel, ITarget<ErrorInfo>& errorTarget) :
+        ISource<bool>& cancel, ITarget<ErrorInfo>& errorTarget,
+        std::shared_ptr<BatchStatistics> batchStatistics = nullptr, const std::wstring& outputDirectory = L"") :
         AgentBase(dialog, cancel, errorTarget),
         m_frameReader(reader), m_processorType(processorType),
         m_governor(pipelineCapacity), m_imageResizer(nullptr), m_imageCartoonizer(nullptr), 
-        m_imageDisplayer(nullptr)
+        m_imageEncoder(nullptr), m_imageDisplayer(nullptr), 
+        m_batchStatistics(batchStatistics), m_outputDirectory(outputDirectory)
     {
         Initialize();
     }
@@ -74,13 +84,19 @@ public:
 
     int GetCartoonizerProcessorCount() const
     {
-        return (m_processorType >= kAmpPipeline) ? static_cast<int>(AmpUtils::GetAccelerators().size()) : 1;
+        return IsPipelineProcessor(m_processorType) ? static_cast<int>(AmpUtils::GetAccelerators().size()) : 1;
     }
 
+    bool IsBatch() const { return m_batchStatistics != nullptr; }
+
     void run()
     {
+        if (IsBatch())
+            m_batchStatistics->Start();
         m_imageResizer->start();
         m_imageCartoonizer->start();
+        if (IsBatch())
+            m_imageEncoder->start();
         m_imageDisplayer->start();
         
         LARGE_INTEGER clockOffset;
@@ -125,11 +141,19 @@ public:
 
         //  Wait for all the agents to shut down and then shut down this agent.
 
-        agent* agents[3] = { m_imageResizer.get(), m_imageCartoonizer.get(), m_imageDisplayer.get() };
-        agent::wait_for_all(3, agents);
+        agent* agents[4] = { m_imageResizer.get(), m_imageCartoonizer.get(), m_imageDisplayer.get(), m_imageEncoder.get() };
+        agent::wait_for_all(IsBatch() ? 4 : 3, agents);
         ATLTRACE("Image pipeline agents done.\n");
+
+        //  The dialog may delete the pipeline as soon as it is done, so only use locals after calling done().
+
+        IImagePipelineDialog* const dialog = IsBatch() ? m_dialogWindow : nullptr;
+        if (IsBatch())
+            m_batchStatistics->Stop();
         done();
         ATLTRACE("Image pipeline shutdown complete.\n");
+        if (dialog != nullptr)
+            dialog->NotifyBatchComplete();
     }
 
 private:
@@ -141,11 +165,19 @@ private:
 
         m_imageResizer = 
             std::unique_ptr<ImageResizeAgent>(new ImageResizeAgent(m_dialogWindow, 
-                m_cancellationSource, m_errorTarget, m_buffer1, m_buffer2, aspectRatio));       
+                m_cancellationSource, m_errorTarget, m_buffer1, m_buffer2, aspectRatio, !IsBatch()));       
         m_imageCartoonizer = 
             CartoonizerFactory::Create(m_dialogWindow, m_processorType, 
                 m_cancellationSource, m_errorTarget, m_buffer2, m_buffer3);
+        if (IsBatch())
+        {
+            const int encoderCount = GetProcessorCount();
+            m_imageEncoder = std::unique_ptr<ImageEncodeAgent>(new ImageEncodeAgent(m_dialogWindow, 
+                m_cancellationSource, m_errorTarget, m_buffer3, m_buffer4, m_outputDirectory, m_batchStatistics, encoderCount));
+            m_batchStatistics->SetWorkers(kBatchCartoonize, GetCartoonizerProcessorCount());
+            m_batchStatistics->SetWorkers(kBatchEncode, encoderCount);
+        }
         m_imageDisplayer = std::unique_ptr<ImageDisplayAgent>(new ImageDisplayAgent(
-            m_dialogWindow, m_cancellationSource, m_errorTarget, m_governor, m_buffer3));
+            m_dialogWindow, m_cancellationSource, m_errorTarget, m_governor, IsBatch() ? m_buffer4 : m_buffer3));
     }
 };
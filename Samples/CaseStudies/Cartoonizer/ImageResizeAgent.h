@@ -23,6 +23,8 @@ using namespace concurrency;
 //--------------------------------------------------------------------------------------
 //  Agent for resizing images and correcting aspect ratios.
 //--------------------------------------------------------------------------------------
+//
+//  In batch mode images are cartoonized at their original size so isResizing is false.
 
 class ImageResizeAgent : public AgentBase
 {
@@ -30,14 +32,16 @@ private:
     ISource<ImageInfoPtr>& m_imageInput;
     ITarget<ImageInfoPtr>& m_imageOutput;
     MFRatio m_aspectRatio;
+    bool m_isResizing;
 
 public:
     ImageResizeAgent(IImagePipelineDialog* const pDialog, ISource<bool>& cancellationSource, ITarget<ErrorInfo>& errorTarget,
-            ISource<ImageInfoPtr>& imageInput, ITarget<ImageInfoPtr>& imageOutput, MFRatio aspectRatio) :
+            ISource<ImageInfoPtr>& imageInput, ITarget<ImageInfoPtr>& imageOutput, MFRatio aspectRatio, bool isResizing = true) :
         AgentBase(pDialog, cancellationSource, errorTarget),
         m_imageInput(imageInput),
         m_imageOutput(imageOutput),
-        m_aspectRatio(aspectRatio)
+        m_aspectRatio(aspectRatio),
+        m_isResizing(isResizing)
     {
     }
 
@@ -73,8 +77,11 @@ private:
 
             pInfo->PhaseStart(kResize);
 
-            RECT correctedSize = ImageUtils::CorrectResize(pInfo->GetSize(), size, aspectRatio);
-            pInfo->ResizeImage(correctedSize);
+            if (m_isResizing)
+            {
+                RECT correctedSize = ImageUtils::CorrectResize(pInfo->GetSize(), size, aspectRatio);
+                pInfo->ResizeImage(correctedSize);
+            }
 
             pInfo->PhaseEnd(kResize);
         }
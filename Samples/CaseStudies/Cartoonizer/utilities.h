@@ -262,7 +262,7 @@ public:
         WIN32_FIND_DATAW ffd;
         HANDLE hFind;
 
-        std::wstring dirRoot = GetApplicationDirectory();
+        std::wstring dirRoot = directoryPath;
         std::wstring searchMask = dirRoot;
         searchMask.append(L"*.").append(extn);
         if (searchMask.size() > MAX_PATH)
@@ -281,6 +281,7 @@ public:
             }
         }
         while (FindNextFileW(hFind, &ffd) != 0);
+        FindClose(hFind);
         return filenames;
     }
 };
@@ -0,0 +1,157 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <assert.h>
+
+//--------------------------------------------------------------------------------------
+//  Adaptive partitioner for splitting particles across accelerators.
+//--------------------------------------------------------------------------------------
+//
+//  Divides a number of tiles between partitions so that every tile is assigned to exactly
+//  one partition. Initially the tiles are split evenly, with any remainder given to the first
+//  partitions. After each step the caller reports how long each partition took and the
+//  partitioner moves tiles from slower to faster partitions, so that over the next few steps
+//  the partitions finish at roughly the same time.
+//
+//  All sizes are in whole tiles so every range can be passed directly to a tiled kernel.
+
+class AdaptivePartitioner
+{
+private:
+    std::vector<int> m_tileCounts;
+    int m_totalTiles;
+    bool m_isWarm;
+
+    //  Fraction of the distance to the ideal split covered on each step. Less than one to
+    //  damp oscillation caused by noisy timings.
+    static double Damping() { return 0.5; }
+
+    //  Partitions are considered balanced when the spread of their times is within this
+    //  fraction of the slowest time. No tiles are moved while balanced.
+    static double Tolerance() { return 0.05; }
+
+public:
+    AdaptivePartitioner() : m_totalTiles(0), m_isWarm(false) { }
+
+    //  Set the number of partitions and tiles. Existing proportions are kept if only
+    //  the number of tiles has changed.
+
+    void Resize(int numPartitions, int numTiles)
+    {
+        assert(numPartitions > 0);
+        assert(numTiles >= numPartitions);
+
+        if ((numPartitions == int(m_tileCounts.size())) && (numTiles == m_totalTiles))
+            return;
+
+        std::vector<double> shares(numPartitions, 1.0);
+        if ((numPartitions == int(m_tileCounts.size())) && (m_totalTiles > 0))
+            std::transform(m_tileCounts.cbegin(), m_tileCounts.cend(), shares.begin(),
+                [](int t) { return double(t); });
+
+        m_tileCounts.resize(numPartitions);
+        m_totalTiles = numTiles;
+        m_isWarm = false;
+        Apportion(shares);
+    }
+
+    inline int PartitionCount() const { return int(m_tileCounts.size()); }
+
+    inline int TileCount(int partition) const { return m_tileCounts[partition]; }
+
+    inline int TileStart(int partition) const
+    {
+        return std::accumulate(m_tileCounts.cbegin(), m_tileCounts.cbegin() + partition, 0);
+    }
+
+    //  Update the partition sizes based on the time, in any unit, taken by each partition
+    //  during the last step. The first step after a resize is ignored as it may include the
+    //  one-off cost of JIT compiling kernels.
+
+    void Update(const std::vector<double>& elapsedTimes)
+    {
+        assert(elapsedTimes.size() == m_tileCounts.size());
+
+        if (!m_isWarm)
+        {
+            m_isWarm = true;
+            return;
+        }
+        if (m_tileCounts.size() < 2)
+            return;
+
+        const double slowest = *std::max_element(elapsedTimes.cbegin(), elapsedTimes.cend());
+        const double fastest = *std::min_element(elapsedTimes.cbegin(), elapsedTimes.cend());
+        if ((fastest <= 0.0) || ((slowest - fastest) <= (Tolerance() * slowest)))
+            return;
+
+        //  Each partition's throughput (tiles per unit time) determines its ideal share.
+
+        std::vector<double> rates(m_tileCounts.size());
+        for (size_t i = 0; i < m_tileCounts.size(); ++i)
+            rates[i] = m_tileCounts[i] / elapsedTimes[i];
+        const double totalRate = std::accumulate(rates.cbegin(), rates.cend(), 0.0);
+
+        std::vector<double> shares(m_tileCounts.size());
+        for (size_t i = 0; i < m_tileCounts.size(); ++i)
+        {
+            const double ideal = m_totalTiles * rates[i] / totalRate;
+            shares[i] = m_tileCounts[i] + Damping() * (ideal - m_tileCounts[i]);
+        }
+        Apportion(shares);
+    }
+
+private:
+
+    //  Convert relative shares into whole tile counts that sum to m_totalTiles, giving every
+    //  partition at least one tile. Uses the largest remainder method for rounding.
+
+    void Apportion(const std::vector<double>& shares)
+    {
+        const int numPartitions = int(m_tileCounts.size());
+        const double totalShares = std::accumulate(shares.cbegin(), shares.cend(), 0.0);
+
+        std::vector<std::pair<double, int>> remainders(numPartitions);
+        for (int i = 0; i < numPartitions; ++i)
+        {
+            const double exact = m_totalTiles * shares[i] / totalShares;
+            m_tileCounts[i] = std::max(1, int(exact));
+            remainders[i] = std::make_pair(exact - int(exact), i);
+        }
+        int assigned = std::accumulate(m_tileCounts.cbegin(), m_tileCounts.cend(), 0);
+
+        //  Hand out tiles lost to rounding down, largest remainder first.
+
+        std::stable_sort(remainders.begin(), remainders.end(),
+            [](const std::pair<double, int>& a, const std::pair<double, int>& b) { return a.first > b.first; });
+        for (int i = 0; assigned < m_totalTiles; ++i, ++assigned)
+            m_tileCounts[remainders[i % numPartitions].second]++;
+
+        //  Take back tiles added by enforcing the one tile minimum, from the largest partitions.
+
+        while (assigned > m_totalTiles)
+        {
+            (*std::max_element(m_tileCounts.begin(), m_tileCounts.end()))--;
+            --assigned;
+        }
+        assert(std::accumulate(m_tileCounts.cbegin(), m_tileCounts.cend(), 0) == m_totalTiles);
+    }
+};
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "NBodyAmpTiled.h"
+#include "AdaptivePartitioner.h"
 
 //--------------------------------------------------------------------------------------
 //  Tiled, multi-accelerator integration implementation.
@@ -27,6 +28,10 @@
 //  into the CPU memory (the m_hostPos and m_hostVel vectors). Once all the data is available 
 //  in CPU memory it is copied back to each GPU, which is now ready for the next integration.
 //
+//  Accelerators may not all run at the same speed so the particles are not split evenly. Each 
+//  accelerator's update is timed and the AdaptivePartitioner resizes the ranges, in whole tiles,
+//  over the following integrations until all the accelerators finish at about the same time.
+//
 //  The tile size is passed in as a template parameter allowing the calling code to easily create new 
 //  instances with different tile sizes. See NBodyFactory() in NBodyGravityApp.cpp for examples.
 
@@ -38,6 +43,10 @@ class NBodyAmpMultiTiled : public INBodyAmp
     mutable std::vector<float_3> m_hostPos;
     mutable std::vector<float_3> m_hostVel;
 
+    // Updated after every integration with the time taken on each accelerator.
+    mutable AdaptivePartitioner m_partitioner;
+    mutable std::vector<double> m_elapsedTimes;
+
     NBodyAmpTiled<TSize> m_engine;
 
 public:
@@ -56,7 +65,9 @@ public:
 
         const int tileSize = m_engine.TileSize();
         const int numAccs = int(particleData.size());
-        const int rangeSize = ((numParticles / tileSize) / int(numAccs)) * tileSize;
+        assert((numParticles % tileSize) == 0);
+        m_partitioner.Resize(numAccs, numParticles / tileSize);
+        m_elapsedTimes.resize(numAccs);
         std::vector<completion_future> copyResults(2 * numAccs);
 
         // Update range of particles on each accelerator using the same tiled implementation as NBodyAmpTiled
@@ -64,8 +75,19 @@ public:
 
         parallel_for(0, numAccs, [=, this, &copyResults](int i)
         {
-            const int rangeStart = static_cast<int>(i) * rangeSize;
+            const int rangeStart = m_partitioner.TileStart(i) * tileSize;
+            const int rangeSize = m_partitioner.TileCount(i) * tileSize;
+
+            // Time the update on this accelerator. Waiting for it to complete costs little
+            // as the copies below cannot start until it has finished anyway.
+            LARGE_INTEGER start, end, freq;
+            QueryPerformanceCounter(&start);
             m_engine.TiledBodyBodyInteraction((*particleData[i]->DataOld), (*particleData[i]->DataNew), rangeStart, rangeSize, numParticles);
+            particleData[i]->DataNew->pos.accelerator_view.wait();
+            QueryPerformanceCounter(&end);
+            QueryPerformanceFrequency(&freq);
+            m_elapsedTimes[i] = (double(end.QuadPart) - double(start.QuadPart)) * 1000.0 / double(freq.QuadPart);
+
             array_view<float_3, 1> posSrc = particleData[i]->DataNew->pos.section(rangeStart, rangeSize);
             copyResults[i] = copy_async(posSrc, m_hostPos.begin() + rangeStart); 
             array_view<float_3, 1> velSrc = particleData[i]->DataNew->vel.section(rangeStart, rangeSize);
@@ -73,6 +95,7 @@ public:
         });
 
         parallel_for_each(copyResults.cbegin(), copyResults.cend(), [](const completion_future& f) { f.get(); });
+        m_partitioner.Update(m_elapsedTimes);
 
         // Sync updated particles back onto all accelerators. Even for N=58368 simple copy is faster than
         // only copying updated data to individual accelerator.
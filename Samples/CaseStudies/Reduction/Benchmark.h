@@ -0,0 +1,549 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Benchmark harness shared by the Reduction and ScanPerf drivers, and the 
+// roofline report of the batch cartoonizer. This is the only copy, the other 
+// projects include it from here.
+//
+// Each measurement runs a number of warm-up runs, which also JIT compile any
+// C++ AMP kernels, followed by a number of timed repetitions. Samples further
+// than a configurable number of (scaled) median absolute deviations from the
+// median are rejected as outliers before the statistics are computed. Every
+// reported row is also recorded so the whole run can be written as CSV or 
+// JSON and compared across commits. Where hardware counters are available 
+// the median of each counter over the Calc region (see TimeFunc) is shown
+// alongside the times. Rows that declare the floating point or integer 
+// operations they perform can also be placed on a roofline, see Roofline.h.
+//
+// Command line options, all optional:
+//
+//   --warmup N        Untimed runs before measuring (default 1).
+//   --repetitions N   Timed runs (default 10).
+//   --outliers K      Outlier limit in scaled MADs, 0 keeps all (default 3).
+//   --csv FILE        Write all results as CSV.
+//   --json FILE       Write all results as JSON.
+//   --roofline        Measure the host's ceilings and print a roofline table.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+
+#include "PerfCounters.h"
+
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+//  Wall clock timer. The steady_clock in Visual Studio 2012 and 2013 only ticks 
+//  every few milliseconds so QueryPerformanceCounter is used there instead.
+
+class BenchmarkTimer
+{
+private:
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+    LARGE_INTEGER m_start;
+#else
+    std::chrono::steady_clock::time_point m_start;
+#endif
+
+public:
+    BenchmarkTimer() { Restart(); }
+
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+    void Restart() { QueryPerformanceCounter(&m_start); }
+
+    double ElapsedMilliseconds() const
+    {
+        LARGE_INTEGER end, freq;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&freq);
+        return (double(end.QuadPart) - double(m_start.QuadPart)) * 1000.0 / double(freq.QuadPart);
+    }
+#else
+    void Restart() { m_start = std::chrono::steady_clock::now(); }
+
+    double ElapsedMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+#endif
+};
+
+struct BenchmarkOptions
+{
+    int WarmupRuns;
+    int Repetitions;
+    double OutlierLimit;
+    std::string CsvPath;
+    std::string JsonPath;
+    bool Roofline;
+
+    BenchmarkOptions() : WarmupRuns(1), Repetitions(10), OutlierLimit(3.0), Roofline(false) { }
+
+    //  Unrecognized arguments are ignored. Paths are expected to be ASCII.
+
+    template <typename CharT>
+    void Parse(int argc, CharT* argv[])
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::wstring arg(argv[i], argv[i] + std::char_traits<CharT>::length(argv[i]));
+            if (arg == L"--roofline")
+            {
+                Roofline = true;
+                continue;
+            }
+            if ((i + 1) >= argc)
+                break;
+            const std::basic_string<CharT> value(argv[i + 1]);
+            const std::string narrow(value.begin(), value.end());
+
+            if (arg == L"--warmup")
+                WarmupRuns = (std::max)(0, std::atoi(narrow.c_str()));
+            else if (arg == L"--repetitions")
+                Repetitions = (std::max)(1, std::atoi(narrow.c_str()));
+            else if (arg == L"--outliers")
+                OutlierLimit = (std::max)(0.0, std::atof(narrow.c_str()));
+            else if (arg == L"--csv")
+                CsvPath = narrow;
+            else if (arg == L"--json")
+                JsonPath = narrow;
+            else
+                continue;
+            ++i;
+        }
+    }
+};
+
+struct BenchmarkStatistics
+{
+    int SampleCount;
+    int OutlierCount;
+    double Min;
+    double Median;
+    double Mean;
+    double P95;
+    double StdDev;
+};
+
+//  Statistics of the samples that remain after outlier rejection. The 95th percentile 
+//  uses the nearest rank method.
+
+inline BenchmarkStatistics ComputeStatistics(std::vector<double> samples, double outlierLimit)
+{
+    BenchmarkStatistics stats = { 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (samples.empty())
+        return stats;
+
+    auto median = [](const std::vector<double>& sorted) -> double
+    {
+        const size_t n = sorted.size();
+        return ((n % 2) == 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    };
+
+    std::sort(samples.begin(), samples.end());
+    if (outlierLimit > 0.0)
+    {
+        //  1.4826 scales the MAD to match the standard deviation of normally distributed samples.
+        //  Very stable timings have a tiny MAD so samples within 1% of the median are always kept.
+        const double center = median(samples);
+        std::vector<double> deviations(samples.size());
+        std::transform(samples.cbegin(), samples.cend(), deviations.begin(), 
+            [=](double s) { return std::abs(s - center); });
+        std::sort(deviations.begin(), deviations.end());
+        const double limit = (std::max)(outlierLimit * 1.4826 * median(deviations), 0.01 * center);
+        if (limit > 0.0)
+        {
+            const size_t sampleCount = samples.size();
+            samples.erase(std::remove_if(samples.begin(), samples.end(), 
+                [=](double s) { return std::abs(s - center) > limit; }), samples.end());
+            stats.OutlierCount = int(sampleCount - samples.size());
+        }
+    }
+
+    const size_t n = samples.size();
+    stats.SampleCount = int(n);
+    stats.Min = samples.front();
+    stats.Median = median(samples);
+    stats.Mean = std::accumulate(samples.cbegin(), samples.cend(), 0.0) / n;
+    stats.P95 = samples[size_t(std::ceil(0.95 * n)) - 1];
+    double sumSquares = 0.0;
+    std::for_each(samples.cbegin(), samples.cend(), [&](double s) { sumSquares += (s - stats.Mean) * (s - stats.Mean); });
+    stats.StdDev = (n > 1) ? std::sqrt(sumSquares / (n - 1)) : 0.0;
+    return stats;
+}
+
+//  Times are in milliseconds. Total is measured around the whole function, Compute 
+//  is whatever the function reports as its compute time.
+
+struct BenchmarkResult
+{
+    BenchmarkStatistics Total;
+    BenchmarkStatistics Compute;
+    PerfCounterValues Counters;
+};
+
+//  The kind of operations a row declares, which decides the roofline ceiling it is
+//  compared with. The ceilings are measured on the host, so kernels running on an
+//  accelerator are shown without a bound.
+
+enum BenchmarkOpKind
+{
+    FloatOps,
+    IntegerOps,
+    AcceleratorOps
+};
+
+inline const char* BenchmarkOpKindName(BenchmarkOpKind kind)
+{
+    static const char* names[] = { "float", "integer", "accelerator" };
+    return names[kind];
+}
+
+//  The kind of operations on elements of type T on the host.
+
+template <typename T>
+inline BenchmarkOpKind HostOpKind()
+{
+    return std::is_floating_point<T>::value ? FloatOps : IntegerOps;
+}
+
+//  A reported row. Bytes is the memory traffic and Flops the operations, of the kind 
+//  given by OpKind, of one run. Either may be zero if not declared. Both are 64-bit
+//  so that large runs don't overflow them in a 32-bit build.
+
+struct BenchmarkRecord
+{
+    std::wstring Status;
+    std::wstring Name;
+    BenchmarkResult Result;
+    unsigned long long Bytes;
+    size_t Elements;
+    unsigned long long Flops;
+    BenchmarkOpKind OpKind;
+    std::wstring Note;
+};
+
+class Benchmark
+{
+private:
+    typedef BenchmarkRecord Record;
+
+    BenchmarkOptions m_options;
+    std::function<void ()> m_wait;
+    std::vector<Record> m_records;
+
+public:
+    //  wait is called before and after each run, for example to wait for an accelerator_view.
+
+    Benchmark(const BenchmarkOptions& options = BenchmarkOptions(), 
+        const std::function<void ()>& wait = std::function<void ()>()) : 
+        m_options(options), 
+        m_wait(wait)
+    {
+    }
+
+    const BenchmarkOptions& Options() const { return m_options; }
+
+    const std::vector<BenchmarkRecord>& Records() const { return m_records; }
+
+    //  Measure f, which is called as f(double& computeTime) and sets the compute time 
+    //  in milliseconds. Functions that don't set it report the total time as compute time.
+
+    template <typename Func>
+    BenchmarkResult Measure(Func f)
+    {
+        double computeTime = 0.0;
+        for (int i = 0; i < m_options.WarmupRuns; ++i)
+        {
+            Wait();
+            f(computeTime);
+            Wait();
+        }
+
+        std::vector<double> totalTimes, computeTimes;
+        std::vector<PerfCounterValues> counters;
+        totalTimes.reserve(m_options.Repetitions);
+        computeTimes.reserve(m_options.Repetitions);
+        counters.reserve(m_options.Repetitions);
+        for (int i = 0; i < m_options.Repetitions; ++i)
+        {
+            Wait();
+            computeTime = -1.0;
+            PerfCounters::Instance().Clear();
+            BenchmarkTimer timer;
+            f(computeTime);
+            Wait();
+            const double totalTime = timer.ElapsedMilliseconds();
+            totalTimes.push_back(totalTime);
+            computeTimes.push_back((computeTime < 0.0) ? totalTime : computeTime);
+            counters.push_back(PerfCounters::Instance().Last());
+        }
+
+        BenchmarkResult result;
+        result.Total = ComputeStatistics(totalTimes, m_options.OutlierLimit);
+        result.Compute = ComputeStatistics(computeTimes, m_options.OutlierLimit);
+        result.Counters = MedianCounters(counters);
+        return result;
+    }
+
+    static void PrintHeader()
+    {
+        const PerfCounters& counters = PerfCounters::Instance();
+        if (counters.IsAvailable())
+            std::wcout << std::endl << "Hardware counters for the Calc region, counting " << counters.Scope() << "." << std::endl;
+        std::wcout << std::endl << "                                                           Total : Calc (ms)"
+            << "  StdDev     P95     GB/s  Melem/s" << std::endl << std::endl;
+    }
+
+    //  Print a row in the same layout as the original drivers, using median times, 
+    //  and record it for the CSV and JSON output. Throughput is based on the median 
+    //  compute time and is omitted if bytes or elements is zero. Flops and their kind are
+    //  only recorded, for the roofline table and output files.
+
+    void Report(const std::wstring& status, const std::wstring& name, const BenchmarkResult& result, 
+        unsigned long long bytes, size_t elements, unsigned long long flops = 0, BenchmarkOpKind opKind = FloatOps, 
+        const std::wstring& note = std::wstring())
+    {
+        Record record = { status, name, result, bytes, elements, flops, opKind, note };
+        m_records.push_back(record);
+
+        std::wcout << status << ": " << name;
+        std::wcout.width((std::max)(0, 55 - int(name.length())));
+        std::wcout << std::right << std::fixed << std::setprecision(2) << result.Total.Median << " : " 
+            << result.Compute.Median << " (ms)";
+        std::wcout << std::setw(8) << result.Compute.StdDev << std::setw(8) << result.Compute.P95;
+        std::wcout << std::setw(9);
+        if (bytes > 0)
+            std::wcout << GigabytesPerSecond(result, bytes);
+        else
+            std::wcout << L"-";
+        std::wcout << std::setw(9);
+        if (elements > 0)
+            std::wcout << MegaElementsPerSecond(result, elements);
+        else
+            std::wcout << L"-";
+        if (result.Compute.OutlierCount > 0)
+            std::wcout << L"  (" << result.Compute.OutlierCount << L" outliers)";
+        PrintCounters(result.Counters);
+        if (!note.empty())
+            std::wcout << L"  " << note;
+        std::wcout << std::endl;
+        std::wcout.unsetf(std::ios_base::floatfield);
+    }
+
+    //  Write any output files requested in the options.
+
+    void WriteOutputs() const
+    {
+        if (!m_options.CsvPath.empty())
+            WriteCsv(m_options.CsvPath);
+        if (!m_options.JsonPath.empty())
+            WriteJson(m_options.JsonPath);
+    }
+
+    void WriteCsv(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        file << "status,name,samples,outliers,total_median_ms,compute_min_ms,compute_median_ms,"
+            "compute_mean_ms,compute_p95_ms,compute_stddev_ms,bytes,elements,flops,op_kind,gb_per_s,melem_per_s,gflop_per_s,";
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+            file << PerfCounterName(kind) << ",";
+        file << "note" << std::endl;
+        std::for_each(m_records.cbegin(), m_records.cend(), [&](const Record& r)
+        {
+            const BenchmarkStatistics& c = r.Result.Compute;
+            file << Narrow(r.Status) << ",\"" << EscapeCsv(r.Name) << "\"," << c.SampleCount << "," << c.OutlierCount << "," 
+                << r.Result.Total.Median << "," << c.Min << "," << c.Median << "," << c.Mean << "," << c.P95 << "," << c.StdDev << ","
+                << r.Bytes << "," << r.Elements << "," << r.Flops << "," << BenchmarkOpKindName(r.OpKind) << "," 
+                << GigabytesPerSecond(r.Result, r.Bytes) << "," 
+                << MegaElementsPerSecond(r.Result, r.Elements) << "," << GigaflopsPerSecond(r.Result, r.Flops) << ",";
+            for (int kind = 0; kind < PerfCounterCount; ++kind)
+            {
+                if (r.Result.Counters.IsValid[kind])
+                    file << r.Result.Counters.Values[kind];
+                file << ",";
+            }
+            file << "\"" << EscapeCsv(r.Note) << "\"" << std::endl;
+        });
+    }
+
+    void WriteJson(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        file << "{" << std::endl << "  \"warmup\": " << m_options.WarmupRuns << "," << std::endl
+            << "  \"repetitions\": " << m_options.Repetitions << "," << std::endl
+            << "  \"outlierLimit\": " << m_options.OutlierLimit << "," << std::endl
+            << "  \"results\": [";
+        for (size_t i = 0; i < m_records.size(); ++i)
+        {
+            const Record& r = m_records[i];
+            file << ((i == 0) ? "" : ",") << std::endl << "    { \"status\": \"" << Narrow(r.Status) 
+                << "\", \"name\": \"" << EscapeJson(r.Name) << "\", \"bytes\": " << r.Bytes << ", \"elements\": " << r.Elements
+                << ", \"flops\": " << r.Flops << ", \"opKind\": \"" << BenchmarkOpKindName(r.OpKind) << "\""
+                << ", \"gbPerSecond\": " << GigabytesPerSecond(r.Result, r.Bytes) 
+                << ", \"melemPerSecond\": " << MegaElementsPerSecond(r.Result, r.Elements)
+                << ", \"gflopPerSecond\": " << GigaflopsPerSecond(r.Result, r.Flops)
+                << ", \"total\": " << ToJson(r.Result.Total) << ", \"compute\": " << ToJson(r.Result.Compute) 
+                << ", \"counters\": " << ToJson(r.Result.Counters)
+                << ", \"note\": \"" << EscapeJson(r.Note) << "\" }";
+        }
+        file << std::endl << "  ]" << std::endl << "}" << std::endl;
+    }
+
+    static double GigabytesPerSecond(const BenchmarkResult& result, unsigned long long bytes)
+    {
+        return (result.Compute.Median > 0.0) ? double(bytes) / (result.Compute.Median * 1.0e6) : 0.0;
+    }
+
+    static double MegaElementsPerSecond(const BenchmarkResult& result, size_t elements)
+    {
+        return (result.Compute.Median > 0.0) ? double(elements) / (result.Compute.Median * 1.0e3) : 0.0;
+    }
+
+    static double GigaflopsPerSecond(const BenchmarkResult& result, unsigned long long flops)
+    {
+        return (result.Compute.Median > 0.0) ? double(flops) / (result.Compute.Median * 1.0e6) : 0.0;
+    }
+
+private:
+    void Wait() const
+    {
+        if (m_wait)
+            m_wait();
+    }
+
+    //  Median of each counter over the repetitions. A counter is only valid if it was 
+    //  read in every repetition.
+
+    static PerfCounterValues MedianCounters(const std::vector<PerfCounterValues>& samples)
+    {
+        PerfCounterValues median;
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            std::vector<unsigned long long> values;
+            std::for_each(samples.cbegin(), samples.cend(), [&](const PerfCounterValues& s)
+            {
+                if (s.IsValid[kind])
+                    values.push_back(s.Values[kind]);
+            });
+            if (values.empty() || (values.size() != samples.size()))
+                continue;
+            std::sort(values.begin(), values.end());
+            median.Values[kind] = values[values.size() / 2];
+            median.IsValid[kind] = true;
+        }
+        return median;
+    }
+
+    static void PrintCounters(const PerfCounterValues& counters)
+    {
+        const wchar_t* separator = L"  ";
+        std::wcout << std::setprecision(2);
+        if (counters.IsValid[PerfCycles])
+        {
+            std::wcout << separator << L"cycles " << counters.Values[PerfCycles] / 1.0e6 << L"M";
+            separator = L", ";
+        }
+        if (counters.IsValid[PerfCycles] && counters.IsValid[PerfInstructions] && (counters.Values[PerfCycles] > 0))
+        {
+            std::wcout << separator << L"IPC " << double(counters.Values[PerfInstructions]) / double(counters.Values[PerfCycles]);
+            separator = L", ";
+        }
+        if (counters.IsValid[PerfLlcMisses])
+        {
+            std::wcout << separator << L"LLC misses " << counters.Values[PerfLlcMisses] / 1.0e6 << L"M";
+            separator = L", ";
+        }
+        if (counters.IsValid[PerfBranchMisses])
+            std::wcout << separator << L"branch misses " << counters.Values[PerfBranchMisses] / 1.0e6 << L"M";
+    }
+
+    static std::string Narrow(const std::wstring& s)
+    {
+        std::string narrow(s.size(), '?');
+        std::transform(s.cbegin(), s.cend(), narrow.begin(), [](wchar_t c) { return (c < 128) ? char(c) : '?'; });
+        return narrow;
+    }
+
+    //  CSV fields are quoted so only quotes need escaping, by doubling them.
+
+    static std::string EscapeCsv(const std::wstring& s)
+    {
+        std::string escaped;
+        const std::string narrow = Narrow(s);
+        std::for_each(narrow.cbegin(), narrow.cend(), [&](char c)
+        {
+            if (c == '"')
+                escaped += '"';
+            escaped += c;
+        });
+        return escaped;
+    }
+
+    static std::string EscapeJson(const std::wstring& s)
+    {
+        std::string escaped;
+        const std::string narrow = Narrow(s);
+        std::for_each(narrow.cbegin(), narrow.cend(), [&](char c)
+        {
+            if ((c == '"') || (c == '\\'))
+                escaped += '\\';
+            escaped += c;
+        });
+        return escaped;
+    }
+
+    static std::string ToJson(const PerfCounterValues& counters)
+    {
+        std::ostringstream json;
+        json << "{";
+        const char* separator = " ";
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            if (!counters.IsValid[kind])
+                continue;
+            json << separator << "\"" << PerfCounterName(kind) << "\": " << counters.Values[kind];
+            separator = ", ";
+        }
+        json << " }";
+        return json.str();
+    }
+
+    static std::string ToJson(const BenchmarkStatistics& s)
+    {
+        std::ostringstream json;
+        json << "{ \"samples\": " << s.SampleCount << ", \"outliers\": " << s.OutlierCount << ", \"minMs\": " << s.Min 
+            << ", \"medianMs\": " << s.Median << ", \"meanMs\": " << s.Mean << ", \"p95Ms\": " << s.P95 
+            << ", \"stdDevMs\": " << s.StdDev << " }";
+        return json.str();
+    }
+};
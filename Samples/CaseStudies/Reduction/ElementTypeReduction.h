@@ -0,0 +1,45 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel summation accumulating in the element type. This is the 
+// fastest mode but int sums wrap on overflow and float sums lose precision
+// as the total grows. Used as the baseline for the other summation modes.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include "IAccurateReduce.h"
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+template <typename T, typename TResult>
+class ElementTypeReduction : public IAccurateReduce<T, TResult>
+{
+public:
+    TResult Reduce(accelerator_view& view, const std::vector<T>& source, double& computeTime) const
+    {
+        T total = T(0);
+        computeTime = TimeFunc(view, [&]()
+        {
+            if (!source.empty())
+                total = ParallelSimdReduce(source.data(), source.data() + source.size(), SumOp<T>());
+        });
+        return TResult(total);
+    }
+};
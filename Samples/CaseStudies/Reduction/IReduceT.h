@@ -0,0 +1,32 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Interface implemented by reductions over any element type and associative
+// operator. See ReduceOperators.h for the requirements on Op.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+template <typename T, typename Op>
+class IReduceT
+{
+public:
+    virtual T Reduce(accelerator_view& view, 
+        const std::vector<T>& source, double& computeTime) const = 0;
+};
@@ -0,0 +1,94 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel Kahan (compensated) summation. Each SIMD lane keeps a running
+// compensation term holding the low order bits lost from its sum, so the
+// error is nearly independent of the number of elements. The lanes and the
+// chunk results are combined with compensated additions too.
+//
+// This relies on the compiler keeping the order of floating point operations.
+// Do not compile with /fp:fast, which may optimize the compensation away.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <emmintrin.h>
+
+#include "IAccurateReduce.h"
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+namespace details
+{
+    //  A running sum and its compensation, the negated error of the sum.
+    typedef std::pair<float, float> KahanAccumulator;
+
+    inline KahanAccumulator KahanAdd(const KahanAccumulator& acc, float value)
+    {
+        const float y = value - acc.second;
+        const float t = acc.first + y;
+        return KahanAccumulator(t, (t - acc.first) - y);
+    }
+
+    inline KahanAccumulator KahanCombine(const KahanAccumulator& a, const KahanAccumulator& b)
+    {
+        return KahanAdd(KahanAdd(a, b.first), -b.second);
+    }
+
+    inline KahanAccumulator KahanSum(const float* first, const float* last)
+    {
+        __m128 sum = _mm_setzero_ps();
+        __m128 comp = _mm_setzero_ps();
+
+        const float* p = first;
+        for (; (last - p) >= 4; p += 4)
+        {
+            const __m128 y = _mm_sub_ps(_mm_loadu_ps(p), comp);
+            const __m128 t = _mm_add_ps(sum, y);
+            comp = _mm_sub_ps(_mm_sub_ps(t, sum), y);
+            sum = t;
+        }
+
+        float sums[4], comps[4];
+        _mm_storeu_ps(sums, sum);
+        _mm_storeu_ps(comps, comp);
+        KahanAccumulator result(0.0f, 0.0f);
+        for (int i = 0; i < 4; ++i)
+            result = KahanCombine(result, KahanAccumulator(sums[i], comps[i]));
+        for (; p < last; ++p)
+            result = KahanAdd(result, *p);
+        return result;
+    }
+}
+
+class KahanReduction : public IAccurateReduce<float, float>
+{
+public:
+    float Reduce(accelerator_view& view, const std::vector<float>& source, double& computeTime) const
+    {
+        details::KahanAccumulator total(0.0f, 0.0f);
+        computeTime = TimeFunc(view, [&]()
+        {
+            if (!source.empty())
+                total = ParallelReduceChunks(source.data(), source.data() + source.size(), total, 
+                    details::KahanSum, details::KahanCombine);
+        });
+        return total.first - total.second;
+    }
+};
@@ -0,0 +1,293 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel implementation for machines with several NUMA nodes.
+//
+// This is the cascading approach again, with one level per NUMA node. The
+// input is split between nodes in proportion to their processor counts and
+// each slice is copied into memory allocated on its own node. Worker threads
+// pinned to each node do the copy, so pages are first touched locally, and
+// then reduce only their node's data. The per-worker results are combined 
+// within each node and finally across nodes. No thread ever reads memory 
+// on another node during the reduction.
+//
+// The source is copied on every call, so changes made to it in place are 
+// always seen. The copy is timed separately, see LastCopyTime, and 
+// computeTime excludes it. The node buffers are kept while the size of the 
+// source stays the same.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <windows.h>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "IReduce.h"
+#include "SimdReduce.h"
+#include "Timer.h"
+
+class NumaReduction : public IReduce
+{
+private:
+    struct Node
+    {
+        USHORT Number;
+        GROUP_AFFINITY Affinity;
+        int ProcessorCount;
+        size_t SourceOffset;
+        size_t ElementCount;
+        int* Data;
+    };
+
+    //  Each worker's range is relative to its node's data.
+    struct Worker
+    {
+        int Node;
+        size_t First;
+        size_t Last;
+        int Partial;
+    };
+
+    mutable std::vector<Node> m_nodes;
+    mutable std::vector<Worker> m_workers;
+    std::vector<std::thread> m_threads;
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_startWork;
+    mutable std::condition_variable m_workDone;
+    mutable std::function<void (Worker&)> m_work;
+    mutable unsigned m_generation;
+    mutable int m_remaining;
+    bool m_isStopping;
+
+    mutable size_t m_elementCount;
+    mutable double m_copyTime;
+
+    NumaReduction(const NumaReduction&);
+    NumaReduction& operator=(const NumaReduction&);
+
+public:
+    //  Use at most maxNodes nodes, in node number order. Nodes without processors are skipped.
+
+    explicit NumaReduction(int maxNodes = INT_MAX) : 
+        m_generation(0),
+        m_remaining(0),
+        m_isStopping(false),
+        m_elementCount(0),
+        m_copyTime(0.0)
+    {
+        m_nodes = AvailableNodes();
+        if (int(m_nodes.size()) > maxNodes)
+            m_nodes.resize(maxNodes);
+
+        for (int n = 0; n < int(m_nodes.size()); ++n)
+        {
+            for (int p = 0; p < m_nodes[n].ProcessorCount; ++p)
+            {
+                Worker worker = { n, 0, 0, 0 };
+                m_workers.push_back(worker);
+            }
+        }
+
+        //  Threads already started must be joined if starting another one fails. Reserving 
+        //  first means push_back can't throw once a thread is running.
+        m_threads.reserve(m_workers.size());
+        try
+        {
+            for (int i = 0; i < int(m_workers.size()); ++i)
+                m_threads.push_back(std::thread([this, i]() { WorkerLoop(i); }));
+        }
+        catch (...)
+        {
+            StopWorkers();
+            throw;
+        }
+    }
+
+    ~NumaReduction()
+    {
+        StopWorkers();
+        FreeNodeData();
+    }
+
+    static int AvailableNodeCount() { return int(AvailableNodes().size()); }
+
+    int NodeCount() const { return int(m_nodes.size()); }
+
+    int ProcessorCount() const { return int(m_workers.size()); }
+
+    //  Time taken by the last call to Reduce to copy the source onto the nodes.
+
+    double LastCopyTime() const { return m_copyTime; }
+
+    int Reduce(accelerator_view& view, const std::vector<int>& source, double& computeTime) const
+    {
+        if (source.size() != m_elementCount)
+            Distribute(source.size());
+        const int* sourceData = source.data();
+        m_copyTime = TimeFunc(view, [&]()
+        {
+            RunOnWorkers([this, sourceData](Worker& w)
+            {
+                const Node& node = m_nodes[w.Node];
+                std::copy(sourceData + node.SourceOffset + w.First, sourceData + node.SourceOffset + w.Last, node.Data + w.First);
+            });
+        });
+
+        int total = 0;
+        computeTime = TimeFunc(view, [&]()
+        {
+            RunOnWorkers([this](Worker& w)
+            {
+                const int* data = m_nodes[w.Node].Data;
+                w.Partial = SimdReduce(data + w.First, data + w.Last, SumOp<int>());
+            });
+
+            //  Combine within each node and then across nodes.
+            for (size_t n = 0, i = 0; n < m_nodes.size(); ++n)
+            {
+                int nodeTotal = 0;
+                for (; (i < m_workers.size()) && (m_workers[i].Node == int(n)); ++i)
+                    nodeTotal += m_workers[i].Partial;
+                total += nodeTotal;
+            }
+        });
+        return total;
+    }
+
+private:
+    static std::vector<Node> AvailableNodes()
+    {
+        std::vector<Node> nodes;
+        ULONG highestNode = 0;
+        if (!GetNumaHighestNodeNumber(&highestNode))
+            highestNode = 0;
+
+        for (USHORT n = 0; n <= highestNode; ++n)
+        {
+            Node node = { n };
+            if (!GetNumaNodeProcessorMaskEx(n, &node.Affinity))
+                continue;
+            for (KAFFINITY mask = node.Affinity.Mask; mask != 0; mask &= mask - 1)
+                ++node.ProcessorCount;
+            if (node.ProcessorCount > 0)
+                nodes.push_back(node);
+        }
+        return nodes;
+    }
+
+    //  Split elementCount elements between nodes in proportion to their processor counts 
+    //  and between the workers on each node evenly, and allocate each node's buffer. 
+    //  Each worker copies its own range.
+
+    void Distribute(size_t elementCount) const
+    {
+        FreeNodeData();
+
+        const size_t processorCount = m_workers.size();
+        size_t processorsBefore = 0;
+        for (auto& node : m_nodes)
+        {
+            node.SourceOffset = (elementCount * processorsBefore) / processorCount;
+            processorsBefore += node.ProcessorCount;
+            node.ElementCount = (elementCount * processorsBefore) / processorCount - node.SourceOffset;
+
+            node.Data = static_cast<int*>(VirtualAllocExNuma(GetCurrentProcess(), nullptr, 
+                (std::max)(node.ElementCount, size_t(1)) * sizeof(int), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node.Number));
+            if (node.Data == nullptr)
+                throw std::bad_alloc();
+        }
+
+        for (size_t i = 0; i < m_workers.size(); )
+        {
+            const int n = m_workers[i].Node;
+            const size_t workerCount = m_nodes[n].ProcessorCount;
+            for (size_t w = 0; w < workerCount; ++w, ++i)
+            {
+                m_workers[i].First = (m_nodes[n].ElementCount * w) / workerCount;
+                m_workers[i].Last = (m_nodes[n].ElementCount * (w + 1)) / workerCount;
+            }
+        }
+        m_elementCount = elementCount;
+    }
+
+    void FreeNodeData() const
+    {
+        for (auto& node : m_nodes)
+        {
+            if (node.Data != nullptr)
+                VirtualFree(node.Data, 0, MEM_RELEASE);
+            node.Data = nullptr;
+        }
+        m_elementCount = 0;
+    }
+
+    void StopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_startWork.notify_all();
+        for (auto& t : m_threads)
+            t.join();
+        m_threads.clear();
+    }
+
+    //  Run work on every worker thread and wait for all of them to finish.
+
+    void RunOnWorkers(const std::function<void (Worker&)>& work) const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work = work;
+        m_remaining = int(m_workers.size());
+        ++m_generation;
+        m_startWork.notify_all();
+        m_workDone.wait(lock, [this]() { return m_remaining == 0; });
+    }
+
+    void WorkerLoop(int index)
+    {
+        GROUP_AFFINITY affinity = m_nodes[m_workers[index].Node].Affinity;
+        SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+
+        unsigned generation = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_startWork.wait(lock, [&]() { return m_isStopping || (m_generation != generation); });
+                if (m_isStopping)
+                    return;
+                generation = m_generation;
+            }
+
+            m_work(m_workers[index]);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_remaining == 0)
+                m_workDone.notify_one();
+        }
+    }
+};
@@ -0,0 +1,90 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel pairwise (cascade) summation. The range is split in half 
+// recursively and the halves are summed separately, so the rounding error 
+// grows with log(n) rather than n. Blocks below a small size are summed 
+// directly with four accumulators, which keeps most of the speed of the 
+// naive loop.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include "IAccurateReduce.h"
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+namespace details
+{
+    template <typename T>
+    T PairwiseSum(const T* first, const T* last)
+    {
+        const ptrdiff_t blockSize = 128;
+        const ptrdiff_t count = last - first;
+        if (count > blockSize)
+        {
+            const T* middle = first + count / 2;
+            return PairwiseSum(first, middle) + PairwiseSum(middle, last);
+        }
+
+        T acc0 = T(0), acc1 = T(0), acc2 = T(0), acc3 = T(0);
+        const T* p = first;
+        for (; (last - p) >= 4; p += 4)
+        {
+            acc0 += p[0];
+            acc1 += p[1];
+            acc2 += p[2];
+            acc3 += p[3];
+        }
+        T result = (acc0 + acc1) + (acc2 + acc3);
+        for (; p < last; ++p)
+            result += *p;
+        return result;
+    }
+}
+
+template <typename T>
+class PairwiseReduction : public IAccurateReduce<T, T>
+{
+public:
+    T Reduce(accelerator_view& view, const std::vector<T>& source, double& computeTime) const
+    {
+        T total = T(0);
+        computeTime = TimeFunc(view, [&]()
+        {
+            if (source.empty())
+                return;
+
+            //  Sum each chunk pairwise and then the chunk results pairwise, so the whole 
+            //  sum is still a balanced tree.
+            const T* first = source.data();
+            const T* last = first + source.size();
+            const int chunkCount = ParallelChunkCount(last - first);
+
+            std::vector<T> partials(chunkCount);
+            parallel_for(0, chunkCount, [=, &partials](int i)
+            {
+                partials[i] = details::PairwiseSum(first + ((last - first) * i) / chunkCount, 
+                    first + ((last - first) * (i + 1)) / chunkCount);
+            });
+            total = details::PairwiseSum(partials.data(), partials.data() + partials.size());
+        });
+        return total;
+    }
+};
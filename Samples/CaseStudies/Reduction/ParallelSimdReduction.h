@@ -0,0 +1,95 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel implementation for any element type and associative operator.
+// The input is split into a few chunks per core, each chunk is reduced with
+// SimdReduce and the partial results are combined in order on one thread.
+// ParallelReduceChunks is also used by the other CPU reductions that need
+// the same chunking with a different per chunk reduction.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <ppl.h>
+
+#include "IReduceT.h"
+#include "SimdReduce.h"
+#include "Timer.h"
+
+using namespace concurrency;
+
+//  Number of chunks to split elementCount elements into. Several chunks per core lets 
+//  the scheduler balance uneven progress. Small inputs use fewer chunks so each chunk 
+//  is still worth a task.
+
+inline int ParallelChunkCount(ptrdiff_t elementCount)
+{
+    const ptrdiff_t minChunkSize = 16 * 1024;
+    return int(std::max<ptrdiff_t>(1, std::min<ptrdiff_t>(
+        4 * GetProcessorCount(), elementCount / minChunkSize)));
+}
+
+//  Reduce each chunk of [first, last) with reduceChunk, in parallel, and then combine 
+//  the chunk results in order.
+
+template <typename T, typename TResult, typename ChunkFunc, typename CombineFunc>
+TResult ParallelReduceChunks(const T* first, const T* last, TResult identity, 
+    const ChunkFunc& reduceChunk, const CombineFunc& combine)
+{
+    const ptrdiff_t elementCount = last - first;
+    const int chunkCount = ParallelChunkCount(elementCount);
+
+    std::vector<TResult> partials(chunkCount, identity);
+    parallel_for(0, chunkCount, [=, &partials](int i)
+    {
+        const T* chunkFirst = first + (elementCount * i) / chunkCount;
+        const T* chunkLast = first + (elementCount * (i + 1)) / chunkCount;
+        partials[i] = reduceChunk(chunkFirst, chunkLast);
+    });
+    return std::accumulate(partials.cbegin(), partials.cend(), identity, combine);
+}
+
+template <typename T, typename Op>
+T ParallelSimdReduce(const T* first, const T* last, const Op& op)
+{
+    return ParallelReduceChunks(first, last, op.Identity(), 
+        [=](const T* chunkFirst, const T* chunkLast) { return SimdReduce(chunkFirst, chunkLast, op); }, op);
+}
+
+template <typename T, typename Op>
+class ParallelSimdReduction : public IReduceT<T, Op>
+{
+private:
+    Op m_op;
+
+public:
+    ParallelSimdReduction(const Op& op = Op()) : m_op(op) { }
+
+    T Reduce(accelerator_view& view, const std::vector<T>& source, double& computeTime) const
+    {
+        T result = m_op.Identity();
+        computeTime = TimeFunc(view, [&]()
+        {
+            if (!source.empty())
+                result = ParallelSimdReduce(source.data(), source.data() + source.size(), m_op);
+        });
+        return result;
+    }
+};
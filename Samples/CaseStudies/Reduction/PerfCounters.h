@@ -0,0 +1,283 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Hardware performance counters around each timed region. Used by TimeFunc
+// in Timer.h and reported by the benchmark harness. Like Benchmark.h, the
+// other projects include this copy.
+//
+// On Windows only cycles are available without a kernel driver. They are 
+// read with QueryProcessCycleTime, which covers every thread in the process
+// including the PPL and C++ AMP runtime threads. The cycles are counted at 
+// the processor's constant reference rate, not the current clock speed.
+//
+// On Linux the counters are read with perf_event_open, counting user mode
+// only so no privileges are needed beyond perf_event_paranoid <= 2. If 
+// allowed (perf_event_paranoid <= 0) every CPU is counted system-wide, which
+// covers all the worker threads but also every other process running at the
+// time, so the machine should otherwise be idle. Otherwise only the calling
+// thread is counted, which is still useful for sequential kernels. Counters the CPU or hypervisor doesn't 
+// support are skipped. When there are more counters than the PMU has 
+// registers the kernel multiplexes them, and each value is scaled up by the 
+// fraction of the region it was actually counting.
+//
+// On other platforms no counters are available and everything here does 
+// nothing.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+enum PerfCounterKind
+{
+    PerfCycles,
+    PerfInstructions,
+    PerfLlcMisses,
+    PerfBranchMisses,
+    PerfCounterCount
+};
+
+struct PerfCounterValues
+{
+    bool IsValid[PerfCounterCount];
+    unsigned long long Values[PerfCounterCount];
+
+    PerfCounterValues()
+    {
+        for (int i = 0; i < PerfCounterCount; ++i)
+        {
+            IsValid[i] = false;
+            Values[i] = 0;
+        }
+    }
+
+    bool Any() const
+    {
+        for (int i = 0; i < PerfCounterCount; ++i)
+        {
+            if (IsValid[i])
+                return true;
+        }
+        return false;
+    }
+};
+
+inline const char* PerfCounterName(int kind)
+{
+    static const char* names[PerfCounterCount] = { "cycles", "instructions", "llc_misses", "branch_misses" };
+    return names[kind];
+}
+
+class PerfCounters
+{
+private:
+    const char* m_scope;
+    PerfCounterValues m_last;
+
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+#if defined(_WIN32)
+    unsigned long long m_startCycles;
+
+    static unsigned long long ProcessCycles()
+    {
+        ULONG64 cycles = 0;
+        QueryProcessCycleTime(GetCurrentProcess(), &cycles);
+        return cycles;
+    }
+
+    PerfCounters() : m_scope("all threads of this process, cycles only"), m_startCycles(0) { }
+
+public:
+    void Start() { m_startCycles = ProcessCycles(); }
+
+    void Stop()
+    {
+        const unsigned long long cycles = ProcessCycles() - m_startCycles;
+        m_last = PerfCounterValues();
+        m_last.Values[PerfCycles] = cycles;
+        m_last.IsValid[PerfCycles] = true;
+    }
+
+    bool IsAvailable() const { return true; }
+#elif defined(__linux__)
+    std::vector<int> m_fds[PerfCounterCount];
+
+    //  The layout read from each counter with PERF_FORMAT_TOTAL_TIME_ENABLED and _RUNNING.
+    struct ReadFormat
+    {
+        unsigned long long Value;
+        unsigned long long TimeEnabled;
+        unsigned long long TimeRunning;
+    };
+
+    //  Estimate the count over the whole region from the part of it the counter ran for.
+    static unsigned long long Scale(const ReadFormat& data)
+    {
+        if (data.TimeRunning >= data.TimeEnabled)
+            return data.Value;
+        return (unsigned long long)(double(data.Value) * double(data.TimeEnabled) / double(data.TimeRunning) + 0.5);
+    }
+
+    static int Open(int kind, int pid, int cpu)
+    {
+        static const unsigned long long configs[PerfCounterCount] = { PERF_COUNT_HW_CPU_CYCLES, 
+            PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[kind];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(__NR_perf_event_open, &attr, pid, cpu, -1, 0));
+    }
+
+    //  Open every counter on every CPU, or fail without leaving any open.
+    bool OpenAllCpus()
+    {
+        const int cpuCount = int(sysconf(_SC_NPROCESSORS_ONLN));
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            for (int cpu = 0; cpu < cpuCount; ++cpu)
+            {
+                const int fd = Open(kind, -1, cpu);
+                if (fd < 0)
+                {
+                    CloseAll();
+                    return false;
+                }
+                m_fds[kind].push_back(fd);
+            }
+        }
+        return true;
+    }
+
+    void OpenThisThread()
+    {
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            const int fd = Open(kind, 0, -1);
+            if (fd >= 0)
+                m_fds[kind].push_back(fd);
+        }
+    }
+
+    void CloseAll()
+    {
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            for (size_t i = 0; i < m_fds[kind].size(); ++i)
+                close(m_fds[kind][i]);
+            m_fds[kind].clear();
+        }
+    }
+
+    void ControlAll(unsigned long request)
+    {
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            for (size_t i = 0; i < m_fds[kind].size(); ++i)
+                ioctl(m_fds[kind][i], request, 0);
+        }
+    }
+
+    PerfCounters() : m_scope("unavailable")
+    {
+        if (OpenAllCpus())
+        {
+            m_scope = "system-wide, all processes";
+            return;
+        }
+        OpenThisThread();
+        if (IsAvailable())
+            m_scope = "calling thread only";
+    }
+
+public:
+    ~PerfCounters() { CloseAll(); }
+
+    void Start()
+    {
+        ControlAll(PERF_EVENT_IOC_RESET);
+        ControlAll(PERF_EVENT_IOC_ENABLE);
+    }
+
+    void Stop()
+    {
+        ControlAll(PERF_EVENT_IOC_DISABLE);
+        m_last = PerfCounterValues();
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            for (size_t i = 0; i < m_fds[kind].size(); ++i)
+            {
+                ReadFormat data;
+                if ((read(m_fds[kind][i], &data, sizeof(data)) != sizeof(data)) || (data.TimeRunning == 0))
+                    continue;
+                m_last.Values[kind] += Scale(data);
+                m_last.IsValid[kind] = true;
+            }
+        }
+    }
+
+    bool IsAvailable() const
+    {
+        for (int kind = 0; kind < PerfCounterCount; ++kind)
+        {
+            if (!m_fds[kind].empty())
+                return true;
+        }
+        return false;
+    }
+#else
+    PerfCounters() : m_scope("unavailable") { }
+
+public:
+    void Start() { }
+    void Stop() { }
+
+    bool IsAvailable() const { return false; }
+#endif
+
+    //  Counters are opened once, on first use, and shared by all timed regions.
+    static PerfCounters& Instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    const char* Scope() const { return m_scope; }
+
+    //  Values from the most recent Start and Stop, or no valid values after Clear.
+    const PerfCounterValues& Last() const { return m_last; }
+
+    void Clear() { m_last = PerfCounterValues(); }
+};
@@ -0,0 +1,82 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Associative operators used by the generic reductions.
+//
+// An operator is any type providing T Identity() const and
+// T operator()(const T&, const T&) const. User defined functors only need
+// to be associative. The SIMD implementations also rely on the built in
+// operators below being commutative.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+template <typename T>
+struct SumOp
+{
+    T Identity() const { return T(0); }
+    T operator()(const T& a, const T& b) const { return a + b; }
+};
+
+template <typename T>
+struct MinOp
+{
+    T Identity() const
+    {
+        return std::numeric_limits<T>::has_infinity ?
+            std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::max)();
+    }
+    T operator()(const T& a, const T& b) const { return (a < b) ? a : b; }
+};
+
+template <typename T>
+struct MaxOp
+{
+    T Identity() const
+    {
+        return std::numeric_limits<T>::has_infinity ?
+            -std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::min)();
+    }
+    T operator()(const T& a, const T& b) const { return (a > b) ? a : b; }
+};
+
+template <typename T>
+struct BitAndOp
+{
+    static_assert(std::is_integral<T>::value, "Bitwise operators require an integral type.");
+    T Identity() const { return ~T(0); }
+    T operator()(const T& a, const T& b) const { return a & b; }
+};
+
+template <typename T>
+struct BitOrOp
+{
+    static_assert(std::is_integral<T>::value, "Bitwise operators require an integral type.");
+    T Identity() const { return T(0); }
+    T operator()(const T& a, const T& b) const { return a | b; }
+};
+
+template <typename T>
+struct BitXorOp
+{
+    static_assert(std::is_integral<T>::value, "Bitwise operators require an integral type.");
+    T Identity() const { return T(0); }
+    T operator()(const T& a, const T& b) const { return a ^ b; }
+};
@@ -23,13 +23,22 @@
 #include <iomanip>
 #include <numeric> 
 #include <algorithm>
+#include <type_traits>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <sstream>
 #include <assert.h>
 
 #include "Timer.h"
+#include "Benchmark.h"
+#include "Roofline.h"
 #include "IReduce.h"
 #include "DummyReduction.h"
 #include "SequentialReduction.h"
 #include "ParallelReduction.h"
+#include "VectorizedReduction.h"
 #include "SimpleReduction.h"
 #include "SimpleArrayViewReduction.h"
 #include "SimpleOptimizedReduction.h"
@@ -41,6 +50,16 @@
 #include "TiledMinimizedDivergenceConflictsAndStallingUnrolledReduction.h"
 #include "CascadingReduction.h"
 #include "CascadingUnrolledReduction.h"
+#include "ReduceOperators.h"
+#include "ParallelSimdReduction.h"
+#include "ElementTypeReduction.h"
+#include "WideningReduction.h"
+#include "PairwiseReduction.h"
+#include "KahanReduction.h"
+#include "StreamingReduction.h"
+#include "SegmentedReduction.h"
+#include "TransformReduce.h"
+#include "NumaReduction.h"
 
 #ifdef MARKERS
 #include <cvmarkersobj.h>
@@ -53,15 +72,34 @@ using namespace concurrency;
 marker_series g_markerSeries(L"Reducer Application");
 #endif
 
+//  Configured from the command line in main and used to time every reduction.
+Benchmark g_benchmark;
+
 typedef std::pair<std::shared_ptr<IReduce>, std::wstring> ReducerDescription;
 
 inline bool validateSizes(unsigned tileSize, unsigned elementCount);
 
-void main()
+template <typename T>
+void RunGenericReductions(accelerator_view& view, const std::wstring& typeName, size_t elementCount);
+
+void RunAccurateReductions(accelerator_view& view, size_t elementCount);
+
+void RunStreamingReductions(accelerator_view& view, const std::vector<int>& source, int expectedResult);
+
+void RunSegmentedReductions(accelerator_view& view, const std::vector<int>& source);
+
+void RunFusedReductions(accelerator_view& view, size_t elementCount);
+
+void RunNumaReductions(accelerator_view& view, const std::vector<int>& source, int expectedResult);
+
+void main(int argc, char* argv[])
 {
     //  Uncomment this to use the WARP accelerator even if a GPU is present.
     //accelerator::set_default(accelerator::direct3d_warp);
 
+    BenchmarkOptions options;
+    options.Parse(argc, argv);
+
     const size_t elementCount = 16 * 1024 * 1024; 
     const int tileSize = 512;
     const int tileCount = 128;                     // Used in cascading reductions
@@ -79,6 +117,7 @@ void main()
         << elementCount * sizeof(int) / 1024 << " KB of data ..."  << std::endl;    
     std::wcout << "Tile size:     " << tileSize << std::endl;
     std::wcout << "Tile count:    " << tileCount << std::endl;
+    std::wcout << "Warm-up runs:  " << options.WarmupRuns << ", repetitions: " << options.Repetitions << std::endl;
 
     if (!validateSizes(tileSize, elementCount))
         std::wcout << "Tile size is not factor of element count. This will cause runtime errors." 
@@ -100,10 +139,11 @@ void main()
     const int expectedResult = int((elementCount / 16) * ((15 * 16) / 2));
 
     std::vector<ReducerDescription> reducers;
-    reducers.reserve(14);
+    reducers.reserve(15);
     reducers.push_back(ReducerDescription(std::make_shared<DummyReduction>(),                                                           L"Overhead"));
     reducers.push_back(ReducerDescription(std::make_shared<SequentialReduction>(),                                                      L"CPU sequential"));
     reducers.push_back(ReducerDescription(std::make_shared<ParallelReduction>(),                                                        L"CPU parallel"));
+    reducers.push_back(ReducerDescription(std::make_shared<VectorizedReduction>(),                                                      L"CPU parallel vectorized"));
     reducers.push_back(ReducerDescription(std::make_shared<SimpleReduction>(),                                                          L"C++ AMP simple model"));
     reducers.push_back(ReducerDescription(std::make_shared<SimpleArrayViewReduction>(),                                                 L"C++ AMP simple model using array_view"));
     reducers.push_back(ReducerDescription(std::make_shared<SimpleOptimizedReduction>(),                                                 L"C++ AMP simple model optimized"));
@@ -116,17 +156,17 @@ void main()
     reducers.push_back(ReducerDescription(std::make_shared<CascadingReduction<tileSize, tileCount>>(),                                  L"C++ AMP cascading reduction"));
     reducers.push_back(ReducerDescription(std::make_shared<CascadingUnrolledReduction<tileSize, tileCount>>(),                          L"C++ AMP cascading reduction & unrolling"));
 
-    std::wcout << std::endl << "                                                           Total : Calc" << std::endl << std::endl;
-
     accelerator_view view = accelerator(accelerator::default_accelerator).default_view;
+    g_benchmark = Benchmark(options, [&view]() { view.wait(); });
+    Benchmark::PrintHeader();
+
     for (size_t  i = 0; i < reducers.size(); ++i)
     {
         int result = 0;
         IReduce* reducerImpl = reducers[i].first.get();
         std::wstring reducerName = reducers[i].second;
         
-        double computeTime = 0.0, totalTime = 0.0;
-        totalTime = JitAndTimeFunc(view, [&]() 
+        const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
         {
 #ifdef MARKERS
             span funcSpan(g_markerSeries, reducerName.c_str());
@@ -145,12 +185,38 @@ void main()
                 << "         but found " << result << std::endl;
             continue;
         }
-        
-        std::wcout << "SUCCESS: " << reducerName;
-        std::wcout.width(max(0, 55 - reducerName.length()));
-        std::wcout << std::right << std::fixed << std::setprecision(2) << totalTime << " : " << computeTime << " (ms)" << std::endl;        
+        //  One addition per element, except for the overhead which does nothing. Only the CPU
+        //  reductions run on the host.
+        const size_t ops = (reducerName.compare(L"Overhead") == 0) ? 0 : elementCount;
+        const BenchmarkOpKind opKind = (reducerName.compare(0, 3, L"CPU") == 0) ? IntegerOps : AcceleratorOps;
+        g_benchmark.Report(L"SUCCESS", reducerName, timing, elementCount * sizeof(int), elementCount, ops, opKind);
     }
     std::wcout << std::endl;
+
+    std::wcout << "Running generic CPU reductions ..." << std::endl << std::endl;
+    RunGenericReductions<int>(view, L"int", elementCount);
+    RunGenericReductions<long long>(view, L"int64", elementCount);
+    RunGenericReductions<float>(view, L"float", elementCount);
+    RunGenericReductions<double>(view, L"double", elementCount);
+
+    std::wcout << "Running summation modes on full range data ..." << std::endl << std::endl;
+    RunAccurateReductions(view, elementCount);
+
+    std::wcout << "Running streaming reductions from a file ..." << std::endl << std::endl;
+    RunStreamingReductions(view, source, expectedResult);
+
+    std::wcout << "Running segmented reductions ..." << std::endl << std::endl;
+    RunSegmentedReductions(view, source);
+
+    std::wcout << "Running fused transform reductions ..." << std::endl << std::endl;
+    RunFusedReductions(view, elementCount);
+
+    std::wcout << "Running NUMA aware reductions ..." << std::endl << std::endl;
+    RunNumaReductions(view, source, expectedResult);
+
+    if (options.Roofline)
+        PrintRoofline(g_benchmark.Records(), MeasureMachinePeaks());
+    g_benchmark.WriteOutputs();
 }
 
 //----------------------------------------------------------------------------
@@ -163,4 +229,511 @@ inline bool validateSizes(unsigned tileSize, unsigned elementCount)
         elementCount /= tileSize;
     }
     return elementCount < tileSize;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------
+//  Example of a user defined operator for the generic reductions. 
+//----------------------------------------------------------------------------
+
+template <typename T>
+struct MaxMagnitudeOp
+{
+    T Identity() const { return T(0); }
+    T operator()(const T& a, const T& b) const 
+    {
+        const T absA = (a < T(0)) ? -a : a;
+        const T absB = (b < T(0)) ? -b : b;
+        return (absA > absB) ? absA : absB;
+    }
+};
+
+//----------------------------------------------------------------------------
+//  Time the sequential and SIMD parallel reductions for one operator and 
+//  validate the parallel result against the sequential one.
+//----------------------------------------------------------------------------
+
+template <typename T, typename Op>
+void RunGenericReduction(accelerator_view& view, const std::wstring& name, const std::vector<T>& source, const Op& op)
+{
+    SequentialReductionT<T, Op> sequential(op);
+    ParallelSimdReduction<T, Op> parallel(op);
+    const size_t bytes = source.size() * sizeof(T);
+
+    T expected = op.Identity();
+    BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+    {
+        expected = sequential.Reduce(view, source, computeTime);
+    });
+    g_benchmark.Report(L"SUCCESS", L"CPU sequential " + name, timing, bytes, source.size(), source.size(), HostOpKind<T>());
+
+    T result = op.Identity();
+    const std::wstring parallelName = L"CPU SIMD parallel " + name;
+    timing = g_benchmark.Measure([&](double& computeTime)
+    {
+#ifdef MARKERS
+        span funcSpan(g_markerSeries, parallelName.c_str());
+#endif
+        result = parallel.Reduce(view, source, computeTime);
+    });
+    if (expected != result)
+    {
+        std::wcout << "FAILED:  " << parallelName << " expected " << expected << std::endl 
+            << "         but found " << result << std::endl;
+        return;
+    }
+    g_benchmark.Report(L"SUCCESS", parallelName, timing, bytes, source.size(), source.size(), HostOpKind<T>());
+}
+
+template <typename T>
+void RunBitwiseReductions(accelerator_view& view, const std::wstring& typeName, const std::vector<T>& source, std::true_type)
+{
+    RunGenericReduction(view, typeName + L" bitwise and", source, BitAndOp<T>());
+    RunGenericReduction(view, typeName + L" bitwise or", source, BitOrOp<T>());
+    RunGenericReduction(view, typeName + L" bitwise xor", source, BitXorOp<T>());
+}
+
+//  Bitwise operators are only defined for integral types.
+template <typename T>
+void RunBitwiseReductions(accelerator_view& view, const std::wstring& typeName, const std::vector<T>& source, std::false_type)
+{
+}
+
+template <typename T>
+void RunGenericReductions(accelerator_view& view, const std::wstring& typeName, size_t elementCount)
+{
+    // Values are small integers in [-7, 7] so every partial sum is exact, even for float,
+    // and the sequential and parallel results can be compared directly.
+    std::vector<T> source(elementCount);
+    unsigned i = 0;
+    std::generate(source.begin(), source.end(), [&i]() { return T(int((i++ * 2654435761u) >> 16) % 15 - 7); });
+
+    RunGenericReduction(view, typeName + L" sum", source, SumOp<T>());
+    RunGenericReduction(view, typeName + L" min", source, MinOp<T>());
+    RunGenericReduction(view, typeName + L" max", source, MaxOp<T>());
+    RunBitwiseReductions(view, typeName, source, std::is_integral<T>());
+    RunGenericReduction(view, typeName + L" max magnitude", source, MaxMagnitudeOp<T>());
+    std::wcout << std::endl;
+}
+
+//----------------------------------------------------------------------------
+//  Compare the accuracy and throughput of the summation modes on full range 
+//  data, which overflows or loses precision when summed in the element type.
+//  Modes within the tolerance of the reference report SUCCESS, the others
+//  report INEXACT along with their error. Each mode declares its arithmetic
+//  per element for the roofline.
+//----------------------------------------------------------------------------
+
+template <typename T, typename TResult>
+void RunAccurateReduction(accelerator_view& view, const std::wstring& name, const IAccurateReduce<T, TResult>& reducer, 
+    const std::vector<T>& source, double reference, double tolerance, size_t flopsPerElement = 1)
+{
+    TResult result = TResult(0);
+    const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+    {
+#ifdef MARKERS
+        span funcSpan(g_markerSeries, name.c_str());
+#endif
+        result = reducer.Reduce(view, source, computeTime);
+    });
+
+    const double error = std::abs(double(result) - reference) / ((reference != 0.0) ? std::abs(reference) : 1.0);
+    std::wstringstream note;
+    note << L"relative error " << std::scientific << std::setprecision(2) << error;
+    g_benchmark.Report((error <= tolerance) ? L"SUCCESS" : L"INEXACT", name, timing, 
+        source.size() * sizeof(T), source.size(), flopsPerElement * source.size(), HostOpKind<T>(), note.str());
+}
+
+//  Neumaier's variant of Kahan summation in double precision. Accurate enough to be
+//  used as the reference for all the float summation modes.
+
+double ReferenceSum(const std::vector<float>& source)
+{
+    double sum = 0.0, compensation = 0.0;
+    std::for_each(source.cbegin(), source.cend(), [&](float value)
+    {
+        const double t = sum + value;
+        if (std::abs(sum) >= std::abs(double(value)))
+            compensation += (sum - t) + value;
+        else
+            compensation += (value - t) + sum;
+        sum = t;
+    });
+    return sum + compensation;
+}
+
+void RunAccurateReductions(accelerator_view& view, size_t elementCount)
+{
+    std::mt19937 engine(42);
+
+    //  Uniform ints over the whole range. Summing into a long long is exact for this many elements.
+    std::vector<int> intSource(elementCount);
+    std::uniform_int_distribution<int> intDist((std::numeric_limits<int>::min)(), (std::numeric_limits<int>::max)());
+    std::generate(intSource.begin(), intSource.end(), [&]() { return intDist(engine); });
+    const double intReference = double(std::accumulate(intSource.cbegin(), intSource.cend(), 0LL));
+
+    RunAccurateReduction(view, L"int sum in int", ElementTypeReduction<int, long long>(), intSource, intReference, 0.0);
+    RunAccurateReduction(view, L"int sum widened to int64", WideningReduction<int, long long>(), intSource, intReference, 0.0);
+    std::wcout << std::endl;
+
+    //  Log-normal floats spanning many orders of magnitude, similar to latency or size telemetry.
+    std::vector<float> floatSource(elementCount);
+    std::lognormal_distribution<float> floatDist(0.0f, 3.0f);
+    std::generate(floatSource.begin(), floatSource.end(), [&]() { return floatDist(engine); });
+    const double floatReference = ReferenceSum(floatSource);
+    const double floatTolerance = 1.0e-6;
+
+    RunAccurateReduction(view, L"float sum in float", ElementTypeReduction<float, double>(), floatSource, floatReference, floatTolerance);
+    RunAccurateReduction(view, L"float sum widened to double", WideningReduction<float, double>(), floatSource, floatReference, floatTolerance);
+    RunAccurateReduction(view, L"float pairwise sum", PairwiseReduction<float>(), floatSource, floatReference, floatTolerance);
+    RunAccurateReduction(view, L"float Kahan sum", KahanReduction(), floatSource, floatReference, floatTolerance, 4);
+    std::wcout << std::endl;
+}
+
+//----------------------------------------------------------------------------
+//  Write the source data to a temporary file and reduce it with both of the 
+//  streaming methods. Unbuffered reads bypass the file cache so they are 
+//  limited by the disk. The mapped file will usually still be in the file
+//  cache as it has just been written.
+//----------------------------------------------------------------------------
+
+template <typename Func>
+void RunStreamingReduction(accelerator_view& view, const std::wstring& reducerName, size_t bytes, int expectedResult, Func reduce)
+{
+    int result = 0;
+    BenchmarkResult timing;
+    try
+    {
+        timing = g_benchmark.Measure([&](double& computeTime)
+        {
+#ifdef MARKERS
+            span funcSpan(g_markerSeries, reducerName.c_str());
+#endif
+            result = reduce(computeTime);
+        });
+    }
+    catch (HRESULT hr)
+    {
+        std::wcout << "FAILED:  " << reducerName << " file error 0x" << std::hex << hr << std::dec << std::endl;
+        return;
+    }
+    if (expectedResult != result)
+    {
+        std::wcout << "FAILED:  " << reducerName << " expected " << expectedResult << std::endl 
+            << "         but found " << result << std::endl;
+        return;
+    }
+    //  No flops are declared as these are bound by the disk or file cache, not memory.
+    g_benchmark.Report(L"SUCCESS", reducerName, timing, bytes, bytes / sizeof(int));
+}
+
+void RunStreamingReductions(accelerator_view& view, const std::vector<int>& source, int expectedResult)
+{
+    wchar_t tempPath[MAX_PATH], tempFile[MAX_PATH];
+    if ((GetTempPathW(MAX_PATH, tempPath) == 0) || (GetTempFileNameW(tempPath, L"red", 0, tempFile) == 0))
+    {
+        std::wcout << "SKIPPED: streaming reductions - Unable to create a temporary file." << std::endl;
+        return;
+    }
+    const size_t bytes = source.size() * sizeof(int);
+    {
+        std::ofstream file(tempFile, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(source.data()), bytes);
+    }
+
+    //  Use small chunks so that even this modest file is streamed as several chunks.
+    const StreamingReduction<int, SumOp<int>> reducer(4 * 1024 * 1024);
+    const std::wstring path(tempFile);
+    RunStreamingReduction(view, L"CPU streaming overlapped unbuffered reads", bytes, expectedResult, 
+        [&](double& computeTime) { return reducer.ReduceFile(view, path, computeTime); });
+    RunStreamingReduction(view, L"CPU streaming memory mapped file", bytes, expectedResult, 
+        [&](double& computeTime) { return reducer.ReduceMappedFile(view, path, computeTime); });
+    std::wcout << std::endl;
+
+    DeleteFileW(tempFile);
+}
+
+//----------------------------------------------------------------------------
+//  Segmented reductions over segment lengths drawn from uniform and skewed 
+//  distributions. Reducing one segment per task balances well when segments
+//  are similar in length but a few very long segments leave most cores idle.
+//  The cascading segmented reduction splits the elements evenly whatever the
+//  segment lengths. Reduce-by-key also has to find the segments from the keys.
+//----------------------------------------------------------------------------
+
+template <typename Func>
+std::vector<int> MakeSegmentOffsets(int elementCount, Func nextLength)
+{
+    std::vector<int> offsets;
+    for (int start = 0; start < elementCount; start += nextLength())
+        offsets.push_back(start);
+    return offsets;
+}
+
+//  Bandwidth is reported for the values and keys read, ignoring the much smaller offsets.
+//  One integer addition per element.
+
+template <typename Func>
+void RunSegmentedReduction(accelerator_view& view, const std::wstring& reducerName, 
+    const std::vector<int>& expected, size_t bytes, size_t elements, Func reduce)
+{
+    std::vector<int> results;
+    const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+    {
+#ifdef MARKERS
+        span funcSpan(g_markerSeries, reducerName.c_str());
+#endif
+        results = reduce(computeTime);
+    });
+
+    if ((results.size() != expected.size()) || 
+        (std::mismatch(expected.cbegin(), expected.cend(), results.cbegin()).first != expected.cend()))
+    {
+        std::wcout << "FAILED:  " << reducerName << " differs from the sequential result" << std::endl;
+        return;
+    }
+    g_benchmark.Report(L"SUCCESS", reducerName, timing, bytes, elements, elements, IntegerOps);
+}
+
+void RunSegmentedDistribution(accelerator_view& view, const std::wstring& distributionName, 
+    const std::vector<int>& source, const std::vector<int>& offsets)
+{
+    const int elementCount = int(source.size());
+    const int segmentCount = int(offsets.size());
+    const SumOp<int> op;
+    std::wcout << distributionName << ", " << segmentCount << " segments" << std::endl;
+
+    const size_t bytes = source.size() * sizeof(int);
+
+    auto segmentLast = [&](int s) { return (s + 1 < segmentCount) ? offsets[s + 1] : elementCount; };
+
+    std::vector<int> expected(segmentCount);
+    const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+    {
+        computeTime = TimeFunc(view, [&]()
+        {
+            for (int s = 0; s < segmentCount; ++s)
+                expected[s] = std::accumulate(source.data() + offsets[s], source.data() + segmentLast(s), 0);
+        });
+    });
+    g_benchmark.Report(L"SUCCESS", L"CPU sequential segmented", timing, bytes, source.size(), source.size(), IntegerOps);
+
+    RunSegmentedReduction(view, L"CPU parallel one task per segment", expected, bytes, source.size(), [&](double& computeTime)
+    {
+        std::vector<int> results(segmentCount);
+        computeTime = TimeFunc(view, [&]()
+        {
+            parallel_for(0, segmentCount, [&](int s)
+            {
+                results[s] = details::ReduceSegment(source.data() + offsets[s], source.data() + segmentLast(s), op);
+            });
+        });
+        return results;
+    });
+
+    const SegmentedReduction<int, SumOp<int>> reducer;
+    RunSegmentedReduction(view, L"CPU parallel cascading segmented", expected, bytes, source.size(), [&](double& computeTime)
+    {
+        return reducer.Reduce(view, source, offsets, computeTime);
+    });
+
+    //  Key every element with the index of its segment. Empty segments have no keys
+    //  so their results are dropped from the expected values.
+
+    std::vector<int> keys(elementCount);
+    std::vector<int> expectedByKey;
+    expectedByKey.reserve(segmentCount);
+    for (int s = 0; s < segmentCount; ++s)
+    {
+        std::fill(keys.begin() + offsets[s], keys.begin() + segmentLast(s), s);
+        if (segmentLast(s) > offsets[s])
+            expectedByKey.push_back(expected[s]);
+    }
+    RunSegmentedReduction(view, L"CPU parallel reduce by key", expectedByKey, 2 * bytes, source.size(), [&](double& computeTime)
+    {
+        std::vector<int> uniqueKeys;
+        return reducer.ReduceByKey(view, keys, source, uniqueKeys, computeTime);
+    });
+    std::wcout << std::endl;
+}
+
+void RunSegmentedReductions(accelerator_view& view, const std::vector<int>& source)
+{
+    const int elementCount = int(source.size());
+    std::mt19937 engine(42);
+
+    RunSegmentedDistribution(view, L"Fixed length 256", source, 
+        MakeSegmentOffsets(elementCount, []() { return 256; }));
+
+    RunSegmentedDistribution(view, L"Fixed length 1", source, 
+        MakeSegmentOffsets(elementCount, []() { return 1; }));
+
+    //  Geometric lengths include some empty segments.
+    std::geometric_distribution<int> geometric(1.0 / 257.0);
+    RunSegmentedDistribution(view, L"Geometric, mean length 256", source, 
+        MakeSegmentOffsets(elementCount, [&]() { return geometric(engine); }));
+
+    //  Pareto lengths are mostly short with a long tail of very long segments.
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    RunSegmentedDistribution(view, L"Power law, Pareto alpha 1.1", source, 
+        MakeSegmentOffsets(elementCount, [&]() 
+        { 
+            return int((std::min)(double(elementCount), std::pow(1.0 - uniform(engine), -1.0 / 1.1)));
+        }));
+
+    //  One segment holds 90% of the elements and the rest are short.
+    bool isFirst = true;
+    RunSegmentedDistribution(view, L"One segment with 90% of the elements", source, 
+        MakeSegmentOffsets(elementCount, [&]() 
+        { 
+            const int length = isFirst ? (elementCount / 10) * 9 : 16;
+            isFirst = false;
+            return length;
+        }));
+}
+
+//----------------------------------------------------------------------------
+//  Compare fused transform reductions with transforming into a temporary 
+//  array and then reducing it. Both are parallel. The materialized version
+//  writes and reads back the temporary so it moves roughly twice as much
+//  memory. Bandwidth and arithmetic intensity are for the input data only so
+//  the materialized versions show up further below their roofline bound.
+//----------------------------------------------------------------------------
+
+template <typename TResult, typename Func>
+void RunFusedReduction(accelerator_view& view, const std::wstring& reducerName, size_t inputBytes, size_t elements, 
+    size_t flopsPerElement, double expected, double tolerance, Func reduce)
+{
+    TResult result = TResult(0);
+    const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+    {
+        computeTime = TimeFunc(view, [&]()
+        {
+#ifdef MARKERS
+            span funcSpan(g_markerSeries, reducerName.c_str());
+#endif
+            result = reduce();
+        });
+    });
+
+    const double error = std::abs(double(result) - expected) / ((expected != 0.0) ? std::abs(expected) : 1.0);
+    if (error > tolerance)
+    {
+        std::wcout << "FAILED:  " << reducerName << " expected " << expected << std::endl 
+            << "         but found " << result << std::endl;
+        return;
+    }
+    g_benchmark.Report(L"SUCCESS", reducerName, timing, inputBytes, elements, flopsPerElement * elements, FloatOps);
+}
+
+void RunFusedReductions(accelerator_view& view, size_t elementCount)
+{
+    //  Values in [0, 1) so float sums of products and squares stay well conditioned.
+    std::mt19937 engine(42);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> a(elementCount), b(elementCount);
+    std::generate(a.begin(), a.end(), [&]() { return dist(engine); });
+    std::generate(b.begin(), b.end(), [&]() { return dist(engine); });
+
+    double dot = 0.0, squares = 0.0;
+    long long below = 0;
+    for (size_t i = 0; i < elementCount; ++i)
+    {
+        dot += double(a[i]) * b[i];
+        squares += double(a[i]) * a[i];
+        below += (a[i] < 0.25f) ? 1 : 0;
+    }
+
+    const float* first = a.data();
+    const float* last = a.data() + a.size();
+    const int count = int(elementCount);
+    const size_t bytes = elementCount * sizeof(float);
+    const double tolerance = 1.0e-4;
+    std::vector<float> temp(elementCount);
+
+    RunFusedReduction<float>(view, L"CPU materialized dot product", 2 * bytes, elementCount, 2, dot, tolerance, [&]()
+    {
+        parallel_for(0, count, [&](int i) { temp[i] = a[i] * b[i]; });
+        return ParallelSimdReduce(temp.data(), temp.data() + temp.size(), SumOp<float>());
+    });
+    RunFusedReduction<float>(view, L"CPU fused dot product", 2 * bytes, elementCount, 2, dot, tolerance, [&]()
+    {
+        return ParallelDotProduct(first, last, b.data());
+    });
+
+    RunFusedReduction<float>(view, L"CPU materialized L2 norm", bytes, elementCount, 2, std::sqrt(squares), tolerance, [&]()
+    {
+        parallel_for(0, count, [&](int i) { temp[i] = a[i] * a[i]; });
+        return std::sqrt(ParallelSimdReduce(temp.data(), temp.data() + temp.size(), SumOp<float>()));
+    });
+    RunFusedReduction<float>(view, L"CPU fused L2 norm", bytes, elementCount, 2, std::sqrt(squares), tolerance, [&]()
+    {
+        return ParallelL2Norm(first, last);
+    });
+
+    std::vector<int> flags(elementCount);
+    RunFusedReduction<long long>(view, L"CPU materialized count if", bytes, elementCount, 1, double(below), 0.0, [&]()
+    {
+        parallel_for(0, count, [&](int i) { flags[i] = (a[i] < 0.25f) ? 1 : 0; });
+        return (long long)ParallelSimdReduce(flags.data(), flags.data() + flags.size(), SumOp<int>());
+    });
+    RunFusedReduction<long long>(view, L"CPU fused count if", bytes, elementCount, 1, double(below), 0.0, [&]()
+    {
+        return ParallelCountIf(first, last, LessThan<float>(0.25f));
+    });
+
+    //  A transform without a vectorized implementation uses the scalar loop.
+    RunFusedReduction<double>(view, L"CPU fused user transform", 2 * bytes, elementCount, 2, dot, tolerance, [&]()
+    {
+        return ParallelTransformReduce(first, last, b.data(), 
+            [](float x, float y) { return double(x) * y; }, SumOp<double>());
+    });
+    std::wcout << std::endl;
+}
+
+//----------------------------------------------------------------------------
+//  Scaling of the NUMA aware reduction from one node to all of them, relative
+//  to the CPU parallel reduction, which uses all cores but ignores where the 
+//  data was allocated. On a machine with a single node only one row is shown.
+//----------------------------------------------------------------------------
+
+void RunNumaReductions(accelerator_view& view, const std::vector<int>& source, int expectedResult)
+{
+    const ParallelReduction parallel;
+    const size_t bytes = source.size() * sizeof(int);
+    const BenchmarkResult baseline = g_benchmark.Measure([&](double& computeTime)
+    {
+        parallel.Reduce(view, source, computeTime);
+    });
+    g_benchmark.Report(L"SUCCESS", L"CPU parallel", baseline, bytes, source.size(), source.size(), IntegerOps);
+
+    const int nodeCount = NumaReduction::AvailableNodeCount();
+    for (int nodes = 1; nodes <= nodeCount; ++nodes)
+    {
+        const NumaReduction reducer(nodes);
+        std::wstringstream name;
+        name << L"CPU NUMA aware, " << reducer.NodeCount() << L" node(s), " << reducer.ProcessorCount() << L" cores";
+        const std::wstring reducerName = name.str();
+
+        int result = 0;
+        std::vector<double> copyTimes;
+        const BenchmarkResult timing = g_benchmark.Measure([&](double& computeTime)
+        {
+#ifdef MARKERS
+            span funcSpan(g_markerSeries, reducerName.c_str());
+#endif
+            result = reducer.Reduce(view, source, computeTime);
+            copyTimes.push_back(reducer.LastCopyTime());
+        });
+        if (expectedResult != result)
+        {
+            std::wcout << "FAILED:  " << reducerName << " expected " << expectedResult << std::endl 
+                << "         but found " << result << std::endl;
+            continue;
+        }
+        std::wstringstream note;
+        note << std::fixed << std::setprecision(2) << baseline.Compute.Median / timing.Compute.Median << L"x CPU parallel, copy to nodes " 
+            << ComputeStatistics(copyTimes, 0.0).Median << L" ms";
+        g_benchmark.Report(L"SUCCESS", reducerName, timing, bytes, source.size(), source.size(), IntegerOps, note.str());
+    }
+    std::wcout << std::endl;
+}
@@ -0,0 +1,356 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+
+//----------------------------------------------------------------------------
+// Machine ceilings for a roofline report, measured on the host CPU. Used by
+// the benchmark harness when run with --roofline. Like Benchmark.h, the other
+// projects include this copy.
+//
+// Memory bandwidth is measured with the STREAM triad, a[i] = b[i] + s * c[i],
+// over arrays much larger than the last level cache, on every hardware 
+// thread. Bytes are counted the STREAM way: two reads and one write per 
+// element. Peak FLOP/s is measured with independent chains of multiplies and
+// adds on every hardware thread, using AVX if the CPU and OS support it and
+// SSE otherwise. Peak integer operations per second are measured the same 
+// way with chains of 32-bit additions, using AVX2 or SSE2. FMA code could go
+// higher than the floating point ceiling.
+//
+// Each kernel's bound is the lower of the compute ceiling for its kind of 
+// operations and its arithmetic intensity (operations per byte) times the 
+// bandwidth ceiling. Only rows that declare both bytes and operations are 
+// shown. Kernels running on a C++ AMP accelerator are listed with their 
+// intensity and attained rate but no bound, as the host's ceilings don't 
+// apply to them.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Benchmark.h"
+
+//  Functions using AVX or AVX2 are only called after checking for support. Visual C++
+//  allows the intrinsics anywhere. GCC and Clang need the function compiled for the 
+//  instruction set, without enabling it for the rest of the program.
+
+#if defined(_MSC_VER)
+#define ROOFLINE_TARGET_AVX
+#define ROOFLINE_TARGET_AVX2
+#else
+#define ROOFLINE_TARGET_AVX __attribute__((target("avx")))
+#define ROOFLINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+struct MachinePeaks
+{
+    double GigabytesPerSecond;
+    double GigaflopsPerSecond;
+    double GigaopsPerSecond;
+    const wchar_t* FloatInstructions;
+    const wchar_t* IntegerInstructions;
+};
+
+namespace details
+{
+    //  Run work(threadIndex) on threadCount threads and return the elapsed time in 
+    //  milliseconds.
+
+    template <typename Func>
+    double TimeOnAllThreads(int threadCount, Func work)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        BenchmarkTimer timer;
+        for (int t = 0; t < threadCount; ++t)
+            threads.push_back(std::thread([=]() { work(t); }));
+        std::for_each(threads.begin(), threads.end(), [](std::thread& t) { t.join(); });
+        return timer.ElapsedMilliseconds();
+    }
+
+    //  Check for AVX, or AVX2 if isAvx2, in both the CPU and the OS, which must save the 
+    //  YMM registers.
+
+    inline bool IsAvxSupported(bool isAvx2)
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx)
+            return false;
+        if ((_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        if (!isAvx2)
+            return true;
+        if (maxLeaf < 7)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return (isAvx2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("avx")) != 0;
+#endif
+    }
+
+    inline double MeasureTriadBandwidth(int threadCount)
+    {
+        const size_t elementCount = 8 * 1024 * 1024;
+        const int repetitions = 5;
+        std::vector<double> a(elementCount), b(elementCount), c(elementCount);
+        double* pa = a.data();
+        const double* pb = b.data();
+        const double* pc = c.data();
+        const double scalar = 3.0;
+
+        auto triad = [=](int t)
+        {
+            const size_t first = (elementCount * t) / threadCount;
+            const size_t last = (elementCount * (t + 1)) / threadCount;
+            for (size_t i = first; i < last; ++i)
+                pa[i] = pb[i] + scalar * pc[i];
+        };
+
+        //  The first run also faults in any pages not yet touched.
+        TimeOnAllThreads(threadCount, triad);
+        double best = 1.0e30;
+        for (int r = 0; r < repetitions; ++r)
+            best = (std::min)(best, TimeOnAllThreads(threadCount, triad));
+        return 3.0 * sizeof(double) * elementCount / (best * 1.0e6);
+    }
+
+    //  Each chain computes x = x * m + a, one multiply and one add on four lanes, with
+    //  m and a chosen so x converges to a normal value. Twelve chains are enough to 
+    //  cover the latency of both operations on current CPUs. The chains are written 
+    //  out, rather than kept in an array, so that the compiler keeps them in registers.
+
+    inline float FlopChains(int iterations, float m, float a)
+    {
+        const __m128 vm = _mm_set1_ps(m);
+        const __m128 va = _mm_set1_ps(a);
+        __m128 x0 = _mm_set1_ps(0.0f), x1 = _mm_set1_ps(1.0f), x2 = _mm_set1_ps(2.0f), x3 = _mm_set1_ps(3.0f);
+        __m128 x4 = _mm_set1_ps(4.0f), x5 = _mm_set1_ps(5.0f), x6 = _mm_set1_ps(6.0f), x7 = _mm_set1_ps(7.0f);
+        __m128 x8 = _mm_set1_ps(8.0f), x9 = _mm_set1_ps(9.0f), x10 = _mm_set1_ps(10.0f), x11 = _mm_set1_ps(11.0f);
+        for (int i = 0; i < iterations; ++i)
+        {
+            x0 = _mm_add_ps(_mm_mul_ps(x0, vm), va);
+            x1 = _mm_add_ps(_mm_mul_ps(x1, vm), va);
+            x2 = _mm_add_ps(_mm_mul_ps(x2, vm), va);
+            x3 = _mm_add_ps(_mm_mul_ps(x3, vm), va);
+            x4 = _mm_add_ps(_mm_mul_ps(x4, vm), va);
+            x5 = _mm_add_ps(_mm_mul_ps(x5, vm), va);
+            x6 = _mm_add_ps(_mm_mul_ps(x6, vm), va);
+            x7 = _mm_add_ps(_mm_mul_ps(x7, vm), va);
+            x8 = _mm_add_ps(_mm_mul_ps(x8, vm), va);
+            x9 = _mm_add_ps(_mm_mul_ps(x9, vm), va);
+            x10 = _mm_add_ps(_mm_mul_ps(x10, vm), va);
+            x11 = _mm_add_ps(_mm_mul_ps(x11, vm), va);
+        }
+        __m128 sum = _mm_add_ps(_mm_add_ps(x0, x1), _mm_add_ps(x2, x3));
+        sum = _mm_add_ps(sum, _mm_add_ps(_mm_add_ps(x4, x5), _mm_add_ps(x6, x7)));
+        sum = _mm_add_ps(sum, _mm_add_ps(_mm_add_ps(x8, x9), _mm_add_ps(x10, x11)));
+        return _mm_cvtss_f32(sum);
+    }
+
+    //  The same chains on eight lanes.
+
+    ROOFLINE_TARGET_AVX inline float FlopChainsAvx(int iterations, float m, float a)
+    {
+        const __m256 vm = _mm256_set1_ps(m);
+        const __m256 va = _mm256_set1_ps(a);
+        __m256 x0 = _mm256_set1_ps(0.0f), x1 = _mm256_set1_ps(1.0f), x2 = _mm256_set1_ps(2.0f), x3 = _mm256_set1_ps(3.0f);
+        __m256 x4 = _mm256_set1_ps(4.0f), x5 = _mm256_set1_ps(5.0f), x6 = _mm256_set1_ps(6.0f), x7 = _mm256_set1_ps(7.0f);
+        __m256 x8 = _mm256_set1_ps(8.0f), x9 = _mm256_set1_ps(9.0f), x10 = _mm256_set1_ps(10.0f), x11 = _mm256_set1_ps(11.0f);
+        for (int i = 0; i < iterations; ++i)
+        {
+            x0 = _mm256_add_ps(_mm256_mul_ps(x0, vm), va);
+            x1 = _mm256_add_ps(_mm256_mul_ps(x1, vm), va);
+            x2 = _mm256_add_ps(_mm256_mul_ps(x2, vm), va);
+            x3 = _mm256_add_ps(_mm256_mul_ps(x3, vm), va);
+            x4 = _mm256_add_ps(_mm256_mul_ps(x4, vm), va);
+            x5 = _mm256_add_ps(_mm256_mul_ps(x5, vm), va);
+            x6 = _mm256_add_ps(_mm256_mul_ps(x6, vm), va);
+            x7 = _mm256_add_ps(_mm256_mul_ps(x7, vm), va);
+            x8 = _mm256_add_ps(_mm256_mul_ps(x8, vm), va);
+            x9 = _mm256_add_ps(_mm256_mul_ps(x9, vm), va);
+            x10 = _mm256_add_ps(_mm256_mul_ps(x10, vm), va);
+            x11 = _mm256_add_ps(_mm256_mul_ps(x11, vm), va);
+        }
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(x0, x1), _mm256_add_ps(x2, x3));
+        sum = _mm256_add_ps(sum, _mm256_add_ps(_mm256_add_ps(x4, x5), _mm256_add_ps(x6, x7)));
+        sum = _mm256_add_ps(sum, _mm256_add_ps(_mm256_add_ps(x8, x9), _mm256_add_ps(x10, x11)));
+        const float result = _mm_cvtss_f32(_mm256_castps256_ps128(sum));
+        _mm256_zeroupper();
+        return result;
+    }
+
+    //  Each chain adds the previous value of the next chain, on four 32-bit lanes, so the
+    //  loop can't be folded into a multiply but the additions in an iteration are still
+    //  independent. Additions have a latency of one cycle, so six chains are enough and 
+    //  they fit in the eight SSE registers of a 32-bit build.
+
+    inline int IntegerChains(int iterations, int seed)
+    {
+        __m128i x0 = _mm_set1_epi32(seed), x1 = _mm_set1_epi32(seed + 1), x2 = _mm_set1_epi32(seed + 2);
+        __m128i x3 = _mm_set1_epi32(seed + 3), x4 = _mm_set1_epi32(seed + 4), x5 = _mm_set1_epi32(seed + 5);
+        for (int i = 0; i < iterations; ++i)
+        {
+            const __m128i first = x0;
+            x0 = _mm_add_epi32(x0, x1);
+            x1 = _mm_add_epi32(x1, x2);
+            x2 = _mm_add_epi32(x2, x3);
+            x3 = _mm_add_epi32(x3, x4);
+            x4 = _mm_add_epi32(x4, x5);
+            x5 = _mm_add_epi32(x5, first);
+        }
+        const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(x0, x1), _mm_add_epi32(x2, x3)), _mm_add_epi32(x4, x5));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    //  The same chains on eight lanes.
+
+    ROOFLINE_TARGET_AVX2 inline int IntegerChainsAvx2(int iterations, int seed)
+    {
+        __m256i x0 = _mm256_set1_epi32(seed), x1 = _mm256_set1_epi32(seed + 1), x2 = _mm256_set1_epi32(seed + 2);
+        __m256i x3 = _mm256_set1_epi32(seed + 3), x4 = _mm256_set1_epi32(seed + 4), x5 = _mm256_set1_epi32(seed + 5);
+        for (int i = 0; i < iterations; ++i)
+        {
+            const __m256i first = x0;
+            x0 = _mm256_add_epi32(x0, x1);
+            x1 = _mm256_add_epi32(x1, x2);
+            x2 = _mm256_add_epi32(x2, x3);
+            x3 = _mm256_add_epi32(x3, x4);
+            x4 = _mm256_add_epi32(x4, x5);
+            x5 = _mm256_add_epi32(x5, first);
+        }
+        const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(x0, x1), _mm256_add_epi32(x2, x3)), _mm256_add_epi32(x4, x5));
+        const int result = _mm_cvtsi128_si32(_mm256_castsi256_si128(sum));
+        _mm256_zeroupper();
+        return result;
+    }
+
+    inline double MeasurePeakFlops(int threadCount, bool useAvx)
+    {
+        const int iterations = 20 * 1000 * 1000;
+        const double flopsPerIteration = 12 * (useAvx ? 8 : 4) * 2;
+
+        //  Volatile so the compiler can't fold the constants into the loop.
+        volatile float m = 0.999999f;
+        volatile float a = 1.0e-7f;
+        const float mv = m, av = a;
+        std::vector<float> sinks(threadCount);
+        float* pSinks = sinks.data();
+
+        double best = 1.0e30;
+        for (int r = 0; r < 3; ++r)
+            best = (std::min)(best, TimeOnAllThreads(threadCount, [=](int t) 
+            { 
+                pSinks[t] = useAvx ? FlopChainsAvx(iterations, mv, av) : FlopChains(iterations, mv, av); 
+            }));
+        return flopsPerIteration * iterations * threadCount / (best * 1.0e6);
+    }
+
+    inline double MeasurePeakIntegerOps(int threadCount, bool useAvx2)
+    {
+        const int iterations = 40 * 1000 * 1000;
+        const double opsPerIteration = 6 * (useAvx2 ? 8 : 4);
+
+        volatile int seed = 1;
+        const int sv = seed;
+        std::vector<int> sinks(threadCount);
+        int* pSinks = sinks.data();
+
+        double best = 1.0e30;
+        for (int r = 0; r < 3; ++r)
+            best = (std::min)(best, TimeOnAllThreads(threadCount, [=](int t) 
+            { 
+                pSinks[t] = useAvx2 ? IntegerChainsAvx2(iterations, sv) : IntegerChains(iterations, sv); 
+            }));
+        return opsPerIteration * iterations * threadCount / (best * 1.0e6);
+    }
+}
+
+inline MachinePeaks MeasureMachinePeaks()
+{
+    const int threadCount = (std::max)(1, int(std::thread::hardware_concurrency()));
+    const bool hasAvx = details::IsAvxSupported(false);
+    const bool hasAvx2 = details::IsAvxSupported(true);
+    MachinePeaks peaks;
+    peaks.GigabytesPerSecond = details::MeasureTriadBandwidth(threadCount);
+    peaks.GigaflopsPerSecond = details::MeasurePeakFlops(threadCount, hasAvx);
+    peaks.GigaopsPerSecond = details::MeasurePeakIntegerOps(threadCount, hasAvx2);
+    peaks.FloatInstructions = hasAvx ? L"AVX" : L"SSE";
+    peaks.IntegerInstructions = hasAvx2 ? L"AVX2" : L"SSE2";
+    return peaks;
+}
+
+inline void PrintRoofline(const std::vector<BenchmarkRecord>& records, const MachinePeaks& peaks)
+{
+    static const wchar_t* kindNames[] = { L"float", L"int", L"accel" };
+
+    std::wcout << std::endl << "Roofline, host ceilings " << std::fixed << std::setprecision(2) 
+        << peaks.GigabytesPerSecond << " GB/s (STREAM triad), " << peaks.GigaflopsPerSecond << " GFLOP/s (" 
+        << peaks.FloatInstructions << " multiply + add) and " << peaks.GigaopsPerSecond << " GOP/s (" 
+        << peaks.IntegerInstructions << " 32-bit add)" << std::endl << "Ridge points " 
+        << peaks.GigaflopsPerSecond / peaks.GigabytesPerSecond << " flop/byte and " 
+        << peaks.GigaopsPerSecond / peaks.GigabytesPerSecond << " integer op/byte" << std::endl << std::endl;
+    std::wcout << "                                                            Kind   op/byte    Gop/s    Bound  Limit      % of bound" 
+        << std::endl << std::endl;
+
+    int rowCount = 0;
+    bool hasAcceleratorRows = false;
+    std::for_each(records.cbegin(), records.cend(), [&](const BenchmarkRecord& r)
+    {
+        if ((r.Flops == 0) || (r.Bytes == 0))
+            return;
+        ++rowCount;
+        const double intensity = double(r.Flops) / double(r.Bytes);
+        const double attained = Benchmark::GigaflopsPerSecond(r.Result, r.Flops);
+
+        std::wcout << r.Name << std::right << std::setw((std::max)(6, 64 - int(r.Name.length()))) << kindNames[r.OpKind] 
+            << std::setw(10) << intensity << std::setw(9) << attained;
+        if (r.OpKind == AcceleratorOps)
+        {
+            hasAcceleratorRows = true;
+            std::wcout << std::setw(9) << L"-" << L"  -      " << std::setw(14) << L"-" << std::endl;
+            return;
+        }
+
+        const double computeBound = (r.OpKind == IntegerOps) ? peaks.GigaopsPerSecond : peaks.GigaflopsPerSecond;
+        const double memoryBound = intensity * peaks.GigabytesPerSecond;
+        const bool isMemoryBound = memoryBound < computeBound;
+        const double bound = isMemoryBound ? memoryBound : computeBound;
+        std::wcout << std::setw(9) << bound << (isMemoryBound ? L"  memory " : L"  compute") 
+            << std::setw(14) << 100.0 * attained / bound << std::endl;
+    });
+    if (rowCount == 0)
+        std::wcout << "No kernels declared their operations." << std::endl;
+    if (hasAcceleratorRows)
+        std::wcout << std::endl << "Accelerator kernels have no bound, the ceilings are for the host." << std::endl;
+    std::wcout.unsetf(std::ios_base::floatfield);
+}
@@ -0,0 +1,198 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel segmented reduction and reduce-by-key.
+//
+// This uses the same cascading idea as CascadingReduction. The elements,
+// not the segments, are split into equal blocks so each worker has the
+// same amount of work however skewed the segment lengths are. Each worker
+// reduces the segments that start in its block, sequentially, up to the end
+// of its block. Elements at the start of a block that belong to a segment
+// started in an earlier block are reduced into a carry. A short sequential
+// pass then folds each block's carry into its segment, in order, so the
+// operator only needs to be associative.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <assert.h>
+#include <ppl.h>
+
+#include "SimdReduce.h"
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+using namespace concurrency;
+
+namespace details
+{
+    //  Segments shorter than this are reduced with a scalar loop. Setting up and 
+    //  combining the SIMD accumulators costs more than it saves on short ranges.
+
+    template <typename T, typename Op>
+    inline T ReduceSegment(const T* first, const T* last, const Op& op)
+    {
+        const ptrdiff_t minSimdLength = 64;
+        if ((last - first) < minSimdLength)
+            return std::accumulate(first, last, op.Identity(), op);
+        return SimdReduce(first, last, op);
+    }
+
+    //  Reduce the segments that start in [blockFirst, blockLast). Returns the carry, 
+    //  the reduction of the elements before the first segment start in the block, and 
+    //  the segment it belongs to, or -1 if there is no carry.
+
+    template <typename T, typename Op>
+    T ReduceSegmentBlock(const T* values, const int* offsets, int segmentCount, 
+        int blockFirst, int blockLast, T* results, const Op& op, int& carrySegment)
+    {
+        int s = int(std::lower_bound(offsets, offsets + segmentCount, blockFirst) - offsets);
+        const int carryLast = (s < segmentCount) ? (std::min)(offsets[s], blockLast) : blockLast;
+        carrySegment = (carryLast > blockFirst) ? s - 1 : -1;
+        const T carry = ReduceSegment(values + blockFirst, values + carryLast, op);
+
+        for (; (s < segmentCount) && (offsets[s] < blockLast); ++s)
+        {
+            const int segmentLast = (s + 1 < segmentCount) ? (std::min)(offsets[s + 1], blockLast) : blockLast;
+            results[s] = ReduceSegment(values + offsets[s], values + segmentLast, op);
+        }
+        return carry;
+    }
+
+    //  Offsets of the first element of each run of equal keys. Each block counts the
+    //  run starts it contains, an exclusive scan of the counts gives each block its
+    //  output position and each block then writes its offsets.
+
+    template <typename TKey>
+    std::vector<int> RunOffsets(const TKey* keys, int elementCount)
+    {
+        const int blockCount = ParallelChunkCount(elementCount);
+        std::vector<int> blockStarts(blockCount + 1, 0);
+        auto isRunStart = [=](int i) { return (i == 0) || !(keys[i] == keys[i - 1]); };
+
+        parallel_for(0, blockCount, [=, &blockStarts](int b)
+        {
+            const int blockFirst = int((ptrdiff_t(elementCount) * b) / blockCount);
+            const int blockLast = int((ptrdiff_t(elementCount) * (b + 1)) / blockCount);
+            if (blockFirst == blockLast)
+                return;
+            int count = isRunStart(blockFirst) ? 1 : 0;
+            for (int i = blockFirst + 1; i < blockLast; ++i)
+                count += (keys[i] == keys[i - 1]) ? 0 : 1;
+            blockStarts[b + 1] = count;
+        });
+        std::partial_sum(blockStarts.cbegin(), blockStarts.cend(), blockStarts.begin());
+
+        std::vector<int> offsets(blockStarts[blockCount]);
+        parallel_for(0, blockCount, [=, &blockStarts, &offsets](int b)
+        {
+            const int blockFirst = int((ptrdiff_t(elementCount) * b) / blockCount);
+            const int blockLast = int((ptrdiff_t(elementCount) * (b + 1)) / blockCount);
+            int* out = offsets.data() + blockStarts[b];
+            for (int i = blockFirst; i < blockLast; ++i)
+            {
+                if (isRunStart(i))
+                    *out++ = i;
+            }
+        });
+        return offsets;
+    }
+}
+
+//  Reduce each segment of values. Segment i is [offsets[i], offsets[i + 1]) and the 
+//  last segment ends at elementCount. Offsets must start at zero and be non-decreasing.
+//  Empty segments reduce to the identity.
+
+template <typename T, typename Op>
+void ParallelSegmentedReduce(const T* values, int elementCount, const int* offsets, int segmentCount, 
+    T* results, const Op& op)
+{
+    assert((segmentCount == 0) || (offsets[0] == 0));
+
+    std::fill(results, results + segmentCount, op.Identity());
+    if ((segmentCount == 0) || (elementCount == 0))
+        return;
+
+    const int blockCount = ParallelChunkCount(elementCount);
+    std::vector<T> carries(blockCount, op.Identity());
+    std::vector<int> carrySegments(blockCount, -1);
+    parallel_for(0, blockCount, [=, &carries, &carrySegments](int b)
+    {
+        const int blockFirst = int((ptrdiff_t(elementCount) * b) / blockCount);
+        const int blockLast = int((ptrdiff_t(elementCount) * (b + 1)) / blockCount);
+        carries[b] = details::ReduceSegmentBlock(values, offsets, segmentCount, 
+            blockFirst, blockLast, results, op, carrySegments[b]);
+    });
+
+    //  Blocks are visited in order so a segment spanning several blocks is combined 
+    //  left to right.
+
+    for (int b = 1; b < blockCount; ++b)
+    {
+        if (carrySegments[b] >= 0)
+            results[carrySegments[b]] = op(results[carrySegments[b]], carries[b]);
+    }
+}
+
+template <typename T, typename Op>
+class SegmentedReduction
+{
+private:
+    Op m_op;
+
+public:
+    SegmentedReduction(const Op& op = Op()) : m_op(op) { }
+
+    std::vector<T> Reduce(accelerator_view& view, const std::vector<T>& source, 
+        const std::vector<int>& segmentOffsets, double& computeTime) const
+    {
+        std::vector<T> results(segmentOffsets.size());
+        computeTime = TimeFunc(view, [&]()
+        {
+            ParallelSegmentedReduce(source.data(), int(source.size()), 
+                segmentOffsets.data(), int(segmentOffsets.size()), results.data(), m_op);
+        });
+        return results;
+    }
+
+    //  Reduce each run of equal keys. Keys are usually sorted but only equal keys 
+    //  need to be adjacent. Returns one result per run and the key of each run.
+
+    template <typename TKey>
+    std::vector<T> ReduceByKey(accelerator_view& view, const std::vector<TKey>& keys, 
+        const std::vector<T>& source, std::vector<TKey>& uniqueKeys, double& computeTime) const
+    {
+        assert(keys.size() == source.size());
+
+        std::vector<T> results;
+        computeTime = TimeFunc(view, [&]()
+        {
+            const std::vector<int> offsets = details::RunOffsets(keys.data(), int(keys.size()));
+            const int segmentCount = int(offsets.size());
+
+            results.resize(segmentCount);
+            uniqueKeys.resize(segmentCount);
+            parallel_for(0, segmentCount, [&](int s) { uniqueKeys[s] = keys[offsets[s]]; });
+            ParallelSegmentedReduce(source.data(), int(source.size()), 
+                offsets.data(), segmentCount, results.data(), m_op);
+        });
+        return results;
+    }
+};
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "IReduce.h"
+#include "IReduceT.h"
 #include "Timer.h"
 #include <vector>
 
@@ -37,3 +38,26 @@ public:
         return total;
     }
 };
+
+//  Sequential reduction for any element type and associative operator. 
+//  Used as the reference result when validating generic reductions.
+
+template <typename T, typename Op>
+class SequentialReductionT : public IReduceT<T, Op>
+{
+private:
+    Op m_op;
+
+public:
+    SequentialReductionT(const Op& op = Op()) : m_op(op) { }
+
+    T Reduce(accelerator_view& view, const std::vector<T>& source, double& computeTime) const
+    {
+        T total = m_op.Identity();
+        computeTime = TimeFunc(view, [&]()
+        {
+            total = std::accumulate(source.cbegin(), source.cend(), m_op.Identity(), m_op);
+        });
+        return total;
+    }
+};
@@ -0,0 +1,277 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Single threaded SIMD reduction of a contiguous range on the CPU.
+//
+// Each (type, operator) pair with an SSE2 equivalent is reduced four
+// registers at a time. The four registers are then combined into one and
+// reduced as a tree within the register. All other pairs, including user
+// defined functors, fall back to an in-order scalar loop.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+#include <emmintrin.h>
+
+#include "ReduceOperators.h"
+
+namespace details
+{
+    //  Loads, splats and in-register tree reduction for each element type.
+
+    template <typename T>
+    struct SimdVector
+    {
+    };
+
+    template <>
+    struct SimdVector<int>
+    {
+        typedef __m128i Type;
+        enum { Width = 4 };
+
+        static inline Type Load(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static inline Type Splat(int v) { return _mm_set1_epi32(v); }
+
+        template <typename Combine>
+        static inline int Horizontal(Type v, const Combine& combine)
+        {
+            v = combine(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+            v = combine(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtsi128_si32(v);
+        }
+    };
+
+    template <>
+    struct SimdVector<long long>
+    {
+        typedef __m128i Type;
+        enum { Width = 2 };
+
+        static inline Type Load(const long long* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static inline Type Splat(long long v)
+        {
+            const __m128i low = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&v));
+            return _mm_unpacklo_epi64(low, low);
+        }
+
+        template <typename Combine>
+        static inline long long Horizontal(Type v, const Combine& combine)
+        {
+            v = combine(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+            long long result;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&result), v);
+            return result;
+        }
+    };
+
+    template <>
+    struct SimdVector<float>
+    {
+        typedef __m128 Type;
+        enum { Width = 4 };
+
+        static inline Type Load(const float* p) { return _mm_loadu_ps(p); }
+        static inline Type Splat(float v) { return _mm_set1_ps(v); }
+
+        template <typename Combine>
+        static inline float Horizontal(Type v, const Combine& combine)
+        {
+            v = combine(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+            v = combine(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtss_f32(v);
+        }
+    };
+
+    template <>
+    struct SimdVector<double>
+    {
+        typedef __m128d Type;
+        enum { Width = 2 };
+
+        static inline Type Load(const double* p) { return _mm_loadu_pd(p); }
+        static inline Type Splat(double v) { return _mm_set1_pd(v); }
+
+        template <typename Combine>
+        static inline double Horizontal(Type v, const Combine& combine)
+        {
+            v = combine(v, _mm_shuffle_pd(v, v, 1));
+            return _mm_cvtsd_f64(v);
+        }
+    };
+
+    //  Register wide equivalent of each operator. Pairs without a specialization
+    //  are not supported and use the scalar loop.
+
+    template <typename T, typename Op>
+    struct SimdCombine
+    {
+        enum { IsSupported = false };
+    };
+
+    struct SimdBitwiseAnd
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const { return _mm_and_si128(a, b); }
+    };
+
+    struct SimdBitwiseOr
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const { return _mm_or_si128(a, b); }
+    };
+
+    struct SimdBitwiseXor
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const { return _mm_xor_si128(a, b); }
+    };
+
+    template <> struct SimdCombine<int, BitAndOp<int>> : SimdBitwiseAnd { };
+    template <> struct SimdCombine<int, BitOrOp<int>> : SimdBitwiseOr { };
+    template <> struct SimdCombine<int, BitXorOp<int>> : SimdBitwiseXor { };
+    template <> struct SimdCombine<long long, BitAndOp<long long>> : SimdBitwiseAnd { };
+    template <> struct SimdCombine<long long, BitOrOp<long long>> : SimdBitwiseOr { };
+    template <> struct SimdCombine<long long, BitXorOp<long long>> : SimdBitwiseXor { };
+
+    template <>
+    struct SimdCombine<int, SumOp<int>>
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const { return _mm_add_epi32(a, b); }
+    };
+
+    //  SSE2 has no 32-bit integer min/max so select using a comparison mask.
+
+    template <>
+    struct SimdCombine<int, MinOp<int>>
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const
+        {
+            const __m128i mask = _mm_cmplt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+    };
+
+    template <>
+    struct SimdCombine<int, MaxOp<int>>
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const
+        {
+            const __m128i mask = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+    };
+
+    template <>
+    struct SimdCombine<long long, SumOp<long long>>
+    {
+        enum { IsSupported = true };
+        __m128i operator()(__m128i a, __m128i b) const { return _mm_add_epi64(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<float, SumOp<float>>
+    {
+        enum { IsSupported = true };
+        __m128 operator()(__m128 a, __m128 b) const { return _mm_add_ps(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<float, MinOp<float>>
+    {
+        enum { IsSupported = true };
+        __m128 operator()(__m128 a, __m128 b) const { return _mm_min_ps(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<float, MaxOp<float>>
+    {
+        enum { IsSupported = true };
+        __m128 operator()(__m128 a, __m128 b) const { return _mm_max_ps(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<double, SumOp<double>>
+    {
+        enum { IsSupported = true };
+        __m128d operator()(__m128d a, __m128d b) const { return _mm_add_pd(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<double, MinOp<double>>
+    {
+        enum { IsSupported = true };
+        __m128d operator()(__m128d a, __m128d b) const { return _mm_min_pd(a, b); }
+    };
+
+    template <>
+    struct SimdCombine<double, MaxOp<double>>
+    {
+        enum { IsSupported = true };
+        __m128d operator()(__m128d a, __m128d b) const { return _mm_max_pd(a, b); }
+    };
+
+    //  Scalar fallback. Keeps the elements in order so the operator only needs to be associative.
+
+    template <typename T, typename Op>
+    inline T SimdReduce(const T* first, const T* last, const Op& op, std::false_type)
+    {
+        return std::accumulate(first, last, op.Identity(), op);
+    }
+
+    //  Four independent accumulators hide the latency of each combine.
+
+    template <typename T, typename Op>
+    inline T SimdReduce(const T* first, const T* last, const Op& op, std::true_type)
+    {
+        typedef SimdVector<T> Vec;
+        SimdCombine<T, Op> combine;
+        const ptrdiff_t step = 4 * Vec::Width;
+
+        typename Vec::Type acc0 = Vec::Splat(op.Identity());
+        typename Vec::Type acc1 = acc0;
+        typename Vec::Type acc2 = acc0;
+        typename Vec::Type acc3 = acc0;
+
+        const T* p = first;
+        for (; (last - p) >= step; p += step)
+        {
+            acc0 = combine(acc0, Vec::Load(p));
+            acc1 = combine(acc1, Vec::Load(p + Vec::Width));
+            acc2 = combine(acc2, Vec::Load(p + 2 * Vec::Width));
+            acc3 = combine(acc3, Vec::Load(p + 3 * Vec::Width));
+        }
+
+        T result = Vec::Horizontal(combine(combine(acc0, acc1), combine(acc2, acc3)), combine);
+        for (; p < last; ++p)
+            result = op(result, *p);
+        return result;
+    }
+}
+
+template <typename T, typename Op>
+inline T SimdReduce(const T* first, const T* last, const Op& op)
+{
+    return details::SimdReduce(first, last, op,
+        std::integral_constant<bool, details::SimdCombine<T, Op>::IsSupported>());
+}
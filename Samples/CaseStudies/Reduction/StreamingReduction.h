@@ -0,0 +1,297 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel streaming reduction of a file too large to hold in memory.
+//
+// ReduceFile reads the file in fixed size chunks into two buffers using 
+// overlapped, unbuffered I/O. While one chunk is being reduced on all cores 
+// the next chunk is read into the other buffer, so the reduction runs at 
+// close to disk bandwidth and only two chunks are ever held in memory.
+//
+// ReduceMappedFile maps the file one window at a time and reduces it in 
+// place, without any copies. While one window is reduced a background task 
+// touches the pages of the next window so they are read from disk in parallel.
+//
+// Errors from the file APIs are thrown as HRESULTs.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <ppl.h>
+
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+using namespace concurrency;
+
+namespace details
+{
+    inline void ThrowLastError()
+    {
+        throw HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    //  Closes a handle when it goes out of scope.
+
+    class ScopedHandle
+    {
+    private:
+        HANDLE m_handle;
+        ScopedHandle(const ScopedHandle&);
+        ScopedHandle& operator=(const ScopedHandle&);
+
+    public:
+        explicit ScopedHandle(HANDLE handle) : m_handle(handle) 
+        {
+            if ((m_handle == nullptr) || (m_handle == INVALID_HANDLE_VALUE))
+                ThrowLastError();
+        }
+        ~ScopedHandle() { CloseHandle(m_handle); }
+
+        inline HANDLE Get() const { return m_handle; }
+    };
+
+    //  Unmaps a view of a file when it goes out of scope.
+
+    class ScopedView
+    {
+    private:
+        const void* m_view;
+        ScopedView(const ScopedView&);
+        ScopedView& operator=(const ScopedView&);
+
+    public:
+        explicit ScopedView(const void* view = nullptr) : m_view(view) { }
+        ~ScopedView() { Reset(nullptr); }
+
+        inline const void* Get() const { return m_view; }
+
+        //  Unmap the current view, if any, and take ownership of view.
+        void Reset(const void* view)
+        {
+            if (m_view != nullptr)
+                UnmapViewOfFile(m_view);
+            m_view = view;
+        }
+
+        //  Give up ownership of the view without unmapping it.
+        const void* Release()
+        {
+            const void* view = m_view;
+            m_view = nullptr;
+            return view;
+        }
+    };
+
+    //  A chunk buffer and the overlapped read that fills it. Unbuffered reads require 
+    //  sector aligned memory, which VirtualAlloc provides. Any read still in flight 
+    //  is cancelled before the buffer is released.
+
+    class ReadBuffer
+    {
+    private:
+        HANDLE m_file;
+        ScopedHandle m_event;
+        void* m_data;
+        OVERLAPPED m_overlapped;
+        bool m_isPending;
+        bool m_isAtEnd;
+        ReadBuffer(const ReadBuffer&);
+        ReadBuffer& operator=(const ReadBuffer&);
+
+    public:
+        ReadBuffer(HANDLE file, size_t size) : 
+            m_file(file),
+            m_event(CreateEvent(nullptr, TRUE, FALSE, nullptr)),
+            m_data(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)),
+            m_isPending(false),
+            m_isAtEnd(false)
+        {
+            if (m_data == nullptr)
+                ThrowLastError();
+        }
+
+        ~ReadBuffer()
+        {
+            if (m_isPending)
+            {
+                DWORD bytesRead;
+                CancelIoEx(m_file, &m_overlapped);
+                GetOverlappedResult(m_file, &m_overlapped, &bytesRead, TRUE);
+            }
+            VirtualFree(m_data, 0, MEM_RELEASE);
+        }
+
+        inline const void* Data() const { return m_data; }
+
+        void BeginRead(unsigned long long offset, DWORD size)
+        {
+            ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+            m_overlapped.Offset = DWORD(offset & 0xFFFFFFFF);
+            m_overlapped.OffsetHigh = DWORD(offset >> 32);
+            m_overlapped.hEvent = m_event.Get();
+            m_isAtEnd = false;
+            if (!ReadFile(m_file, m_data, size, nullptr, &m_overlapped))
+            {
+                //  Reading at the end of the file may fail immediately rather than completing with no data.
+                const DWORD error = GetLastError();
+                if (error == ERROR_HANDLE_EOF)
+                {
+                    m_isAtEnd = true;
+                    return;
+                }
+                if (error != ERROR_IO_PENDING)
+                    ThrowLastError();
+            }
+            m_isPending = true;
+        }
+
+        //  Wait for the read to complete and return the number of bytes read.
+
+        DWORD EndRead()
+        {
+            if (m_isAtEnd)
+                return 0;
+
+            DWORD bytesRead = 0;
+            m_isPending = false;
+            if (!GetOverlappedResult(m_file, &m_overlapped, &bytesRead, TRUE) && (GetLastError() != ERROR_HANDLE_EOF))
+                ThrowLastError();
+            return bytesRead;
+        }
+    };
+}
+
+template <typename T, typename Op>
+class StreamingReduction
+{
+private:
+    Op m_op;
+    DWORD m_chunkBytes;
+
+public:
+    //  The chunk size is rounded to a multiple of 64KB, which is a multiple of the sector 
+    //  size required by unbuffered reads and the allocation granularity required for views.
+
+    StreamingReduction(DWORD chunkBytes = 16 * 1024 * 1024, const Op& op = Op()) : 
+        m_op(op), 
+        m_chunkBytes(std::max<DWORD>(1, chunkBytes / (64 * 1024)) * (64 * 1024))
+    {
+        static_assert(((64 * 1024) % sizeof(T)) == 0, "Element size must be a factor of 64KB.");
+    }
+
+    T ReduceFile(accelerator_view& view, const std::wstring& path, double& computeTime) const
+    {
+        details::ScopedHandle file(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 
+            FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+        details::ReadBuffer buffer0(file.Get(), m_chunkBytes);
+        details::ReadBuffer buffer1(file.Get(), m_chunkBytes);
+        details::ReadBuffer* buffers[2] = { &buffer0, &buffer1 };
+
+        T result = m_op.Identity();
+        computeTime = TimeFunc(view, [&]()
+        {
+            unsigned long long offset = 0;
+            buffers[0]->BeginRead(offset, m_chunkBytes);
+            for (int current = 0; ; current = 1 - current)
+            {
+                const DWORD bytesRead = buffers[current]->EndRead();
+                if (bytesRead == 0)
+                    break;
+
+                //  Start reading the next chunk before reducing this one. A short read means 
+                //  the end of the file has been reached.
+                offset += bytesRead;
+                if (bytesRead == m_chunkBytes)
+                    buffers[1 - current]->BeginRead(offset, m_chunkBytes);
+
+                const T* first = static_cast<const T*>(buffers[current]->Data());
+                result = m_op(result, ParallelSimdReduce(first, first + bytesRead / sizeof(T), m_op));
+
+                if (bytesRead < m_chunkBytes)
+                    break;
+            }
+        });
+        return result;
+    }
+
+    T ReduceMappedFile(accelerator_view& view, const std::wstring& path, double& computeTime) const
+    {
+        details::ScopedHandle file(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 
+            FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file.Get(), &size))
+            details::ThrowLastError();
+
+        T result = m_op.Identity();
+        if (size.QuadPart == 0)
+            return result;
+
+        details::ScopedHandle mapping(CreateFileMappingW(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        const unsigned long long fileBytes = size.QuadPart;
+        const unsigned long long windowBytes = m_chunkBytes;
+        const HANDLE mappingHandle = mapping.Get();
+
+        //  Map a window of the file, throwing if it can't be mapped.
+        auto mapWindow = [=](unsigned long long offset) -> const T*
+        {
+            const SIZE_T bytes = SIZE_T(std::min(windowBytes, fileBytes - offset));
+            void* p = MapViewOfFile(mappingHandle, FILE_MAP_READ, DWORD(offset >> 32), DWORD(offset & 0xFFFFFFFF), bytes);
+            if (p == nullptr)
+                details::ThrowLastError();
+            return static_cast<const T*>(p);
+        };
+
+        //  Read one byte from every page so the OS pages in the window ahead of the reduction.
+        auto touchWindow = [=](const T* window, unsigned long long offset)
+        {
+            const volatile char* bytes = reinterpret_cast<const volatile char*>(window);
+            const size_t length = size_t(std::min(windowBytes, fileBytes - offset));
+            for (size_t i = 0; i < length; i += 4096)
+                bytes[i];
+        };
+
+        //  The views are unmapped even if the reduction throws. next is declared before 
+        //  prefetch so the prefetch has finished with its window before it is unmapped.
+        computeTime = TimeFunc(view, [&]()
+        {
+            details::ScopedView current(mapWindow(0));
+            for (unsigned long long offset = 0; offset < fileBytes; offset += windowBytes)
+            {
+                const unsigned long long nextOffset = offset + windowBytes;
+                details::ScopedView next;
+                task_group prefetch;
+                if (nextOffset < fileBytes)
+                {
+                    next.Reset(mapWindow(nextOffset));
+                    const T* nextWindow = static_cast<const T*>(next.Get());
+                    prefetch.run([=]() { touchWindow(nextWindow, nextOffset); });
+                }
+
+                const T* window = static_cast<const T*>(current.Get());
+                const size_t elementCount = size_t(std::min(windowBytes, fileBytes - offset) / sizeof(T));
+                result = m_op(result, ParallelSimdReduce(window, window + elementCount, m_op));
+
+                prefetch.wait();
+                current.Reset(next.Release());
+            }
+        });
+        return result;
+    }
+};
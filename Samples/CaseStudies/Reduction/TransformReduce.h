@@ -0,0 +1,339 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// Fused transform and reduce on the CPU. Each element, or pair of elements
+// from two ranges, is transformed as it is loaded and combined straight
+// into the running result, so there is a single pass over the input and no
+// intermediate array. Uses the same chunking as ParallelSimdReduce.
+//
+// Transforms with an SSE2 equivalent are vectorized: sum of squares and dot
+// product of int, float and double elements, and counting int or float 
+// elements above or below a threshold. All others use an in-order scalar loop.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+#include <emmintrin.h>
+
+#include "ReduceOperators.h"
+#include "SimdReduce.h"
+#include "ParallelSimdReduction.h"
+
+//  Transforms with vectorized implementations.
+
+template <typename T>
+struct SquareTransform
+{
+    T operator()(const T& a) const { return a * a; }
+};
+
+template <typename T>
+struct MultiplyTransform
+{
+    T operator()(const T& a, const T& b) const { return a * b; }
+};
+
+template <typename T>
+struct LessThan
+{
+    T Threshold;
+    explicit LessThan(const T& threshold) : Threshold(threshold) { }
+    bool operator()(const T& a) const { return a < Threshold; }
+};
+
+template <typename T>
+struct GreaterThan
+{
+    T Threshold;
+    explicit GreaterThan(const T& threshold) : Threshold(threshold) { }
+    bool operator()(const T& a) const { return a > Threshold; }
+};
+
+//  Maps each element to one if it matches the predicate, so summing counts the matches.
+
+template <typename T, typename Pred>
+struct CountTransform
+{
+    Pred Predicate;
+    explicit CountTransform(const Pred& pred) : Predicate(pred) { }
+    long long operator()(const T& a) const { return Predicate(a) ? 1 : 0; }
+};
+
+namespace details
+{
+    struct SimdMultiply
+    {
+        __m128 operator()(__m128 a, __m128 b) const { return _mm_mul_ps(a, b); }
+        __m128d operator()(__m128d a, __m128d b) const { return _mm_mul_pd(a, b); }
+
+        //  SSE2 has no 32-bit multiply keeping the low half of each product, so multiply 
+        //  the even and odd lanes into 64-bit products and gather their low halves. These 
+        //  are the same for signed and unsigned operands, and wrap as the scalar loop does.
+        __m128i operator()(__m128i a, __m128i b) const
+        {
+            const __m128i even = _mm_mul_epu32(a, b);
+            const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), 
+                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+    };
+
+    //  Element types with a vectorized multiply and add.
+
+    template <typename T>
+    struct IsSimdMultiplySupported
+    {
+        enum { value = std::is_floating_point<T>::value || std::is_same<T, int>::value };
+    };
+
+    template <typename T>
+    T SimdDotProduct(const T* first1, const T* last1, const T* first2)
+    {
+        typedef SimdVector<T> Vec;
+        SimdCombine<T, SumOp<T>> add;
+        SimdMultiply mul;
+        const ptrdiff_t step = 4 * Vec::Width;
+
+        typename Vec::Type acc0 = Vec::Splat(T(0));
+        typename Vec::Type acc1 = acc0;
+        typename Vec::Type acc2 = acc0;
+        typename Vec::Type acc3 = acc0;
+
+        const T* p = first1;
+        const T* q = first2;
+        for (; (last1 - p) >= step; p += step, q += step)
+        {
+            acc0 = add(acc0, mul(Vec::Load(p), Vec::Load(q)));
+            acc1 = add(acc1, mul(Vec::Load(p + Vec::Width), Vec::Load(q + Vec::Width)));
+            acc2 = add(acc2, mul(Vec::Load(p + 2 * Vec::Width), Vec::Load(q + 2 * Vec::Width)));
+            acc3 = add(acc3, mul(Vec::Load(p + 3 * Vec::Width), Vec::Load(q + 3 * Vec::Width)));
+        }
+
+        T result = Vec::Horizontal(add(add(acc0, acc1), add(acc2, acc3)), add);
+        for (; p < last1; ++p, ++q)
+            result += *p * *q;
+        return result;
+    }
+
+    //  Comparison returning a mask of all ones in each matching lane. SSE2 only has 
+    //  32-bit integer comparisons, and double lanes would need 64-bit counters, so 
+    //  only int and float are vectorized.
+
+    template <typename T, typename Pred>
+    struct SimdPredicate
+    {
+        enum { IsSupported = false };
+    };
+
+    template <>
+    struct SimdPredicate<int, LessThan<int>>
+    {
+        enum { IsSupported = true };
+        __m128i m_threshold;
+        explicit SimdPredicate(const LessThan<int>& pred) : m_threshold(_mm_set1_epi32(pred.Threshold)) { }
+        __m128i operator()(__m128i v) const { return _mm_cmplt_epi32(v, m_threshold); }
+    };
+
+    template <>
+    struct SimdPredicate<int, GreaterThan<int>>
+    {
+        enum { IsSupported = true };
+        __m128i m_threshold;
+        explicit SimdPredicate(const GreaterThan<int>& pred) : m_threshold(_mm_set1_epi32(pred.Threshold)) { }
+        __m128i operator()(__m128i v) const { return _mm_cmpgt_epi32(v, m_threshold); }
+    };
+
+    template <>
+    struct SimdPredicate<float, LessThan<float>>
+    {
+        enum { IsSupported = true };
+        __m128 m_threshold;
+        explicit SimdPredicate(const LessThan<float>& pred) : m_threshold(_mm_set1_ps(pred.Threshold)) { }
+        __m128i operator()(__m128 v) const { return _mm_castps_si128(_mm_cmplt_ps(v, m_threshold)); }
+    };
+
+    template <>
+    struct SimdPredicate<float, GreaterThan<float>>
+    {
+        enum { IsSupported = true };
+        __m128 m_threshold;
+        explicit SimdPredicate(const GreaterThan<float>& pred) : m_threshold(_mm_set1_ps(pred.Threshold)) { }
+        __m128i operator()(__m128 v) const { return _mm_castps_si128(_mm_cmpgt_ps(v, m_threshold)); }
+    };
+
+    //  Subtracting the all ones mask adds one to each matching lane. Lanes are 32-bit
+    //  so a chunk must have fewer than 2^32 elements.
+
+    template <typename T, typename Pred>
+    long long SimdCountIf(const T* first, const T* last, const Pred& pred)
+    {
+        typedef SimdVector<T> Vec;
+        const SimdPredicate<T, Pred> test(pred);
+        const ptrdiff_t step = 2 * Vec::Width;
+
+        __m128i acc0 = _mm_setzero_si128();
+        __m128i acc1 = _mm_setzero_si128();
+
+        const T* p = first;
+        for (; (last - p) >= step; p += step)
+        {
+            acc0 = _mm_sub_epi32(acc0, test(Vec::Load(p)));
+            acc1 = _mm_sub_epi32(acc1, test(Vec::Load(p + Vec::Width)));
+        }
+
+        SimdCombine<int, SumOp<int>> add;
+        long long result = unsigned(SimdVector<int>::Horizontal(add(acc0, acc1), add));
+        for (; p < last; ++p)
+            result += pred(*p) ? 1 : 0;
+        return result;
+    }
+
+    //  Vectorized (element type, transform, operator) triples. All others are not 
+    //  supported and use the scalar loop.
+
+    template <typename T, typename Transform, typename Op>
+    struct SimdTransformReduce
+    {
+        enum { IsSupported = false };
+    };
+
+    template <typename T>
+    struct SimdTransformReduce<T, SquareTransform<T>, SumOp<T>>
+    {
+        enum { IsSupported = IsSimdMultiplySupported<T>::value };
+
+        //  Loading the same address twice costs nothing extra as the second load hits the cache.
+        static T Reduce(const T* first, const T* last, const SquareTransform<T>&, const SumOp<T>&)
+        {
+            return SimdDotProduct(first, last, first);
+        }
+    };
+
+    template <typename T, typename Pred>
+    struct SimdTransformReduce<T, CountTransform<T, Pred>, SumOp<long long>>
+    {
+        enum { IsSupported = SimdPredicate<T, Pred>::IsSupported };
+
+        static long long Reduce(const T* first, const T* last, const CountTransform<T, Pred>& transform, const SumOp<long long>&)
+        {
+            return SimdCountIf(first, last, transform.Predicate);
+        }
+    };
+
+    template <typename T, typename Transform, typename Op>
+    struct SimdTransformReduce2
+    {
+        enum { IsSupported = false };
+    };
+
+    template <typename T>
+    struct SimdTransformReduce2<T, MultiplyTransform<T>, SumOp<T>>
+    {
+        enum { IsSupported = IsSimdMultiplySupported<T>::value };
+
+        static T Reduce(const T* first1, const T* last1, const T* first2, const MultiplyTransform<T>&, const SumOp<T>&)
+        {
+            return SimdDotProduct(first1, last1, first2);
+        }
+    };
+
+    //  Scalar fallbacks. Keep the elements in order so the operator only needs to be associative.
+
+    template <typename T, typename Transform, typename Op>
+    inline auto TransformReduce(const T* first, const T* last, const Transform& transform, const Op& op, std::false_type)
+        -> decltype(op.Identity())
+    {
+        decltype(op.Identity()) result = op.Identity();
+        for (const T* p = first; p < last; ++p)
+            result = op(result, transform(*p));
+        return result;
+    }
+
+    template <typename T, typename Transform, typename Op>
+    inline auto TransformReduce(const T* first, const T* last, const Transform& transform, const Op& op, std::true_type)
+        -> decltype(op.Identity())
+    {
+        return SimdTransformReduce<T, Transform, Op>::Reduce(first, last, transform, op);
+    }
+
+    template <typename T1, typename T2, typename Transform, typename Op>
+    inline auto TransformReduce(const T1* first1, const T1* last1, const T2* first2, const Transform& transform, const Op& op, std::false_type)
+        -> decltype(op.Identity())
+    {
+        decltype(op.Identity()) result = op.Identity();
+        for (const T1* p = first1; p < last1; ++p, ++first2)
+            result = op(result, transform(*p, *first2));
+        return result;
+    }
+
+    template <typename T, typename Transform, typename Op>
+    inline auto TransformReduce(const T* first1, const T* last1, const T* first2, const Transform& transform, const Op& op, std::true_type)
+        -> decltype(op.Identity())
+    {
+        return SimdTransformReduce2<T, Transform, Op>::Reduce(first1, last1, first2, transform, op);
+    }
+}
+
+//  Reduce transform(x) over [first, last) with op. The result has the type of op.Identity().
+
+template <typename T, typename Transform, typename Op>
+auto ParallelTransformReduce(const T* first, const T* last, const Transform& transform, const Op& op)
+    -> decltype(op.Identity())
+{
+    typedef std::integral_constant<bool, details::SimdTransformReduce<T, Transform, Op>::IsSupported> IsSupported;
+    return ParallelReduceChunks(first, last, op.Identity(), 
+        [=](const T* chunkFirst, const T* chunkLast) 
+        { 
+            return details::TransformReduce(chunkFirst, chunkLast, transform, op, IsSupported()); 
+        }, op);
+}
+
+//  Reduce transform(x, y) over pairs of elements from [first1, last1) and the range 
+//  of the same length starting at first2.
+
+template <typename T1, typename T2, typename Transform, typename Op>
+auto ParallelTransformReduce(const T1* first1, const T1* last1, const T2* first2, const Transform& transform, const Op& op)
+    -> decltype(op.Identity())
+{
+    typedef std::integral_constant<bool, std::is_same<T1, T2>::value && 
+        details::SimdTransformReduce2<T1, Transform, Op>::IsSupported> IsSupported;
+    return ParallelReduceChunks(first1, last1, op.Identity(), 
+        [=](const T1* chunkFirst, const T1* chunkLast) 
+        { 
+            return details::TransformReduce(chunkFirst, chunkLast, first2 + (chunkFirst - first1), transform, op, IsSupported()); 
+        }, op);
+}
+
+template <typename T>
+T ParallelDotProduct(const T* first1, const T* last1, const T* first2)
+{
+    return ParallelTransformReduce(first1, last1, first2, MultiplyTransform<T>(), SumOp<T>());
+}
+
+template <typename T>
+T ParallelL2Norm(const T* first, const T* last)
+{
+    return std::sqrt(ParallelTransformReduce(first, last, SquareTransform<T>(), SumOp<T>()));
+}
+
+template <typename T, typename Pred>
+long long ParallelCountIf(const T* first, const T* last, const Pred& pred)
+{
+    return ParallelTransformReduce(first, last, CountTransform<T, Pred>(pred), SumOp<long long>());
+}
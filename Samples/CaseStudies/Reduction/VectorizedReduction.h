@@ -0,0 +1,128 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel and vectorized implementation.
+//
+// The input is divided into chunks small enough to fit in the L2 cache. One
+// worker per core repeatedly claims the next chunk and sums it using AVX2 
+// with several independent accumulators, so that the latency of each add is 
+// hidden. Each worker keeps its own partial sum and these are added together
+// at the end. On CPUs without AVX2 the chunks are summed with SSE2 instead.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <numeric>
+#include <atomic>
+#include <intrin.h>
+#include <immintrin.h>
+#include <ppl.h>
+
+#include "IReduce.h"
+#include "SimdReduce.h"
+#include "Timer.h"
+
+using namespace concurrency;
+
+namespace details
+{
+    //  AVX2 requires support from both the CPU and the OS, which must save the YMM registers.
+
+    inline bool IsAvx2Supported()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        __cpuid(info, 1);
+        const bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+        const bool hasAvx = (info[2] & (1 << 28)) != 0;
+        if (!hasOsxsave || !hasAvx || ((_xgetbv(0) & 0x6) != 0x6))
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+
+    inline int SumAvx2(const int* first, const int* last)
+    {
+        const ptrdiff_t step = 4 * 8;
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256();
+        __m256i acc3 = _mm256_setzero_si256();
+
+        const int* p = first;
+        for (; (last - p) >= step; p += step)
+        {
+            acc0 = _mm256_add_epi32(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+            acc1 = _mm256_add_epi32(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+            acc2 = _mm256_add_epi32(acc2, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 16)));
+            acc3 = _mm256_add_epi32(acc3, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 24)));
+        }
+
+        //  Fold the four accumulators and the two halves of the result into one SSE register.
+        const __m256i acc = _mm256_add_epi32(_mm256_add_epi32(acc0, acc1), _mm256_add_epi32(acc2, acc3));
+        const __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        _mm256_zeroupper();
+
+        return SimdVector<int>::Horizontal(sum, SimdCombine<int, SumOp<int>>()) + 
+            SimdReduce(p, last, SumOp<int>());
+    }
+}
+
+class VectorizedReduction : public IReduce
+{
+private:
+    bool m_useAvx2;
+
+public:
+    VectorizedReduction() : m_useAvx2(details::IsAvx2Supported()) { }
+
+    int Reduce(accelerator_view& view, const std::vector<int>& source, double& computeTime) const
+    {
+        //  32K elements is 128KB, which fits comfortably in the L2 cache of a single core.
+        const int chunkSize = 32 * 1024;
+        const int elementCount = static_cast<int>(source.size());
+        const int chunkCount = (elementCount + chunkSize - 1) / chunkSize;
+        const int workerCount = std::min<int>(GetProcessorCount(), chunkCount);
+        const int* data = source.data();
+        const bool useAvx2 = m_useAvx2;
+
+        int total = 0;
+        computeTime = TimeFunc(view, [&]()
+        {
+            std::atomic<int> nextChunk(0);
+            std::vector<int> partials(workerCount, 0);
+            parallel_for(0, workerCount, [&](int worker)
+            {
+                int partial = 0;
+                for (int chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+                {
+                    const int* first = data + chunk * chunkSize;
+                    const int* last = data + std::min(elementCount, (chunk + 1) * chunkSize);
+                    partial += useAvx2 ? details::SumAvx2(first, last) : SimdReduce(first, last, SumOp<int>());
+                }
+                partials[worker] = partial;
+            });
+            total = std::accumulate(partials.cbegin(), partials.cend(), 0);
+        });
+        return total;
+    }
+};
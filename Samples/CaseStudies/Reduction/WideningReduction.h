@@ -0,0 +1,100 @@
+//===============================================================================
+//
+// Microsoft Press
+// C++ AMP: Accelerated Massive Parallelism with Microsoft Visual C++
+//
+//===============================================================================
+// Copyright (c) 2012-2013 Ade Miller & Kate Gregory.  All rights reserved.
+// This code released under the terms of the 
+// Microsoft Public License (Ms-PL), http://ampbook.codeplex.com/license.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//===============================================================================
+
+//----------------------------------------------------------------------------
+// CPU parallel summation accumulating into a wider type. Each element is 
+// widened in registers as it is loaded: int to long long, which cannot 
+// overflow for fewer than 2^32 elements, and float to double, which keeps
+// roughly 29 more bits of the running total.
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <emmintrin.h>
+
+#include "IAccurateReduce.h"
+#include "ParallelSimdReduction.h"
+#include "Timer.h"
+
+namespace details
+{
+    inline long long WideningSum(const int* first, const int* last)
+    {
+        __m128i acc0 = _mm_setzero_si128();
+        __m128i acc1 = _mm_setzero_si128();
+
+        const int* p = first;
+        for (; (last - p) >= 4; p += 4)
+        {
+            //  Sign extend four ints into two pairs of long longs.
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i sign = _mm_srai_epi32(v, 31);
+            acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, sign));
+            acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, sign));
+        }
+
+        SimdCombine<long long, SumOp<long long>> combine;
+        long long result = SimdVector<long long>::Horizontal(combine(acc0, acc1), combine);
+        for (; p < last; ++p)
+            result += *p;
+        return result;
+    }
+
+    inline double WideningSum(const float* first, const float* last)
+    {
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+        __m128d acc2 = _mm_setzero_pd();
+        __m128d acc3 = _mm_setzero_pd();
+
+        const float* p = first;
+        for (; (last - p) >= 8; p += 8)
+        {
+            //  Convert the low and high halves of each register of four floats to doubles.
+            const __m128 v0 = _mm_loadu_ps(p);
+            const __m128 v1 = _mm_loadu_ps(p + 4);
+            acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(v0));
+            acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(v0, v0)));
+            acc2 = _mm_add_pd(acc2, _mm_cvtps_pd(v1));
+            acc3 = _mm_add_pd(acc3, _mm_cvtps_pd(_mm_movehl_ps(v1, v1)));
+        }
+
+        SimdCombine<double, SumOp<double>> combine;
+        double result = SimdVector<double>::Horizontal(combine(combine(acc0, acc1), combine(acc2, acc3)), combine);
+        for (; p < last; ++p)
+            result += *p;
+        return result;
+    }
+}
+
+template <typename T, typename TResult>
+class WideningReduction : public IAccurateReduce<T, TResult>
+{
+public:
+    TResult Reduce(accelerator_view& view, const std::vector<T>& source, double& computeTime) const
+    {
+        TResult total = TResult(0);
+        computeTime = TimeFunc(view, [&]()
+        {
+            if (!source.empty())
+                total = ParallelReduceChunks(source.data(), source.data() + source.size(), TResult(0), 
+                    [](const T* first, const T* last) { return details::WideningSum(first, last); }, 
+                    SumOp<TResult>());
+        });
+        return total;
+    }
+};